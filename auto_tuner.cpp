@@ -0,0 +1,237 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <zlib.h>
+#include "auto_tuner.h"
+#include "complementary.h"
+#include "vector_sequence.h"
+
+namespace
+{
+	// Reads of the probe of each FASTQ file
+	const unsigned int PROBE_READS = 20000;
+
+	// Seconds of scanning a block of reads by the inner threads of a file
+	const double BLOCK_SECONDS = 2.0;
+
+	// Smallest -r chosen
+	const u_int64_t MIN_READ_LINES = 100000;
+}
+
+/**
+ * @brief Construct a new Auto Tuner:: Auto Tuner object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ */
+AutoTuner::AutoTuner(Options *options, BitwiseOperation *bitwiseOperation)
+{
+	this->options = options;
+	this->bitwiseOperation = bitwiseOperation;
+}
+
+/**
+ * @brief Destroy the Auto Tuner:: Auto Tuner object
+ *
+ */
+AutoTuner::~AutoTuner()
+{
+}
+
+/**
+ * @brief Probe the FASTQ files and set the OpenMP outer/inner parallel and -r.
+ *
+ * The number of threads is kept; -r is only lowered.
+ */
+void AutoTuner::tune()
+{
+	const unsigned int kmer = this->options->kmer;
+
+	// K-mer index of the first k (both strands, circular), or the one of the vector index file
+	VectorSequence vectorSequence(this->options, this->bitwiseOperation);
+	const VectorIndex *vectorIndex = this->bitwiseOperation->get_vectorIndex();
+	Complementary complementary;
+	MerIndex merIndex(kmer);
+	if (vectorIndex)
+	{
+		vectorIndex->attach(merIndex);
+	}
+	else
+	{
+		for (const auto &record : vectorSequence.read_sequences())
+		{
+			std::string sequence = record.second;
+			const size_t vector_length = sequence.length();
+			if (vector_length < kmer)
+			{
+				continue;
+			}
+			sequence += sequence.substr(0, kmer - 1);
+			transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
+			for (size_t i = 0; i < vector_length; i++)
+			{
+				const std::string mer = sequence.substr(i, kmer);
+				merIndex.add(mer);
+				merIndex.add(complementary.mer(mer));
+			}
+		}
+	}
+
+	std::vector<std::string> fastqFiles = this->options->mutant_files;
+	fastqFiles.insert(fastqFiles.end(), this->options->wildType_files.begin(), this->options->wildType_files.end());
+	std::vector<Probe> probes;
+	double parse = 0.0, scan = 0.0, reads = 0.0;
+	for (const std::string &fastqFile : fastqFiles)
+	{
+		const Probe probe = this->probe(fastqFile, merIndex);
+		if (probe.reads > 0.0)
+		{
+			probes.push_back(probe);
+			parse += probe.parse * probe.reads;
+			scan += probe.scan * probe.reads;
+			reads += probe.reads;
+		}
+	}
+	if (probes.empty())
+	{
+		return;
+	}
+
+	// Split of the threads with the shortest predicted time (fewer files at once on a tie)
+	const unsigned int threads = this->options->outer_parallel * this->options->inner_parallel;
+	unsigned int best = 1;
+	std::ostringstream candidates;
+	candidates << std::fixed << std::setprecision(1);
+	for (unsigned int outer = 1; outer <= std::min((unsigned int)probes.size(), threads); outer++)
+	{
+		const unsigned int inner = std::max(threads / outer, 1u);
+		const double seconds = predict(probes, outer, inner);
+		candidates << (outer > 1 ? ", " : "") << outer << "x" << inner << " " << seconds << " s";
+		if (seconds < predict(probes, best, std::max(threads / best, 1u)) * 0.99)
+		{
+			best = outer;
+		}
+	}
+	this->options->outer_parallel = best;
+	this->options->inner_parallel = std::max(threads / best, 1u);
+
+	// Blocks of about two seconds of scanning
+	const double scanPerRead = scan / reads;
+	const u_int64_t readLines = BLOCK_SECONDS * this->options->inner_parallel / std::max(scanPerRead, 1e-9);
+	this->options->fastq_read_lines = std::min(std::max(readLines, MIN_READ_LINES),
+											   (u_int64_t)this->options->fastq_read_lines);
+
+	std::cout << std::fixed << std::setprecision(2)
+			  << "Auto-tune probe (us/read)     = inflate and parse " << parse / reads * 1e6
+			  << ", scan " << scanPerRead * 1e6 << " (first " << PROBE_READS << " reads of each file)" << std::endl;
+	std::cout << "Auto-tune outer x inner       = " << candidates.str() << " (predicted)" << std::endl;
+	std::cout << "  OpenMP outer parallel       = " << this->options->outer_parallel << std::endl;
+	std::cout << "  OpenMP inner parallel       = " << this->options->inner_parallel << std::endl;
+	std::cout << "  Reads in memory (-r)        = " << this->options->fastq_read_lines << std::endl;
+	std::cout << std::defaultfloat << std::flush;
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Measure a FASTQ file with its first reads.
+ *
+ * @param fastqFile FASTQ file
+ * @param merIndex K-mer index of the vector
+ * @return Measures (no reads if the file could not be read)
+ */
+AutoTuner::Probe AutoTuner::probe(const std::string &fastqFile, const MerIndex &merIndex) const
+{
+	Probe probe;
+	const gzFile file = gzopen(fastqFile.c_str(), "rb");
+	if (!file)
+	{
+		return probe;
+	}
+
+	// Inflate and parse as the reading of the file does
+	const unsigned int max_buff = this->options->max_read_length + 2;
+	char buff[max_buff];
+	std::string aLine[4];
+	unsigned int nLine = 0;
+	std::vector<std::string> fastqData;
+	double start = Metrics::wall_time();
+	while (fastqData.size() < PROBE_READS && gzgets(file, buff, max_buff) != Z_NULL)
+	{
+		aLine[nLine++] = std::string(buff);
+		if (nLine == 4)
+		{
+			nLine = 0;
+			if (aLine[1].length() > this->options->kmer)
+			{
+				aLine[1].pop_back();
+				fastqData.push_back(aLine[1]);
+			}
+		}
+	}
+	const double parse = Metrics::wall_time() - start;
+	const bool complete = gzgets(file, buff, max_buff) == Z_NULL;
+	const u_int64_t offset = gzoffset(file);
+	gzclose(file);
+	if (fastqData.empty())
+	{
+		return probe;
+	}
+
+	// Scan on one thread
+	std::vector<unsigned int> counter(merIndex.size(), 0);
+	start = Metrics::wall_time();
+	for (const std::string &read : fastqData)
+	{
+		merIndex.scan(read, [&counter](const size_t, const u_int32_t id)
+					  { counter[id]++; });
+	}
+	const double scan = Metrics::wall_time() - start;
+
+	const double records = fastqData.size();
+	probe.reads = complete ? records : records * Metrics::file_size(fastqFile) / std::max(offset, (u_int64_t)1);
+	probe.reads *= this->options->fraction / std::max(this->options->shards, 1u);
+	probe.parse = parse / records;
+	probe.scan = scan / records;
+	return probe;
+}
+
+/**
+ * @brief Predicted seconds of reading the files.
+ *
+ * The files are given to the outer threads in contiguous blocks, as the
+ * static schedule of the outer loop does; the threads cannot run faster
+ * than the cores share the work.
+ *
+ * @param probes Measures of the files (in the order of the loop)
+ * @param outer Files read at once
+ * @param inner Threads of a file
+ * @return Seconds of the slowest outer thread
+ */
+double AutoTuner::predict(const std::vector<Probe> &probes, const unsigned int outer, const unsigned int inner)
+{
+	const size_t size = probes.size() / outer;
+	const size_t extra = probes.size() % outer;
+	const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	double work = 0.0;
+	double slowest = 0.0;
+	size_t i = 0;
+	for (unsigned int t = 0; t < outer; t++)
+	{
+		double seconds = 0.0;
+		for (size_t n = 0; n < size + (t < extra ? 1 : 0); n++, i++)
+		{
+			seconds += probes[i].reads * (probes[i].parse + probes[i].scan / inner);
+			work += probes[i].reads * (probes[i].parse + probes[i].scan);
+		}
+		slowest = std::max(slowest, seconds);
+	}
+	return std::max(slowest, work / cores);
+}
@@ -0,0 +1,96 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef AUTO_TUNER_H_
+#define AUTO_TUNER_H_
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "bitwise_operation.h"
+
+/**
+ * @brief Choice of the OpenMP outer/inner parallel and -r from a calibration probe (--auto-tune).
+ *
+ * The first reads of each FASTQ file are read and scanned on one thread to
+ * measure the time of inflating and parsing a read (done by the one thread
+ * reading the file) and of scanning it (shared by the inner threads). The
+ * split of the threads into files read at once and threads per file with
+ * the shortest predicted run time is taken; -r is set to the reads the
+ * inner threads of a file scan in about two seconds.
+ */
+class AutoTuner
+{
+public:
+	/**
+	 * @brief Construct a new Auto Tuner object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 */
+	AutoTuner(Options *options, BitwiseOperation *bitwiseOperation);
+
+	/**
+	 * @brief Destroy the Auto Tuner object
+	 *
+	 */
+	virtual ~AutoTuner();
+
+	/**
+	 * @brief Probe the FASTQ files and set the OpenMP outer/inner parallel and -r.
+	 *
+	 */
+	void tune();
+
+private:
+	/**
+	 * @brief Measures of a FASTQ file
+	 *
+	 */
+	struct Probe
+	{
+		// Estimated reads of the file
+		double reads = 0.0;
+
+		// Seconds per read to inflate and parse, and to scan (one thread)
+		double parse = 0.0;
+		double scan = 0.0;
+	};
+
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Bitwise operation.
+	 *
+	 */
+	BitwiseOperation *bitwiseOperation;
+
+	/**
+	 * @brief Measure a FASTQ file with its first reads.
+	 *
+	 * @param fastqFile FASTQ file
+	 * @param merIndex K-mer index of the vector
+	 * @return Measures (no reads if the file could not be read)
+	 */
+	Probe probe(const std::string &fastqFile, const MerIndex &merIndex) const;
+
+	/**
+	 * @brief Predicted seconds of reading the files.
+	 *
+	 * The files are given to the outer threads in contiguous blocks, as the
+	 * static schedule of the outer loop does; the threads cannot run faster
+	 * than the cores share the work.
+	 *
+	 * @param probes Measures of the files (in the order of the loop)
+	 * @param outer Files read at once
+	 * @param inner Threads of a file
+	 * @return Seconds of the slowest outer thread
+	 */
+	static double predict(const std::vector<Probe> &probes, const unsigned int outer, const unsigned int inner);
+};
+#endif /* AUTO_TUNER_H_ */
@@ -0,0 +1,503 @@
+//============================================================================//
+// Name        : corpus
+// Author      : NARO
+// Copyright   : (c) 2018 National Agriculture and Food Research Organization (NARO)
+// Description : Synthetic benchmark corpus for GenEditScan (paired FASTQ.gz
+//               of a mutant line with vector inserts and of its wild type)
+//============================================================================//
+#include <getopt.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * @brief Settings of the corpus.
+ *
+ */
+struct Settings
+{
+	// Host genome (fasta, empty: random)
+	std::string host_file;
+
+	// Length of a random host genome
+	u_int64_t host_length = 2000000;
+
+	// Vector (fasta, empty: random)
+	std::string vector_file;
+
+	// Length of a random vector
+	unsigned int vector_length = 6000;
+
+	// Inserted fragment of the vector (0: whole vector)
+	unsigned int fragment_length = 0;
+
+	// Copies of the insert per haploid genome (0: no insert)
+	double copies = 1.0;
+
+	// Depth of each sample
+	double depth = 10.0;
+
+	// Read length
+	unsigned int read_length = 150;
+
+	// Mean and standard deviation of the insert size of the pairs
+	double insert_mean = 350.0;
+	double insert_sd = 30.0;
+
+	// Substitution error rate per base
+	double error_rate = 0.001;
+
+	// Number of file pairs per sample
+	unsigned int files = 1;
+
+	// Random seed
+	u_int64_t seed = 1;
+
+	// Output prefix
+	std::string out_prefix = "corpus";
+};
+
+/**
+ * @brief Random numbers of the corpus.
+ *
+ * Drawn from the raw output of mt19937_64 (not the library distributions),
+ * so that a seed gives the same corpus with any standard library.
+ */
+class Random
+{
+public:
+	Random(const u_int64_t seed) : engine(seed)
+	{
+	}
+
+	// Uniform integer in [0, n)
+	u_int64_t below(const u_int64_t n)
+	{
+		return this->engine() % n;
+	}
+
+	// Uniform real in [0, 1)
+	double uniform()
+	{
+		return (this->engine() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	// Normal (Box-Muller)
+	double normal(const double mean, const double sd)
+	{
+		const double u1 = 1.0 - this->uniform();
+		const double u2 = this->uniform();
+		return mean + sd * std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+	}
+
+	// Random sequence
+	std::string sequence(const u_int64_t length)
+	{
+		static const char BASES[] = "ACGT";
+		std::string seq(length, 'A');
+		for (u_int64_t i = 0; i < length; i++)
+		{
+			seq[i] = BASES[this->below(4)];
+		}
+		return seq;
+	}
+
+private:
+	std::mt19937_64 engine;
+};
+
+/**
+ * @brief Inserted fragment of the vector.
+ *
+ */
+struct Insert
+{
+	// Position in the host genome
+	u_int64_t position;
+
+	// Fragment of the vector
+	unsigned int start;
+	unsigned int length;
+
+	// Reverse complement of the fragment
+	bool reverse;
+};
+
+/**
+ * @brief Reverse complement.
+ *
+ * @param seq Sequence
+ * @return Reverse complement
+ */
+std::string reverse_complement(const std::string &seq)
+{
+	std::string rc(seq.rbegin(), seq.rend());
+	for (char &c : rc)
+	{
+		switch (c)
+		{
+		case 'A':
+			c = 'T';
+			break;
+		case 'C':
+			c = 'G';
+			break;
+		case 'G':
+			c = 'C';
+			break;
+		case 'T':
+			c = 'A';
+			break;
+		default:
+			c = 'N';
+		}
+	}
+	return rc;
+}
+
+/**
+ * @brief Read the records of a fasta file joined into one sequence.
+ *
+ * @param file Fasta file
+ * @return Sequence (upper case)
+ */
+std::string read_fasta(const std::string &file)
+{
+	std::ifstream ifs(file);
+	if (!ifs)
+	{
+		std::cerr << "[Error] Could not open (" << file << ")." << std::endl;
+		std::exit(1);
+	}
+	std::string line, seq;
+	while (std::getline(ifs, line))
+	{
+		if (line.empty() || line[0] == '>')
+		{
+			continue;
+		}
+		for (char c : line)
+		{
+			if (!std::isspace((unsigned char)c))
+			{
+				seq += std::toupper((unsigned char)c);
+			}
+		}
+	}
+	return seq;
+}
+
+/**
+ * @brief Write a fasta file.
+ *
+ * @param file Fasta file
+ * @param name Record name
+ * @param seq Sequence
+ */
+void write_fasta(const std::string &file, const std::string &name, const std::string &seq)
+{
+	std::ofstream ofs(file);
+	ofs << ">" << name << "\n";
+	for (size_t i = 0; i < seq.length(); i += 60)
+	{
+		ofs << seq.substr(i, 60) << "\n";
+	}
+	if (!ofs)
+	{
+		std::cerr << "[Error] Could not write (" << file << ")." << std::endl;
+		std::exit(1);
+	}
+}
+
+/**
+ * @brief Write the reads of one sample.
+ *
+ * Pairs are drawn from the haplotypes by weight: fragment of a normal insert
+ * size on a random strand, R1 from its start and R2 (reverse complement)
+ * from its end, each base substituted at the error rate.
+ *
+ * @param settings Settings of the corpus
+ * @param random Random numbers
+ * @param haplotypes Sequences to read
+ * @param weights Share of the reads from each haplotype
+ * @param genome_length Length of the haploid genome (for the depth)
+ * @param sample Sample name in the file names
+ * @return Number of pairs
+ */
+u_int64_t write_sample(const Settings &settings, Random &random,
+					   const std::vector<std::string> &haplotypes, const std::vector<double> &weights,
+					   const u_int64_t genome_length, const std::string &sample)
+{
+	static const char BASES[] = "ACGT";
+	const unsigned int length = settings.read_length;
+	const u_int64_t pairs = (u_int64_t)(settings.depth * genome_length / (2.0 * length));
+	const u_int64_t pairs_per_file = (pairs + settings.files - 1) / settings.files;
+	const std::string quality(length, 'I');
+
+	u_int64_t pair = 0;
+	for (unsigned int f = 1; f <= settings.files; f++)
+	{
+		std::string files[2];
+		gzFile out[2];
+		for (int mate = 0; mate < 2; mate++)
+		{
+			files[mate] = settings.out_prefix + "." + sample +
+						  (settings.files > 1 ? "_" + std::to_string(f) : "") + "_R" + std::to_string(mate + 1) + ".fastq.gz";
+			out[mate] = gzopen(files[mate].c_str(), "wb6");
+			if (!out[mate])
+			{
+				std::cerr << "[Error] Could not open (" << files[mate] << ")." << std::endl;
+				std::exit(1);
+			}
+		}
+
+		for (u_int64_t end = std::min(pairs, pair + pairs_per_file); pair < end; pair++)
+		{
+			// Haplotype
+			double r = random.uniform();
+			size_t h = 0;
+			while (h + 1 < haplotypes.size() && r >= weights[h])
+			{
+				r -= weights[h++];
+			}
+			const std::string &haplotype = haplotypes[h];
+
+			// Fragment
+			const u_int64_t size = std::max((u_int64_t)length, (u_int64_t)std::llround(
+																	  std::max(0.0, random.normal(settings.insert_mean, settings.insert_sd))));
+			const u_int64_t start = random.below(haplotype.length() - size + 1);
+			std::string fragment = haplotype.substr(start, size);
+			if (random.below(2) == 1)
+			{
+				fragment = reverse_complement(fragment);
+			}
+
+			std::string reads[2] = {fragment.substr(0, length), reverse_complement(fragment).substr(0, length)};
+			for (int mate = 0; mate < 2; mate++)
+			{
+				for (char &c : reads[mate])
+				{
+					if (random.uniform() < settings.error_rate)
+					{
+						c = BASES[(std::strchr(BASES, c) ? std::strchr(BASES, c) - BASES + 1 + random.below(3) : random.below(4)) % 4];
+					}
+				}
+				const std::string record = "@" + sample + "." + std::to_string(pair) + "/" + std::to_string(mate + 1) +
+										   "\n" + reads[mate] + "\n+\n" + quality.substr(0, reads[mate].length()) + "\n";
+				if (gzwrite(out[mate], record.data(), record.length()) != (int)record.length())
+				{
+					std::cerr << "[Error] Could not write (" << files[mate] << ")." << std::endl;
+					std::exit(1);
+				}
+			}
+		}
+
+		for (int mate = 0; mate < 2; mate++)
+		{
+			if (gzclose(out[mate]) != Z_OK)
+			{
+				std::cerr << "[Error] Could not write (" << files[mate] << ")." << std::endl;
+				std::exit(1);
+			}
+			std::cout << files[mate] << std::endl;
+		}
+	}
+	return pairs;
+}
+
+/**
+ * @brief Print help menu.
+ *
+ * @param settings Default settings
+ * @param execute Executable program name
+ */
+void help(const Settings &settings, const std::string &execute)
+{
+	std::cerr << "Usage : " << execute << " [options]\n";
+	std::cerr << "-g | --host     : Host genome (fasta; random if not given)\n";
+	std::cerr << "-G | --host-length : Length of a random host genome (" << settings.host_length << ")\n";
+	std::cerr << "-v | --vector   : Vector (fasta; random if not given)\n";
+	std::cerr << "-V | --vector-length : Length of a random vector (" << settings.vector_length << ")\n";
+	std::cerr << "-f | --fragment : Length of the inserted fragment of the vector (whole vector)\n";
+	std::cerr << "-c | --copies   : Copies of the insert per haploid genome; 0.5 for a hemizygous insert,\n";
+	std::cerr << "                  0 for no insert (" << settings.copies << ")\n";
+	std::cerr << "-d | --depth    : Depth of each sample (" << settings.depth << ")\n";
+	std::cerr << "-l | --length   : Read length (" << settings.read_length << ")\n";
+	std::cerr << "-i | --insert   : Mean insert size of the pairs (" << settings.insert_mean << ")\n";
+	std::cerr << "-e | --error    : Substitution error rate per base (" << settings.error_rate << ")\n";
+	std::cerr << "-n | --files    : Number of file pairs per sample (" << settings.files << ")\n";
+	std::cerr << "-s | --seed     : Random seed (" << settings.seed << ")\n";
+	std::cerr << "-o | --out      : Output prefix (" << settings.out_prefix << ")\n";
+	std::cerr << "-h | --help     : Print this menu\n";
+}
+
+/**
+ * @brief Main function.
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return Exit code
+ */
+int main(int argc, char *argv[])
+{
+	Settings settings;
+	const struct option long_options[] = {
+		{"host", required_argument, NULL, 'g'},
+		{"host-length", required_argument, NULL, 'G'},
+		{"vector", required_argument, NULL, 'v'},
+		{"vector-length", required_argument, NULL, 'V'},
+		{"fragment", required_argument, NULL, 'f'},
+		{"copies", required_argument, NULL, 'c'},
+		{"depth", required_argument, NULL, 'd'},
+		{"length", required_argument, NULL, 'l'},
+		{"insert", required_argument, NULL, 'i'},
+		{"error", required_argument, NULL, 'e'},
+		{"files", required_argument, NULL, 'n'},
+		{"seed", required_argument, NULL, 's'},
+		{"out", required_argument, NULL, 'o'},
+		{"help", no_argument, NULL, 'h'},
+		{0, 0, 0, 0}};
+
+	try
+	{
+		int c;
+		int long_index;
+		while ((c = getopt_long(argc, argv, "g:G:v:V:f:c:d:l:i:e:n:s:o:h", long_options, &long_index)) != -1)
+		{
+			switch (c)
+			{
+			case 'g':
+				settings.host_file = optarg;
+				break;
+			case 'G':
+				settings.host_length = std::stoull(optarg);
+				break;
+			case 'v':
+				settings.vector_file = optarg;
+				break;
+			case 'V':
+				settings.vector_length = std::stoi(optarg);
+				break;
+			case 'f':
+				settings.fragment_length = std::stoi(optarg);
+				break;
+			case 'c':
+				settings.copies = std::stod(optarg);
+				break;
+			case 'd':
+				settings.depth = std::stod(optarg);
+				break;
+			case 'l':
+				settings.read_length = std::stoi(optarg);
+				break;
+			case 'i':
+				settings.insert_mean = std::stod(optarg);
+				break;
+			case 'e':
+				settings.error_rate = std::stod(optarg);
+				break;
+			case 'n':
+				settings.files = std::max(std::stoi(optarg), 1);
+				break;
+			case 's':
+				settings.seed = std::stoull(optarg);
+				break;
+			case 'o':
+				settings.out_prefix = optarg;
+				break;
+			default:
+				help(settings, argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "[Error] " << argv[0] << ": " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Random random(settings.seed);
+
+	// Host genome and vector
+	const std::string host = settings.host_file.empty() ? random.sequence(settings.host_length)
+														: read_fasta(settings.host_file);
+	std::string vector = settings.vector_file.empty() ? random.sequence(settings.vector_length)
+													  : read_fasta(settings.vector_file);
+	if (settings.vector_file.empty())
+	{
+		write_fasta(settings.out_prefix + ".vector.fa", "vector", vector);
+		std::cout << settings.out_prefix << ".vector.fa" << std::endl;
+	}
+	const unsigned int fragment_length = settings.fragment_length == 0
+											 ? vector.length()
+											 : std::min(settings.fragment_length, (unsigned int)vector.length());
+	if (host.length() < 2 * settings.insert_mean || vector.empty() || settings.read_length == 0 ||
+		settings.copies < 0.0)
+	{
+		std::cerr << "[Error] The host genome must be longer than two insert sizes, and the vector not empty." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Insert sites: ceil(copies) inserts on one haplotype, which gives copies / sites of the reads.
+	const unsigned int sites = (unsigned int)std::ceil(settings.copies);
+	std::vector<Insert> inserts;
+	for (unsigned int i = 0; i < sites; i++)
+	{
+		Insert insert;
+		insert.position = random.below(host.length() - 2 * (u_int64_t)settings.insert_mean) + (u_int64_t)settings.insert_mean;
+		insert.length = fragment_length;
+		insert.start = random.below(vector.length() - fragment_length + 1);
+		insert.reverse = random.below(2) == 1;
+		inserts.push_back(insert);
+	}
+	std::sort(inserts.begin(), inserts.end(), [](const Insert &a, const Insert &b)
+			  { return a.position < b.position; });
+
+	std::string inserted;
+	u_int64_t last = 0;
+	std::ofstream truth(settings.out_prefix + ".truth.txt");
+	truth << "#Seed\t" << settings.seed << "\tHost\t" << host.length() << "\tVector\t" << vector.length()
+		  << "\tCopies\t" << settings.copies << "\tDepth\t" << settings.depth << "\tLength\t" << settings.read_length
+		  << "\tError\t" << settings.error_rate << "\n";
+	truth << "#Position\tVectorStart\tVectorEnd\tStrand\tLeftJunction\tRightJunction\n";
+	for (const Insert &insert : inserts)
+	{
+		std::string fragment = vector.substr(insert.start, insert.length);
+		if (insert.reverse)
+		{
+			fragment = reverse_complement(fragment);
+		}
+		inserted += host.substr(last, insert.position - last);
+		const size_t junction = std::min((size_t)20, fragment.length());
+		truth << insert.position << "\t" << insert.start + 1 << "\t" << insert.start + insert.length << "\t"
+			  << (insert.reverse ? "-" : "+") << "\t"
+			  << host.substr(insert.position - 20, 20) << "|" << fragment.substr(0, junction) << "\t"
+			  << fragment.substr(fragment.length() - junction) << "|" << host.substr(insert.position, 20) << "\n";
+		inserted += fragment;
+		last = insert.position;
+	}
+	inserted += host.substr(last);
+	truth.close();
+	std::cout << settings.out_prefix << ".truth.txt" << std::endl;
+
+	// Mutant: the inserted haplotype by copies / sites, otherwise the host
+	std::vector<std::string> haplotypes = {host};
+	std::vector<double> weights = {1.0};
+	if (sites > 0)
+	{
+		haplotypes = {inserted, host};
+		weights = {settings.copies / sites, 1.0 - settings.copies / sites};
+	}
+	const u_int64_t mutant_pairs = write_sample(settings, random, haplotypes, weights, host.length(), "mutant");
+	const u_int64_t wildType_pairs = write_sample(settings, random, {host}, {1.0}, host.length(), "wildtype");
+	std::cout << "Pairs: " << mutant_pairs << " mutant, " << wildType_pairs << " wild type" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,578 @@
+//============================================================================//
+// Name        : microbench
+// Author      : NARO
+// Copyright   : (c) 2018 National Agriculture and Food Research Organization (NARO)
+// Description : Microbenchmarks of the stages of GenEditScan (JSON output)
+//============================================================================//
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "../bitwise_operation.h"
+#include "../fastq_count.h"
+#include "../gtest.h"
+#include "../mer_code.h"
+#include "../mer_index.h"
+#include "../options.h"
+#include "../sample_count.h"
+
+/**
+ * @brief Complemented Chi-square distribution.
+ *
+ * @param double Degrees of freedom
+ * @param double Chi-square
+ *
+ * @return Probability
+ */
+extern "C" double chdtrc(double, double);
+
+/**
+ * @brief Settings of the microbenchmarks.
+ *
+ */
+struct Settings
+{
+	// K-mers
+	std::vector<unsigned int> kmers = {20};
+
+	// Read lengths
+	std::vector<unsigned int> read_lengths = {150};
+
+	// Vector sizes
+	std::vector<unsigned int> vector_sizes = {6000};
+
+	// Number of reads of each stage
+	unsigned int reads = 100000;
+
+	// Share of the reads drawn from the vector
+	double vector_share = 0.01;
+
+	// Repeats of each stage (the fastest is reported)
+	unsigned int repeats = 3;
+
+	// Random seed
+	u_int64_t seed = 1;
+
+	// Output file (JSON)
+	std::string out_file = "microbench.json";
+};
+
+/**
+ * @brief Result of a stage.
+ *
+ */
+struct Result
+{
+	std::string stage;
+	unsigned int kmer;
+	unsigned int read_length;
+	unsigned int vector_size;
+	u_int64_t items;
+	u_int64_t bytes;
+	double seconds;
+};
+
+/**
+ * @brief Keeps the results of the stages from being optimised away.
+ *
+ */
+static volatile double sink;
+
+/**
+ * @brief Fastest run of a stage.
+ *
+ * @param repeats Number of runs
+ * @param run Stage
+ * @return Seconds
+ */
+template <typename Run>
+double best_seconds(const unsigned int repeats, Run run)
+{
+	double best = 0.0;
+	for (unsigned int i = 0; i < repeats; i++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = i == 0 ? seconds : std::min(best, seconds);
+	}
+	return best;
+}
+
+/**
+ * @brief Random sequence.
+ *
+ * @param engine Random engine
+ * @param length Length
+ * @return Sequence
+ */
+std::string random_sequence(std::mt19937_64 &engine, const size_t length)
+{
+	static const char BASES[] = "ACGT";
+	std::string seq(length, 'A');
+	for (size_t i = 0; i < length; i++)
+	{
+		seq[i] = BASES[engine() % 4];
+	}
+	return seq;
+}
+
+/**
+ * @brief Reverse complement.
+ *
+ * @param seq Sequence
+ * @return Reverse complement
+ */
+std::string reverse_complement(const std::string &seq)
+{
+	std::string rc(seq.rbegin(), seq.rend());
+	for (char &c : rc)
+	{
+		c = c == 'A' ? 'T' : (c == 'C' ? 'G' : (c == 'G' ? 'C' : (c == 'T' ? 'A' : 'N')));
+	}
+	return rc;
+}
+
+/**
+ * @brief Parse comma separated numbers.
+ *
+ * @param arg Argument
+ * @return Numbers
+ */
+std::vector<unsigned int> parse_list(const std::string &arg)
+{
+	std::vector<unsigned int> values;
+	std::istringstream istr(arg);
+	std::string value;
+	while (std::getline(istr, value, ','))
+	{
+		values.push_back(std::stoi(value));
+	}
+	return values;
+}
+
+/**
+ * @brief Read a FASTQ file with gzgets, one line at a time (as FastqCount).
+ *
+ * @param file FASTQ file
+ * @param max_read_length Maximum read length
+ * @return Number of reads
+ */
+u_int64_t parse_gzgets(const std::string &file, const unsigned int max_read_length)
+{
+	const gzFile fp = gzopen(file.c_str(), "rb");
+	const unsigned int max_buff = max_read_length + 2;
+	char buff[max_buff];
+	std::vector<std::string> fastqData;
+	std::string aLine[4];
+	u_int64_t reads = 0, bases = 0;
+	while (true)
+	{
+		int l = 0;
+		for (; l < 4 && gzgets(fp, buff, max_buff) != Z_NULL; l++)
+		{
+			aLine[l] = buff;
+			aLine[l].pop_back();
+		}
+		if (l < 4)
+		{
+			break;
+		}
+		fastqData.push_back(aLine[1]);
+		if (fastqData.size() >= 100000)
+		{
+			fastqData.clear();
+		}
+		bases += aLine[1].length();
+		reads++;
+	}
+	gzclose(fp);
+	sink = bases;
+	return reads;
+}
+
+/**
+ * @brief Read a FASTQ file with gzread in blocks, splitting the lines with memchr.
+ *
+ * @param file FASTQ file
+ * @return Number of reads
+ */
+u_int64_t parse_gzread(const std::string &file)
+{
+	const gzFile fp = gzopen(file.c_str(), "rb");
+	gzbuffer(fp, 1 << 17);
+	std::vector<char> block(1 << 20);
+	std::vector<std::string> fastqData;
+	std::string rest;
+	u_int64_t reads = 0, bases = 0, line = 0;
+	int n;
+	while ((n = gzread(fp, block.data(), block.size())) > 0)
+	{
+		const char *p = block.data();
+		const char *end = p + n;
+		while (p < end)
+		{
+			const char *eol = (const char *)std::memchr(p, '\n', end - p);
+			if (!eol)
+			{
+				rest.append(p, end);
+				break;
+			}
+			if (line++ % 4 == 1)
+			{
+				rest.append(p, eol);
+				fastqData.push_back(rest);
+				if (fastqData.size() >= 100000)
+				{
+					fastqData.clear();
+				}
+				bases += rest.length();
+				reads++;
+			}
+			rest.clear();
+			p = eol + 1;
+		}
+	}
+	gzclose(fp);
+	sink = bases;
+	return reads;
+}
+
+/**
+ * @brief Print help menu.
+ *
+ * @param settings Default settings
+ * @param execute Executable program name
+ */
+void help(const Settings &settings, const std::string &execute)
+{
+	std::cerr << "Usage : " << execute << " [options]\n";
+	std::cerr << "-k | --kmer     : K-mers (connect with comma) (20)\n";
+	std::cerr << "-l | --length   : Read lengths (connect with comma) (150)\n";
+	std::cerr << "-V | --vector-size : Vector sizes (connect with comma) (6000)\n";
+	std::cerr << "-n | --reads    : Number of reads of each stage (" << settings.reads << ")\n";
+	std::cerr << "-x | --share    : Share of the reads drawn from the vector (" << settings.vector_share << ")\n";
+	std::cerr << "-R | --repeats  : Repeats of each stage; the fastest is reported (" << settings.repeats << ")\n";
+	std::cerr << "-s | --seed     : Random seed (" << settings.seed << ")\n";
+	std::cerr << "-o | --out      : Output file (" << settings.out_file << ")\n";
+	std::cerr << "-h | --help     : Print this menu\n";
+}
+
+/**
+ * @brief Run the stages on one set of parameters.
+ *
+ * @param settings Settings
+ * @param kmer K-mer
+ * @param read_length Read length
+ * @param vector_size Vector size
+ * @param results Results (added)
+ */
+void run_stages(const Settings &settings, const unsigned int kmer, const unsigned int read_length,
+				const unsigned int vector_size, std::vector<Result> &results)
+{
+	std::mt19937_64 engine(settings.seed);
+	const std::string vector = random_sequence(engine, vector_size);
+	const unsigned int repeats = settings.repeats;
+	auto add = [&](const std::string &stage, const u_int64_t items, const u_int64_t bytes, const double seconds)
+	{
+		results.push_back(Result{stage, kmer, read_length, vector_size, items, bytes, seconds});
+		std::cerr << stage << " (k " << kmer << ", length " << read_length << ", vector " << vector_size
+				  << "): " << seconds * 1e9 / std::max(items, (u_int64_t)1) << " ns/item" << std::endl;
+	};
+
+	// Reads of the host, and some of the vector
+	std::vector<std::string> reads;
+	u_int64_t bases = 0;
+	for (unsigned int i = 0; i < settings.reads; i++)
+	{
+		if ((engine() >> 11) * (1.0 / 9007199254740992.0) < settings.vector_share && vector_size >= read_length)
+		{
+			const std::string read = vector.substr(engine() % (vector_size - read_length + 1), read_length);
+			reads.push_back(engine() % 2 ? reverse_complement(read) : read);
+		}
+		else
+		{
+			reads.push_back(random_sequence(engine, read_length));
+		}
+		bases += read_length;
+	}
+
+	// FASTQ parsing (compressed and plain files)
+	const std::string fastqFile = settings.out_file + ".tmp.fastq";
+	{
+		const std::string quality(read_length, 'I');
+		std::ofstream plain(fastqFile);
+		const gzFile gz = gzopen((fastqFile + ".gz").c_str(), "wb6");
+		for (size_t i = 0; i < reads.size(); i++)
+		{
+			const std::string record = "@r" + std::to_string(i) + "\n" + reads[i] + "\n+\n" + quality + "\n";
+			plain << record;
+			gzwrite(gz, record.data(), record.length());
+		}
+		gzclose(gz);
+	}
+	for (const std::string suffix : {".gz", ""})
+	{
+		const std::string file = fastqFile + suffix;
+		std::ifstream ifs(file, std::ios::binary | std::ios::ate);
+		const u_int64_t bytes = ifs.tellg();
+		const std::string type = suffix.empty() ? "plain" : "gz";
+		add("parse_gzgets_" + type, reads.size(), bytes,
+			best_seconds(repeats, [&]()
+						 { parse_gzgets(file, read_length); }));
+		add("parse_gzread_" + type, reads.size(), bytes,
+			best_seconds(repeats, [&]()
+						 { parse_gzread(file); }));
+		std::remove(file.c_str());
+	}
+
+	// 2-bit encoding of each k-mer of the reads
+	const u_int64_t mers = (u_int64_t)reads.size() * (read_length >= kmer ? read_length - kmer + 1 : 0);
+	add("encode", mers, bases, best_seconds(repeats, [&]()
+											{
+												u_int64_t sum = 0, code;
+												for (const std::string &read : reads)
+												{
+													for (size_t j = 0; j + kmer <= read.length(); j++)
+													{
+														if (MerCode::encode(read.substr(j, kmer), code))
+														{
+															sum += code;
+														}
+													}
+												}
+												sink = sum; }));
+
+	// Index of the vector k-mers on both strands
+	Options options;
+	options.kmer = kmer;
+	options.kmers = {kmer};
+	options.inner_parallel = 1;
+	options.outer_parallel = 1;
+	options.max_read_length = std::max(options.max_read_length, read_length);
+	options.log_output_interval = ~0u;
+	BitwiseOperation bitwiseOperation(&options);
+	MerIndex *merIndex = bitwiseOperation.get_merIndex(kmer);
+	const std::string rc = reverse_complement(vector);
+	std::vector<u_int64_t> hits;
+	for (size_t j = 0; j + kmer <= vector.length(); j++)
+	{
+		for (const std::string &seq : {vector, rc})
+		{
+			u_int64_t code;
+			merIndex->add(seq.substr(j, kmer));
+			MerCode::encode(seq.substr(j, kmer), code);
+			hits.push_back(code);
+		}
+	}
+	std::vector<u_int64_t> misses;
+	const u_int64_t codeMask = kmer >= MerCode::MAX_KMER ? ~0ULL : (1ULL << (2 * kmer)) - 1;
+	for (unsigned int i = 0; i < settings.reads; i++)
+	{
+		misses.push_back(engine() & codeMask);
+	}
+
+	// Prefilter (random codes, nearly all rejected by the filter) and probes of the hash table (vector codes)
+	add("prefilter", misses.size(), 0, best_seconds(repeats, [&]()
+													{
+														u_int64_t found = 0;
+														for (const u_int64_t code : misses)
+														{
+															found += merIndex->find(code) != MerIndex::NOT_FOUND;
+														}
+														sink = found; }));
+	add("hash_probe", hits.size(), 0, best_seconds(repeats, [&]()
+												   {
+													   u_int64_t sum = 0;
+													   for (const u_int64_t code : hits)
+													   {
+														   sum += merIndex->find(code);
+													   }
+													   sink = sum; }));
+
+	// Rolling scan of the reads
+	add("scan", reads.size(), bases, best_seconds(repeats, [&]()
+												  {
+													  u_int64_t found = 0;
+													  for (const std::string &read : reads)
+													  {
+														  merIndex->scan(read, [&](const size_t, const u_int32_t)
+																		 { found++; });
+													  }
+													  sink = found; }));
+
+	// Counting with the bases on each side (one thread)
+	FastqCount fastqCount(&options, &bitwiseOperation);
+	add("flank_capture", reads.size(), bases, best_seconds(repeats, [&]()
+														   {
+															   std::vector<SampleCount> sampleCounts(1);
+															   sampleCounts[0].kmer = kmer;
+															   std::vector<std::string> fastqData(reads);
+															   Progress::File &progress = options.progress.open("bench", "count", 0);
+															   fastqCount.count_sample("bench", fastqData, sampleCounts, progress);
+															   options.progress.close(progress);
+															   sink = sampleCounts[0].merCounter.size(); }));
+
+	// G-test: counts far above the wild type give G >= 170, for which the
+	// P-value is not computed, so only the corrected G-value is timed.
+	const u_int64_t positions = vector_size >= kmer ? vector_size - kmer + 1 : 0;
+	Gtest gtest(&options);
+	gtest.set_merCounter(bases, bases);
+	add("adjusted_g", positions, 0, best_seconds(repeats, [&]()
+												 {
+													 double sum = 0.0;
+													 for (u_int64_t i = 0; i < positions; i++)
+													 {
+														 sum += std::get<0>(gtest.kmer_extension(200 + i % 200, i % 2));
+													 }
+													 sink = sum; }));
+	add("chdtrc", positions, 0, best_seconds(repeats, [&]()
+											 {
+												 double sum = 0.0;
+												 for (u_int64_t i = 0; i < positions; i++)
+												 {
+													 sum += chdtrc(1.0, 0.01 + (i % 16900) * 0.01);
+												 }
+												 sink = sum; }));
+
+	// Benjamini-Hochberg FDR of the P-values of the positions
+	std::unordered_map<unsigned int, std::unordered_map<unsigned int, double>> pval;
+	for (u_int64_t i = 0; i < positions; i++)
+	{
+		pval[i][0] = (engine() >> 11) * (1.0 / 9007199254740992.0);
+	}
+	add("bh_fdr", positions, 0, best_seconds(repeats, [&]()
+											 { sink = gtest.fdr_extension(pval).size(); }));
+
+	// Whole match test of the positions (G-value, P-value, FDR)
+	std::vector<unsigned int> mutantPosFreq, wildTypePosFreq;
+	for (u_int64_t i = 0; i < positions; i++)
+	{
+		mutantPosFreq.push_back(engine() % 50);
+		wildTypePosFreq.push_back(engine() % 10);
+	}
+	add("gtest_match", positions, 0, best_seconds(repeats, [&]()
+												  {
+													  Gtest match(&options);
+													  match.set_merCounter(bases, bases);
+													  match.kmer_match(mutantPosFreq, wildTypePosFreq);
+													  sink = match.get_fdr().size(); }));
+}
+
+/**
+ * @brief Main function.
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return Exit code
+ */
+int main(int argc, char *argv[])
+{
+	Settings settings;
+	const struct option long_options[] = {
+		{"kmer", required_argument, NULL, 'k'},
+		{"length", required_argument, NULL, 'l'},
+		{"vector-size", required_argument, NULL, 'V'},
+		{"reads", required_argument, NULL, 'n'},
+		{"share", required_argument, NULL, 'x'},
+		{"repeats", required_argument, NULL, 'R'},
+		{"seed", required_argument, NULL, 's'},
+		{"out", required_argument, NULL, 'o'},
+		{"help", no_argument, NULL, 'h'},
+		{0, 0, 0, 0}};
+
+	try
+	{
+		int c;
+		int long_index;
+		while ((c = getopt_long(argc, argv, "k:l:V:n:x:R:s:o:h", long_options, &long_index)) != -1)
+		{
+			switch (c)
+			{
+			case 'k':
+				settings.kmers = parse_list(optarg);
+				break;
+			case 'l':
+				settings.read_lengths = parse_list(optarg);
+				break;
+			case 'V':
+				settings.vector_sizes = parse_list(optarg);
+				break;
+			case 'n':
+				settings.reads = std::stoi(optarg);
+				break;
+			case 'x':
+				settings.vector_share = std::stod(optarg);
+				break;
+			case 'R':
+				settings.repeats = std::max(std::stoi(optarg), 1);
+				break;
+			case 's':
+				settings.seed = std::stoull(optarg);
+				break;
+			case 'o':
+				settings.out_file = optarg;
+				break;
+			default:
+				help(settings, argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "[Error] " << argv[0] << ": " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	for (const unsigned int kmer : settings.kmers)
+	{
+		if (kmer < 1 || kmer > MerCode::MAX_KMER)
+		{
+			std::cerr << "[Error] K-mer must be 1 to " << MerCode::MAX_KMER << "." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<Result> results;
+	for (const unsigned int kmer : settings.kmers)
+	{
+		for (const unsigned int read_length : settings.read_lengths)
+		{
+			for (const unsigned int vector_size : settings.vector_sizes)
+			{
+				run_stages(settings, kmer, read_length, vector_size, results);
+			}
+		}
+	}
+
+	std::ofstream ofs(settings.out_file);
+	ofs << "{\n  \"reads\": " << settings.reads << ",\n  \"vector_share\": " << settings.vector_share
+		<< ",\n  \"repeats\": " << settings.repeats << ",\n  \"seed\": " << settings.seed << ",\n  \"results\": [";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result &r = results[i];
+		ofs << (i > 0 ? "," : "") << "\n    {\"stage\": \"" << r.stage << "\", \"kmer\": " << r.kmer
+			<< ", \"read_length\": " << r.read_length << ", \"vector_size\": " << r.vector_size
+			<< ", \"items\": " << r.items << ", \"bytes\": " << r.bytes << ", \"seconds\": " << r.seconds
+			<< ", \"ns_per_item\": " << r.seconds * 1e9 / std::max(r.items, (u_int64_t)1)
+			<< ", \"mb_per_second\": " << (r.seconds > 0.0 ? r.bytes / r.seconds / 1e6 : 0.0) << "}";
+	}
+	ofs << "\n  ]\n}\n";
+	if (!ofs)
+	{
+		std::cerr << "[Error] Could not write (" << settings.out_file << ")." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << settings.out_file << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,462 @@
+//============================================================================//
+// Name        : scaling
+// Author      : NARO
+// Copyright   : (c) 2018 National Agriculture and Food Research Organization (NARO)
+// Description : Thread scaling and throughput of geneditscan kmer on the
+//               synthetic corpus, with byte comparison of the result files
+//============================================================================//
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Settings of the harness.
+ *
+ */
+struct Settings
+{
+	// geneditscan
+	std::string program = "./geneditscan";
+
+	// Corpus generator
+	std::string corpus = "./bench/corpus";
+
+	// Arguments of the corpus (besides -n and -o)
+	std::string corpus_args = "-G 1000000 -d 10";
+
+	// Numbers of threads (-t)
+	std::vector<unsigned int> threads;
+
+	// Reads in memory (-r)
+	std::vector<unsigned int> read_lines = {1000000, 10000000};
+
+	// Numbers of file pairs per sample
+	std::vector<unsigned int> files = {1, 4};
+
+	// Reference result files (recorded when the directory does not exist)
+	std::string reference_dir;
+
+	// Working directory
+	std::string work_dir = "scaling_work";
+
+	// Output file (JSON)
+	std::string out_file = "scaling.json";
+};
+
+/**
+ * @brief Measurement of a run.
+ *
+ */
+struct Run
+{
+	unsigned int threads;
+	unsigned int read_lines;
+	unsigned int files;
+	double seconds;
+	long peak_rss_kb;
+	bool identical;
+};
+
+/**
+ * @brief Parse comma separated numbers.
+ *
+ * @param arg Argument
+ * @return Numbers
+ */
+std::vector<unsigned int> parse_list(const std::string &arg)
+{
+	std::vector<unsigned int> values;
+	std::istringstream istr(arg);
+	std::string value;
+	while (std::getline(istr, value, ','))
+	{
+		values.push_back(std::stoi(value));
+	}
+	return values;
+}
+
+/**
+ * @brief Split the words of a command line.
+ *
+ * @param line Command line
+ * @return Words
+ */
+std::vector<std::string> split_words(const std::string &line)
+{
+	std::istringstream istr(line);
+	return std::vector<std::string>(std::istream_iterator<std::string>(istr), std::istream_iterator<std::string>());
+}
+
+/**
+ * @brief Run a program with its output to a log file.
+ *
+ * @param args Program and arguments
+ * @param logFile Log file (stdout and stderr)
+ * @param usage Resource usage of the program
+ * @return Exit status
+ */
+int execute(const std::vector<std::string> &args, const std::string &logFile, struct rusage &usage)
+{
+	const pid_t pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "[Error] Could not fork." << std::endl;
+		std::exit(1);
+	}
+	if (pid == 0)
+	{
+		const int fd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd >= 0)
+		{
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		std::vector<char *> argv;
+		for (const std::string &arg : args)
+		{
+			argv.push_back(const_cast<char *>(arg.c_str()));
+		}
+		argv.push_back(nullptr);
+		execvp(argv[0], argv.data());
+		_exit(127);
+	}
+	int status = 0;
+	wait4(pid, &status, 0, &usage);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+/**
+ * @brief Compare two files byte by byte.
+ *
+ * @param file1 File
+ * @param file2 File
+ * @return True when identical
+ */
+bool same_file(const std::string &file1, const std::string &file2)
+{
+	std::ifstream ifs1(file1, std::ios::binary), ifs2(file2, std::ios::binary);
+	if (!ifs1 || !ifs2)
+	{
+		return false;
+	}
+	return std::equal(std::istreambuf_iterator<char>(ifs1), std::istreambuf_iterator<char>(),
+					  std::istreambuf_iterator<char>(ifs2), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Whether a file of a run is a result (not the log, the metrics or a trace).
+ *
+ * The metrics and the trace hold times, thread counts and memory use, which
+ * differ between runs with the same results.
+ *
+ * @param name File name
+ * @return True for a result file
+ */
+bool is_result(const std::string &name)
+{
+	const auto ends_with = [&name](const std::string &suffix)
+	{
+		return name.length() >= suffix.length() &&
+			   name.compare(name.length() - suffix.length(), suffix.length(), suffix) == 0;
+	};
+	return name != "run.log" && !ends_with(".metrics.json") && !ends_with(".trace.json");
+}
+
+/**
+ * @brief Result files of a run (names without the run directory).
+ *
+ * @param dir Run directory
+ * @return File names (the log, the metrics and traces are not results)
+ */
+std::vector<std::string> result_files(const std::string &dir)
+{
+	std::vector<std::string> names;
+	for (const auto &entry : std::filesystem::directory_iterator(dir))
+	{
+		const std::string name = entry.path().filename().string();
+		if (entry.is_regular_file() && is_result(name))
+		{
+			names.push_back(name);
+		}
+	}
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+/**
+ * @brief Compare the result files of a run with the reference.
+ *
+ * @param dir Run directory
+ * @param reference_dir Reference directory
+ * @return True when the same files are written with the same bytes
+ */
+bool same_results(const std::string &dir, const std::string &reference_dir)
+{
+	const std::vector<std::string> names = result_files(dir);
+	if (names.empty() || names != result_files(reference_dir))
+	{
+		std::cerr << dir << ": the result files differ from " << reference_dir << "." << std::endl;
+		return false;
+	}
+	bool identical = true;
+	for (const std::string &name : names)
+	{
+		if (!same_file(dir + "/" + name, reference_dir + "/" + name))
+		{
+			std::cerr << dir << "/" << name << " differs from " << reference_dir << "/" << name << "." << std::endl;
+			identical = false;
+		}
+	}
+	return identical;
+}
+
+/**
+ * @brief Print help menu.
+ *
+ * @param settings Default settings
+ * @param execute Executable program name
+ */
+void help(const Settings &settings, const std::string &execute)
+{
+	std::cerr << "Usage : " << execute << " [options]\n";
+	std::cerr << "-b | --program  : geneditscan (" << settings.program << ")\n";
+	std::cerr << "-g | --corpus   : Corpus generator (" << settings.corpus << ")\n";
+	std::cerr << "-a | --corpus-args : Arguments of the corpus (\"" << settings.corpus_args << "\")\n";
+	std::cerr << "-t | --threads  : Numbers of threads (connect with comma) (1, 2, 4, ... and all cores)\n";
+	std::cerr << "-r | --reads    : Reads in memory (connect with comma) (1000000,10000000)\n";
+	std::cerr << "-n | --files    : Numbers of file pairs per sample (connect with comma) (1,4)\n";
+	std::cerr << "-R | --reference : Reference result files; recorded by the first run when it does not exist\n";
+	std::cerr << "                  (default: the first run is the reference)\n";
+	std::cerr << "-w | --work     : Working directory (" << settings.work_dir << ")\n";
+	std::cerr << "-o | --out      : Output file (" << settings.out_file << ")\n";
+	std::cerr << "-h | --help     : Print this menu\n";
+}
+
+/**
+ * @brief Main function.
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return Exit code (1 when a run fails or its results differ from the reference)
+ */
+int main(int argc, char *argv[])
+{
+	Settings settings;
+	const struct option long_options[] = {
+		{"program", required_argument, NULL, 'b'},
+		{"corpus", required_argument, NULL, 'g'},
+		{"corpus-args", required_argument, NULL, 'a'},
+		{"threads", required_argument, NULL, 't'},
+		{"reads", required_argument, NULL, 'r'},
+		{"files", required_argument, NULL, 'n'},
+		{"reference", required_argument, NULL, 'R'},
+		{"work", required_argument, NULL, 'w'},
+		{"out", required_argument, NULL, 'o'},
+		{"help", no_argument, NULL, 'h'},
+		{0, 0, 0, 0}};
+
+	try
+	{
+		int c;
+		int long_index;
+		while ((c = getopt_long(argc, argv, "b:g:a:t:r:n:R:w:o:h", long_options, &long_index)) != -1)
+		{
+			switch (c)
+			{
+			case 'b':
+				settings.program = optarg;
+				break;
+			case 'g':
+				settings.corpus = optarg;
+				break;
+			case 'a':
+				settings.corpus_args = optarg;
+				break;
+			case 't':
+				settings.threads = parse_list(optarg);
+				break;
+			case 'r':
+				settings.read_lines = parse_list(optarg);
+				break;
+			case 'n':
+				settings.files = parse_list(optarg);
+				break;
+			case 'R':
+				settings.reference_dir = optarg;
+				break;
+			case 'w':
+				settings.work_dir = optarg;
+				break;
+			case 'o':
+				settings.out_file = optarg;
+				break;
+			default:
+				help(settings, argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "[Error] " << argv[0] << ": " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// 1, 2, 4, ... and all cores
+	const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	if (settings.threads.empty())
+	{
+		for (unsigned int t = 1; t < cores; t *= 2)
+		{
+			settings.threads.push_back(t);
+		}
+		settings.threads.push_back(cores);
+	}
+	std::sort(settings.threads.begin(), settings.threads.end());
+	std::filesystem::create_directories(settings.work_dir);
+
+	std::vector<Run> runs;
+	std::map<unsigned int, std::pair<u_int64_t, u_int64_t>> inputs;
+	std::string reference_dir = settings.reference_dir;
+	bool record = !reference_dir.empty() && !std::filesystem::exists(reference_dir);
+	bool passed = true;
+	for (const unsigned int files : settings.files)
+	{
+		// Corpus split into the number of files (the same reads for any split)
+		const std::string prefix = settings.work_dir + "/corpus.n" + std::to_string(files);
+		std::vector<std::string> args = {settings.corpus};
+		const std::vector<std::string> corpus_args = split_words(settings.corpus_args);
+		args.insert(args.end(), corpus_args.begin(), corpus_args.end());
+		args.insert(args.end(), {"-n", std::to_string(files), "-o", prefix});
+		struct rusage usage;
+		std::cerr << "Corpus: " << prefix << std::endl;
+		if (execute(args, prefix + ".log", usage) != 0)
+		{
+			std::cerr << "[Error] The corpus was not made (" << prefix << ".log)." << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::string mutant, wildType;
+		u_int64_t bytes = 0, reads = 0;
+		std::ifstream log(prefix + ".log");
+		std::string line;
+		while (std::getline(log, line))
+		{
+			if (line.find(".fastq.gz") != std::string::npos)
+			{
+				std::string &list = line.find(".mutant") != std::string::npos ? mutant : wildType;
+				list += (list.empty() ? "" : ",") + line;
+				bytes += std::filesystem::file_size(line);
+			}
+			else if (line.compare(0, 7, "Pairs: ") == 0)
+			{
+				std::istringstream istr(line.substr(7));
+				u_int64_t mutant_pairs, wildType_pairs;
+				std::string word;
+				istr >> mutant_pairs >> word >> wildType_pairs;
+				reads = 2 * (mutant_pairs + wildType_pairs);
+			}
+		}
+		inputs[files] = std::make_pair(reads, bytes);
+
+		for (const unsigned int read_lines : settings.read_lines)
+		{
+			for (const unsigned int threads : settings.threads)
+			{
+				const std::string dir = settings.work_dir + "/n" + std::to_string(files) + ".r" +
+										std::to_string(read_lines) + ".t" + std::to_string(threads);
+				std::filesystem::remove_all(dir);
+				std::filesystem::create_directories(dir);
+				const std::vector<std::string> run_args = {
+					settings.program, "kmer", "-v", prefix + ".vector.fa", "-m", mutant, "-w", wildType,
+					"-t", std::to_string(threads), "-r", std::to_string(read_lines), "-o", dir + "/run"};
+
+				const auto start = std::chrono::steady_clock::now();
+				const int status = execute(run_args, dir + "/run.log", usage);
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (status != 0)
+				{
+					std::cerr << "[Error] geneditscan failed (" << dir << "/run.log)." << std::endl;
+					return EXIT_FAILURE;
+				}
+
+				// The first run is the reference, or is recorded as the reference.
+				bool identical = true;
+				if (reference_dir.empty() || record)
+				{
+					if (record)
+					{
+						std::filesystem::create_directories(reference_dir);
+						for (const std::string &name : result_files(dir))
+						{
+							std::filesystem::copy_file(dir + "/" + name, reference_dir + "/" + name);
+						}
+						std::cerr << "Recorded the reference in " << reference_dir << std::endl;
+					}
+					else
+					{
+						reference_dir = dir;
+					}
+					record = false;
+				}
+				else
+				{
+					identical = same_results(dir, reference_dir);
+					passed = passed && identical;
+				}
+
+				runs.push_back(Run{threads, read_lines, files, seconds, usage.ru_maxrss, identical});
+				std::cerr << "Files " << files << ", reads in memory " << read_lines << ", threads " << threads
+						  << ": " << seconds << " s, " << reads / seconds << " reads/s, peak RSS "
+						  << usage.ru_maxrss << " kB" << (identical ? "" : ", DIFFERENT") << std::endl;
+			}
+		}
+	}
+
+	// Parallel efficiency against the fewest threads of the same files and reads in memory
+	std::ofstream ofs(settings.out_file);
+	ofs << "{\n  \"cores\": " << cores << ",\n  \"corpus_args\": \"" << settings.corpus_args
+		<< "\",\n  \"reference\": \"" << reference_dir << "\",\n  \"identical\": " << (passed ? "true" : "false")
+		<< ",\n  \"runs\": [";
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		const Run &r = runs[i];
+		const Run &base = *std::find_if(runs.begin(), runs.end(), [&](const Run &b)
+										{ return b.files == r.files && b.read_lines == r.read_lines; });
+		const double efficiency = base.seconds * base.threads / (r.seconds * r.threads);
+		const std::pair<u_int64_t, u_int64_t> &input = inputs[r.files];
+		ofs << (i > 0 ? "," : "") << "\n    {\"threads\": " << r.threads << ", \"read_lines\": " << r.read_lines
+			<< ", \"files\": " << r.files << ", \"reads\": " << input.first << ", \"bytes\": " << input.second
+			<< ", \"seconds\": " << r.seconds << ", \"reads_per_second\": " << input.first / r.seconds
+			<< ", \"bytes_per_second\": " << input.second / r.seconds << ", \"peak_rss_kb\": " << r.peak_rss_kb
+			<< ", \"efficiency\": " << efficiency << ", \"identical\": " << (r.identical ? "true" : "false") << "}";
+	}
+	ofs << "\n  ]\n}\n";
+	if (!ofs)
+	{
+		std::cerr << "[Error] Could not write (" << settings.out_file << ")." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << settings.out_file << std::endl;
+	if (!passed)
+	{
+		std::cerr << "[Error] The result files of some runs differ from the reference." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -2,6 +2,8 @@
  * GenEditScan
  * Copyright 2018 National Agriculture and Food Research Organization (NARO)
  */
+#include <iostream>
+#include <thread>
 #include "bitwise_operation.h"
 
 /**
@@ -10,16 +12,30 @@
  */
 BitwiseOperation::BitwiseOperation(Options *options)
 {
-	this->dna2bit = new unsigned char[128];
-	for (unsigned int i = 0; i < 128; i++)
+	this->options = options;
+	for (auto itr = options->kmers.begin(); itr != options->kmers.end(); ++itr)
 	{
-		this->dna2bit[i] = 0;
+		this->merIndexes[*itr] = new MerIndex(*itr);
+	}
+	if (this->merIndexes.count(options->kmer) == 0)
+	{
+		this->merIndexes[options->kmer] = new MerIndex(options->kmer);
+	}
+
+	this->vectorIndex = nullptr;
+	if (!options->vector_file.empty() && VectorIndex::is_index(options->vector_file))
+	{
+		this->vectorIndex = new VectorIndex(options->vector_file);
+		for (auto itr = this->merIndexes.begin(); itr != this->merIndexes.end(); ++itr)
+		{
+			if (this->vectorIndex->get_kmer() != itr->first)
+			{
+				std::cerr << "[Error] The vector index was built with k-mer " << this->vectorIndex->get_kmer()
+						  << " (-k " << itr->first << ")." << std::endl;
+				std::exit(1);
+			}
+		}
 	}
-	this->dna2bit[84] = 0; // T or others
-	this->dna2bit[67] = 1; // C
-	this->dna2bit[65] = 2; // A
-	this->dna2bit[71] = 3; // G
-	this->chunk = new unsigned char[options->max_chunk_array];
 }
 
 /**
@@ -28,6 +44,55 @@ BitwiseOperation::BitwiseOperation(Options *options)
  */
 BitwiseOperation::~BitwiseOperation()
 {
-	delete[] this->dna2bit;
-	delete[] this->chunk;
+	for (auto itr = this->merIndexes.begin(); itr != this->merIndexes.end(); ++itr)
+	{
+		delete itr->second;
+	}
+	for (auto itr = this->replicas.begin(); itr != this->replicas.end(); ++itr)
+	{
+		for (MerIndex *replica : itr->second)
+		{
+			delete replica;
+		}
+	}
+	delete this->vectorIndex;
+}
+
+/**
+ * @brief Copy the k-mer indexes to each NUMA node (--numa; after they are created).
+ *
+ * One thread bound to each node copies the indexes, so that the pages of
+ * each copy are on its node; the scans read the copy of their node.
+ */
+void BitwiseOperation::replicate_merIndexes()
+{
+	const NumaPlacement &numa = this->options->numa;
+	if (!numa.is_enabled())
+	{
+		return;
+	}
+	for (auto itr = this->merIndexes.begin(); itr != this->merIndexes.end(); ++itr)
+	{
+		std::vector<MerIndex *> &replica = this->replicas[itr->first];
+		while (replica.size() < numa.size())
+		{
+			replica.push_back(new MerIndex(itr->first));
+		}
+	}
+
+	std::vector<std::thread> threads;
+	for (unsigned int node = 0; node < numa.size(); node++)
+	{
+		threads.emplace_back([this, &numa, node]()
+							 {
+								 numa.bind(node);
+								 for (auto itr = this->merIndexes.begin(); itr != this->merIndexes.end(); ++itr)
+								 {
+									 this->replicas.at(itr->first)[node]->copy(*itr->second);
+								 } });
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
 }
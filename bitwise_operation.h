@@ -5,7 +5,11 @@
 #ifndef BITWISE_OPERATION_H_
 #define BITWISE_OPERATION_H_
 
+#include <map>
+#include <vector>
 #include "options.h"
+#include "mer_index.h"
+#include "vector_index.h"
 
 /**
  * @brief Bitwise operation.
@@ -28,27 +32,62 @@ public:
 
 	// Getter
 
-	unsigned char *get_dna2bit() const
+	MerIndex *get_merIndex() const
 	{
-		return this->dna2bit;
+		return this->merIndexes.at(this->options->kmer);
 	}
 
-	unsigned char *get_chunk() const
+	MerIndex *get_merIndex(const unsigned int kmer) const
 	{
-		return this->chunk;
+		return this->merIndexes.at(kmer);
 	}
 
+	/**
+	 * @brief K-mer index of a k to scan on a NUMA node (its copy with --numa).
+	 *
+	 * @param kmer K-mer
+	 * @param node Node (NumaPlacement::place)
+	 * @return K-mer index
+	 */
+	const MerIndex *get_merIndex(const unsigned int kmer, const unsigned int node) const
+	{
+		const auto itr = this->replicas.find(kmer);
+		return itr == this->replicas.end() || node >= itr->second.size() ? this->merIndexes.at(kmer) : itr->second[node];
+	}
+
+	const VectorIndex *get_vectorIndex() const
+	{
+		return this->vectorIndex;
+	}
+
+	/**
+	 * @brief Copy the k-mer indexes to each NUMA node (--numa; after they are created).
+	 *
+	 */
+	void replicate_merIndexes();
+
 private:
 	/**
-	 * @brief For bitwise operation. DNA expressed in 2 bits.
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Index of the k-mers searched in the reads (one per k of the run).
 	 *
 	 */
-	unsigned char *dna2bit;
+	std::map<unsigned int, MerIndex *> merIndexes;
+
+	/**
+	 * @brief Copy of each k-mer index on each NUMA node (--numa).
+	 */
+	std::map<unsigned int, std::vector<MerIndex *>> replicas;
 
 	/**
-	 * @brief For bitwise operation. Chunk array.
+	 * @brief Vector index file given as the vector file (nullptr for a fasta file).
 	 *
 	 */
-	unsigned char *chunk;
+	VectorIndex *vectorIndex;
 };
 #endif /* BITWISE_OPERATION_H_ */
@@ -0,0 +1,550 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "columnar_file.h"
+#include "result_writer.h"
+
+/**
+ * @brief Find a column of a type.
+ *
+ * @param name Column name
+ * @param type Column type
+ * @return Column (exit if not found or of another type)
+ */
+const Columnar::Column &Columnar::Table::column(const std::string &name, const Type type) const
+{
+	for (auto itr = this->columns.begin(); itr != this->columns.end(); ++itr)
+	{
+		if (itr->name == name)
+		{
+			if (itr->type != type)
+			{
+				std::cerr << "[Error] Column (" << this->name << "." << name << ") has type " << itr->type
+						  << ", not " << type << "." << std::endl;
+				std::exit(1);
+			}
+			return *itr;
+		}
+	}
+	std::cerr << "[Error] Column (" << this->name << "." << name << ") is not found." << std::endl;
+	std::exit(1);
+}
+
+//============================================================================//
+// ColumnarWriter
+//============================================================================//
+/**
+ * @brief Copy a name into a fixed length, zero padded field.
+ *
+ * @param field Field (Columnar::NAME_LENGTH bytes)
+ * @param name Name (shorter than Columnar::NAME_LENGTH)
+ */
+static void copy_name(char *field, const std::string &name)
+{
+	memset(field, 0, Columnar::NAME_LENGTH);
+	memcpy(field, name.data(), std::min(name.length(), Columnar::NAME_LENGTH - 1));
+}
+
+/**
+ * @brief Construct a new Columnar Writer:: Columnar Writer object
+ *
+ * @param outfile Output file
+ */
+ColumnarWriter::ColumnarWriter(const std::string &outfile)
+{
+	this->outfile = outfile;
+	this->file = fopen(outfile.c_str(), "wb");
+	if (!this->file)
+	{
+		std::cerr << "[Error] Could not open (" << outfile << ")." << std::endl;
+		std::exit(1);
+	}
+	// Header; the footer offset is filled in by close().
+	const u_int64_t zero[3] = {0, 0, 0};
+	this->offset = 0;
+	this->write(Columnar::MAGIC, sizeof(Columnar::MAGIC));
+	this->write(&Columnar::VERSION, sizeof(u_int32_t));
+	this->write(zero, sizeof(u_int32_t) + 2 * sizeof(u_int64_t));
+}
+
+/**
+ * @brief Destroy the Columnar Writer:: Columnar Writer object
+ *
+ */
+ColumnarWriter::~ColumnarWriter()
+{
+	this->close();
+}
+
+/**
+ * @brief Start a table. Columns added later belong to it.
+ *
+ * @param name Table name
+ * @param rows Number of rows
+ */
+void ColumnarWriter::add_table(const std::string &name, const u_int64_t rows)
+{
+	Columnar::Table table;
+	table.name = name;
+	table.rows = rows;
+	this->tables.push_back(table);
+}
+
+void ColumnarWriter::add_column(const std::string &name, const std::vector<u_int32_t> &values)
+{
+	this->write_column(name, Columnar::U32, values.size(), values.data(), values.size() * sizeof(u_int32_t));
+}
+
+void ColumnarWriter::add_column(const std::string &name, const std::vector<u_int64_t> &values)
+{
+	this->write_column(name, Columnar::U64, values.size(), values.data(), values.size() * sizeof(u_int64_t));
+}
+
+void ColumnarWriter::add_column(const std::string &name, const std::vector<double> &values)
+{
+	this->write_column(name, Columnar::F64, values.size(), values.data(), values.size() * sizeof(double));
+}
+
+void ColumnarWriter::add_column(const std::string &name, const std::vector<std::string> &values)
+{
+	std::vector<u_int64_t> offsets;
+	offsets.reserve(values.size() + 1);
+	u_int64_t chars = 0;
+	offsets.push_back(chars);
+	for (auto itr = values.begin(); itr != values.end(); ++itr)
+	{
+		chars += itr->length();
+		offsets.push_back(chars);
+	}
+	std::string data(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(u_int64_t));
+	data.reserve(data.length() + chars);
+	for (auto itr = values.begin(); itr != values.end(); ++itr)
+	{
+		data += *itr;
+	}
+	this->write_column(name, Columnar::STR, values.size(), data.data(), data.length());
+}
+
+/**
+ * @brief Write the footer and close the file.
+ *
+ */
+void ColumnarWriter::close()
+{
+	if (!this->file)
+	{
+		return;
+	}
+	const u_int64_t footer = this->offset;
+	const u_int32_t zero = 0;
+	const u_int32_t nTables = this->tables.size();
+	char name[Columnar::NAME_LENGTH];
+
+	this->write(&nTables, sizeof(u_int32_t));
+	this->write(&zero, sizeof(u_int32_t));
+	for (auto table = this->tables.begin(); table != this->tables.end(); ++table)
+	{
+		const u_int32_t nColumns = table->columns.size();
+		copy_name(name, table->name);
+		this->write(name, sizeof(name));
+		this->write(&table->rows, sizeof(u_int64_t));
+		this->write(&nColumns, sizeof(u_int32_t));
+		this->write(&zero, sizeof(u_int32_t));
+		for (auto column = table->columns.begin(); column != table->columns.end(); ++column)
+		{
+			const u_int64_t columnOffset = reinterpret_cast<u_int64_t>(column->data);
+			copy_name(name, column->name);
+			this->write(name, sizeof(name));
+			this->write(&column->type, sizeof(u_int32_t));
+			this->write(&zero, sizeof(u_int32_t));
+			this->write(&columnOffset, sizeof(u_int64_t));
+			this->write(&column->bytes, sizeof(u_int64_t));
+		}
+	}
+	this->write(&footer, sizeof(u_int64_t));
+	this->write(Columnar::MAGIC, sizeof(Columnar::MAGIC));
+
+	if (fseek(this->file, sizeof(Columnar::MAGIC) + 2 * sizeof(u_int32_t), SEEK_SET) != 0 ||
+		fwrite(&footer, sizeof(u_int64_t), 1, this->file) != 1 || fclose(this->file) != 0)
+	{
+		std::cerr << "[Error] Could not write (" << this->outfile << ")." << std::endl;
+		std::exit(1);
+	}
+	this->file = nullptr;
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Write column data and register the column.
+ *
+ * @param name Column name
+ * @param type Column type
+ * @param rows Number of rows
+ * @param data Bytes
+ * @param bytes Number of bytes
+ */
+void ColumnarWriter::write_column(const std::string &name, const Columnar::Type type, const u_int64_t rows,
+								  const void *data, const u_int64_t bytes)
+{
+	if (this->tables.empty() || this->tables.back().rows != rows || name.length() >= Columnar::NAME_LENGTH)
+	{
+		std::cerr << "[Error] Invalid column (" << name << ") in (" << this->outfile << ")." << std::endl;
+		std::exit(1);
+	}
+	// Columns are 8-byte aligned so that mapped data can be used in place.
+	const char padding[8] = {0};
+	this->write(padding, (8 - this->offset % 8) % 8);
+
+	Columnar::Column column;
+	column.name = name;
+	column.type = type;
+	column.rows = rows;
+	column.data = reinterpret_cast<const char *>(this->offset);
+	column.bytes = bytes;
+	this->tables.back().columns.push_back(column);
+	this->write(data, bytes);
+}
+
+/**
+ * @brief Write bytes.
+ *
+ * @param data Bytes
+ * @param bytes Number of bytes
+ */
+void ColumnarWriter::write(const void *data, const u_int64_t bytes)
+{
+	if (bytes > 0 && fwrite(data, 1, bytes, this->file) != bytes)
+	{
+		std::cerr << "[Error] Could not write (" << this->outfile << ")." << std::endl;
+		std::exit(1);
+	}
+	this->offset += bytes;
+}
+
+//============================================================================//
+// ColumnarReader
+//============================================================================//
+/**
+ * @brief Check the size and the string offsets of a column against its rows.
+ *
+ * @param column Column (data and bytes inside the file)
+ * @return true if every row can be read within the bytes of the column
+ */
+static bool valid_column(const Columnar::Column &column)
+{
+	const u_int64_t maxRows = column.bytes / sizeof(u_int32_t);
+	switch (column.type)
+	{
+	case Columnar::U32:
+		return column.rows <= maxRows && column.bytes >= column.rows * sizeof(u_int32_t);
+	case Columnar::U64:
+	case Columnar::F64:
+		return column.rows <= maxRows && column.bytes >= column.rows * sizeof(u_int64_t);
+	case Columnar::STR:
+	{
+		if (column.rows >= maxRows || column.bytes < (column.rows + 1) * sizeof(u_int64_t))
+		{
+			return false;
+		}
+		// Offsets from 0, not decreasing and within the characters
+		const u_int64_t *offset = column.u64();
+		const u_int64_t chars = column.bytes - (column.rows + 1) * sizeof(u_int64_t);
+		if (offset[0] != 0)
+		{
+			return false;
+		}
+		for (u_int64_t row = 0; row < column.rows; row++)
+		{
+			if (offset[row + 1] < offset[row] || offset[row + 1] > chars)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief Construct a new Columnar Reader:: Columnar Reader object
+ *
+ * @param infile Input file
+ */
+ColumnarReader::ColumnarReader(const std::string &infile)
+{
+	this->infile = infile;
+	const int fd = open(infile.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		std::cerr << "[Error] Could not open (" << infile << ")." << std::endl;
+		std::exit(1);
+	}
+	this->length = st.st_size;
+	void *addr = this->length > 0 ? mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	::close(fd);
+
+	const size_t header = sizeof(Columnar::MAGIC) + 2 * sizeof(u_int32_t) + 2 * sizeof(u_int64_t);
+	const size_t trailer = sizeof(u_int64_t) + sizeof(Columnar::MAGIC);
+	this->map = static_cast<const char *>(addr);
+	if (addr == MAP_FAILED || this->length < header + trailer ||
+		memcmp(this->map, Columnar::MAGIC, sizeof(Columnar::MAGIC)) != 0 ||
+		memcmp(this->map + this->length - sizeof(Columnar::MAGIC), Columnar::MAGIC, sizeof(Columnar::MAGIC)) != 0)
+	{
+		std::cerr << "[Error] Not a GenEditScan columnar file (" << infile << ")." << std::endl;
+		std::exit(1);
+	}
+
+	u_int32_t version;
+	u_int64_t footer;
+	memcpy(&version, this->map + sizeof(Columnar::MAGIC), sizeof(u_int32_t));
+	memcpy(&footer, this->map + this->length - trailer, sizeof(u_int64_t));
+	if (version != Columnar::VERSION)
+	{
+		std::cerr << "[Error] Unsupported columnar file version " << version << " (" << infile << ")." << std::endl;
+		std::exit(1);
+	}
+	if (footer < header || footer > this->length - trailer)
+	{
+		std::cerr << "[Error] Broken columnar file (" << infile << ")." << std::endl;
+		std::exit(1);
+	}
+
+	// Footer index
+	const char *p = this->map + footer;
+	const char *end = this->map + this->length - trailer;
+	auto read = [&](void *dst, const size_t bytes)
+	{
+		if (p + bytes > end)
+		{
+			std::cerr << "[Error] Broken columnar file (" << infile << ")." << std::endl;
+			std::exit(1);
+		}
+		memcpy(dst, p, bytes);
+		p += bytes;
+	};
+	char name[Columnar::NAME_LENGTH + 1] = {0};
+	u_int32_t nTables, nColumns, skip;
+	read(&nTables, sizeof(u_int32_t));
+	read(&skip, sizeof(u_int32_t));
+	for (u_int32_t t = 0; t < nTables; t++)
+	{
+		Columnar::Table table;
+		read(name, Columnar::NAME_LENGTH);
+		table.name = name;
+		read(&table.rows, sizeof(u_int64_t));
+		read(&nColumns, sizeof(u_int32_t));
+		read(&skip, sizeof(u_int32_t));
+		for (u_int32_t c = 0; c < nColumns; c++)
+		{
+			Columnar::Column column;
+			u_int64_t columnOffset;
+			read(name, Columnar::NAME_LENGTH);
+			column.name = name;
+			read(&column.type, sizeof(u_int32_t));
+			read(&skip, sizeof(u_int32_t));
+			read(&columnOffset, sizeof(u_int64_t));
+			read(&column.bytes, sizeof(u_int64_t));
+			column.rows = table.rows;
+			column.data = this->map + columnOffset;
+			if (columnOffset % sizeof(u_int64_t) != 0 || columnOffset > footer ||
+				column.bytes > footer - columnOffset || !valid_column(column))
+			{
+				std::cerr << "[Error] Broken columnar file (" << infile << ", column "
+						  << table.name << "." << column.name << ")." << std::endl;
+				std::exit(1);
+			}
+			table.columns.push_back(column);
+		}
+		this->tables.push_back(table);
+	}
+}
+
+/**
+ * @brief Destroy the Columnar Reader:: Columnar Reader object
+ *
+ */
+ColumnarReader::~ColumnarReader()
+{
+	munmap(const_cast<char *>(this->map), this->length);
+}
+
+/**
+ * @brief Find a table.
+ *
+ * @param name Table name
+ * @return Table (nullptr if not found)
+ */
+const Columnar::Table *ColumnarReader::table(const std::string &name) const
+{
+	for (auto itr = this->tables.begin(); itr != this->tables.end(); ++itr)
+	{
+		if (itr->name == name)
+		{
+			return &*itr;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Value of the "meta" table.
+ *
+ * @param key Key
+ * @return Value (empty if not found)
+ */
+std::string ColumnarReader::meta(const std::string &key) const
+{
+	const Columnar::Table *meta = this->table("meta");
+	if (meta)
+	{
+		const Columnar::Column &keys = meta->column("key", Columnar::STR);
+		const Columnar::Column &values = meta->column("value", Columnar::STR);
+		for (u_int64_t i = 0; i < meta->rows; i++)
+		{
+			if (keys.str(i) == key)
+			{
+				return std::string(values.str(i));
+			}
+		}
+	}
+	return "";
+}
+
+/**
+ * @brief Write the file in the text (TSV) format.
+ *
+ * @param outfile Output file
+ */
+void ColumnarReader::write_text(const std::string &outfile) const
+{
+	const std::string type = this->meta("type");
+	auto table = [this](const std::string &name)
+	{
+		const Columnar::Table *t = this->table(name);
+		if (!t)
+		{
+			std::cerr << "[Error] Table (" << name << ") is not found in (" << this->infile << ")." << std::endl;
+			std::exit(1);
+		}
+		return t;
+	};
+	ResultWriter ofs(outfile);
+
+	if (type == "statistics")
+	{
+		const Columnar::Table *stat = table("statistics");
+		const u_int32_t *pos = stat->column("pos", Columnar::U32).u32();
+		const Columnar::Column &seq = stat->column("seq", Columnar::STR);
+		const u_int32_t *mutant = stat->column("mutant", Columnar::U32).u32();
+		const u_int32_t *wildType = stat->column("wildtype", Columnar::U32).u32();
+		const double *gval = stat->column("gval", Columnar::F64).f64();
+		const double *pval = stat->column("pval", Columnar::F64).f64();
+		const double *fdr = stat->column("fdr", Columnar::F64).f64();
+		const double *bon = stat->column("bonferroni", Columnar::F64).f64();
+
+		ofs << "#K-mer\t" << this->meta("kmer") << '\n';
+		ofs << "#Pos\tSeq\tMutant\tWildType\tGval\tPval\tFDR\tBonferroni\n";
+		for (u_int64_t i = 0; i < stat->rows; i++)
+		{
+			ofs << pos[i] << "\t"
+				<< seq.str(i) << "\t"
+				<< mutant[i] << "\t"
+				<< wildType[i] << "\t"
+				<< (float)gval[i] << "\t"
+				<< (float)pval[i] << "\t"
+				<< (float)fdr[i] << "\t"
+				<< (float)bon[i] << '\n';
+		}
+	}
+	else if (type == "outside")
+	{
+		const Columnar::Table *kmer = table("kmer");
+		const u_int32_t *pos = kmer->column("pos", Columnar::U32).u32();
+		const u_int64_t *tableSize = kmer->column("table_size", Columnar::U64).u64();
+		const Columnar::Column &mer = kmer->column("mer", Columnar::STR);
+		const u_int32_t *mutant = kmer->column("mutant", Columnar::U32).u32();
+		const u_int32_t *wildType = kmer->column("wildtype", Columnar::U32).u32();
+		const double *gval = kmer->column("gval", Columnar::F64).f64();
+		const double *pval = kmer->column("pval", Columnar::F64).f64();
+		const double *fdr = kmer->column("fdr", Columnar::F64).f64();
+		const double *bon = kmer->column("bonferroni", Columnar::F64).f64();
+
+		const Columnar::Table *flank = table("flank");
+		const Columnar::Column &left = flank->column("left", Columnar::STR);
+		const Columnar::Column &right = flank->column("right", Columnar::STR);
+		const u_int32_t *flankMutant = flank->column("mutant", Columnar::U32).u32();
+		const u_int32_t *flankWildType = flank->column("wildtype", Columnar::U32).u32();
+		const double *flankGval = flank->column("gval", Columnar::F64).f64();
+		const double *flankPval = flank->column("pval", Columnar::F64).f64();
+		const double *flankFdr = flank->column("fdr", Columnar::F64).f64();
+		const double *flankBon = flank->column("bonferroni", Columnar::F64).f64();
+
+		ofs << "#K-mer\t" << this->meta("kmer")
+			<< "\tFDR\t" << this->meta("fdr")
+			<< "\tBases\t" << this->meta("bases") << '\n';
+		u_int64_t j = 0;
+		for (u_int64_t i = 0; i < kmer->rows; i++)
+		{
+			// The flank rows of each k-mer follow those of the k-mers before it.
+			if (tableSize[i] > flank->rows - j)
+			{
+				std::cerr << "[Error] Broken columnar file (" << this->infile << ", flank rows of k-mer "
+						  << i << ")." << std::endl;
+				std::exit(1);
+			}
+			const std::string_view merText = mer.str(i);
+			ofs << pos[i] << "\t"
+				<< tableSize[i] << "\t"
+				<< merText << "\t"
+				<< mutant[i] << "\t"
+				<< wildType[i] << "\t"
+				<< (float)gval[i] << "\t"
+				<< (float)pval[i] << "\t"
+				<< (float)fdr[i] << "\t"
+				<< (float)bon[i] << '\n';
+			for (u_int64_t n = 0; n < tableSize[i]; n++, j++)
+			{
+				const std::string_view leftText = left.str(j);
+				const std::string_view rightText = right.str(j);
+				ofs << leftText << "\t"
+					<< rightText << "\t"
+					<< flankMutant[j] << "\t"
+					<< flankWildType[j] << "\t"
+					<< leftText << merText << rightText << "\t"
+					<< (float)flankGval[j] << "\t"
+					<< (float)flankPval[j] << "\t"
+					<< (float)flankFdr[j] << "\t"
+					<< (float)flankBon[j] << '\n';
+			}
+		}
+	}
+	else if (type == "merFreq")
+	{
+		const Columnar::Table *freq = table("merFreq");
+		const Columnar::Column &mer = freq->column("mer", Columnar::STR);
+		const u_int32_t *count = freq->column("count", Columnar::U32).u32();
+		for (u_int64_t i = 0; i < freq->rows; i++)
+		{
+			ofs << mer.str(i) << '\t' << count[i] << '\n';
+		}
+	}
+	else
+	{
+		std::cerr << "[Error] Unknown columnar file type (" << type << ") in (" << this->infile << ")." << std::endl;
+		std::exit(1);
+	}
+	ofs.close();
+}
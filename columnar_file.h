@@ -0,0 +1,251 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef COLUMNAR_FILE_H_
+#define COLUMNAR_FILE_H_
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @brief Binary columnar result file (.gesc).
+ *
+ * Layout (little endian, see README.md):
+ *   header : magic "GESCOL01", u32 version, u32 0, u64 footer offset, u64 0
+ *   columns: data of each column, 8-byte aligned
+ *   footer : u32 number of tables, u32 0, then per table
+ *            {char name[32], u64 rows, u32 columns, u32 0} followed by
+ *            per column {char name[32], u32 type, u32 0, u64 offset, u64 bytes}
+ *   trailer: u64 footer offset, magic "GESCOL01"
+ *
+ * A STR column is (rows + 1) u64 offsets, relative to the end of the offset
+ * array, followed by the characters.
+ */
+namespace Columnar
+{
+	const char MAGIC[8] = {'G', 'E', 'S', 'C', 'O', 'L', '0', '1'};
+	const u_int32_t VERSION = 1;
+	const size_t NAME_LENGTH = 32;
+
+	/**
+	 * @brief Column types
+	 *
+	 */
+	enum Type : u_int32_t
+	{
+		U32 = 1,
+		U64 = 2,
+		F64 = 3,
+		STR = 4
+	};
+
+	/**
+	 * @brief Column of a mapped file.
+	 *
+	 */
+	struct Column
+	{
+		std::string name;
+		Type type;
+		u_int64_t rows;
+		const char *data;
+		u_int64_t bytes;
+
+		const u_int32_t *u32() const
+		{
+			return reinterpret_cast<const u_int32_t *>(this->data);
+		}
+
+		const u_int64_t *u64() const
+		{
+			return reinterpret_cast<const u_int64_t *>(this->data);
+		}
+
+		const double *f64() const
+		{
+			return reinterpret_cast<const double *>(this->data);
+		}
+
+		/**
+		 * @brief String of a row (STR column).
+		 *
+		 * @param row Row
+		 * @return String
+		 */
+		std::string_view str(const u_int64_t row) const
+		{
+			const u_int64_t *offset = this->u64();
+			const char *chars = this->data + (this->rows + 1) * sizeof(u_int64_t);
+			return std::string_view(chars + offset[row], offset[row + 1] - offset[row]);
+		}
+	};
+
+	/**
+	 * @brief Table of a mapped file.
+	 *
+	 */
+	struct Table
+	{
+		std::string name;
+		u_int64_t rows;
+		std::vector<Column> columns;
+
+		/**
+		 * @brief Find a column of a type.
+		 *
+		 * @param name Column name
+		 * @param type Column type
+		 * @return Column (exit if not found or of another type)
+		 */
+		const Column &column(const std::string &name, const Type type) const;
+	};
+}
+
+/**
+ * @brief Write a binary columnar file.
+ *
+ */
+class ColumnarWriter
+{
+public:
+	/**
+	 * @brief Construct a new Columnar Writer object
+	 *
+	 * @param outfile Output file
+	 */
+	ColumnarWriter(const std::string &outfile);
+
+	/**
+	 * @brief Destroy the Columnar Writer object
+	 *
+	 */
+	virtual ~ColumnarWriter();
+
+	/**
+	 * @brief Start a table. Columns added later belong to it.
+	 *
+	 * @param name Table name
+	 * @param rows Number of rows
+	 */
+	void add_table(const std::string &name, const u_int64_t rows);
+
+	void add_column(const std::string &name, const std::vector<u_int32_t> &values);
+
+	void add_column(const std::string &name, const std::vector<u_int64_t> &values);
+
+	void add_column(const std::string &name, const std::vector<double> &values);
+
+	void add_column(const std::string &name, const std::vector<std::string> &values);
+
+	/**
+	 * @brief Write the footer and close the file.
+	 *
+	 */
+	void close();
+
+private:
+	/**
+	 * @brief Output file
+	 *
+	 */
+	std::string outfile;
+
+	FILE *file;
+
+	/**
+	 * @brief Current file offset
+	 *
+	 */
+	u_int64_t offset;
+
+	/**
+	 * @brief Tables for the footer (data pointers unused)
+	 *
+	 */
+	std::vector<Columnar::Table> tables;
+
+	/**
+	 * @brief Write column data and register the column.
+	 *
+	 * @param name Column name
+	 * @param type Column type
+	 * @param rows Number of rows
+	 * @param data Bytes
+	 * @param bytes Number of bytes
+	 */
+	void write_column(const std::string &name, const Columnar::Type type, const u_int64_t rows,
+					  const void *data, const u_int64_t bytes);
+
+	/**
+	 * @brief Write bytes.
+	 *
+	 * @param data Bytes
+	 * @param bytes Number of bytes
+	 */
+	void write(const void *data, const u_int64_t bytes);
+};
+
+/**
+ * @brief Read a binary columnar file (memory mapped, read only).
+ *
+ */
+class ColumnarReader
+{
+public:
+	/**
+	 * @brief Construct a new Columnar Reader object
+	 *
+	 * @param infile Input file
+	 */
+	ColumnarReader(const std::string &infile);
+
+	/**
+	 * @brief Destroy the Columnar Reader object
+	 *
+	 */
+	virtual ~ColumnarReader();
+
+	/**
+	 * @brief Find a table.
+	 *
+	 * @param name Table name
+	 * @return Table (nullptr if not found)
+	 */
+	const Columnar::Table *table(const std::string &name) const;
+
+	/**
+	 * @brief Value of the "meta" table.
+	 *
+	 * @param key Key
+	 * @return Value (empty if not found)
+	 */
+	std::string meta(const std::string &key) const;
+
+	/**
+	 * @brief Write the file in the text (TSV) format.
+	 *
+	 * @param outfile Output file
+	 */
+	void write_text(const std::string &outfile) const;
+
+private:
+	/**
+	 * @brief Input file
+	 *
+	 */
+	std::string infile;
+
+	/**
+	 * @brief Mapped file
+	 *
+	 */
+	const char *map;
+	size_t length;
+
+	std::vector<Columnar::Table> tables;
+};
+#endif /* COLUMNAR_FILE_H_ */
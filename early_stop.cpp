@@ -0,0 +1,173 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include "early_stop.h"
+#include "gtest.h"
+#include "vector_sequence.h"
+
+/**
+ * @brief Complemented Poisson distribution.
+ *
+ * @param int k
+ * @param double Mean
+ *
+ * @return Probability of more than k
+ */
+extern "C" double pdtrc(int, double);
+
+namespace
+{
+	/**
+	 * @brief Position frequencies of a vector.
+	 *
+	 * @param merCounter Counter of each mer id
+	 * @param posIds Ids of the k-mer pair at each position
+	 * @return Position frequencies
+	 */
+	std::vector<unsigned int> pos_freq(const std::vector<unsigned int> &merCounter,
+									   const PositionIds &posIds)
+	{
+		std::vector<unsigned int> posFreq;
+		posFreq.reserve(posIds.size());
+		for (auto itr = posIds.begin(); itr != posIds.end(); ++itr)
+		{
+			posFreq.push_back((itr->first == MerIndex::NOT_FOUND ? 0 : merCounter[itr->first]) +
+							  (itr->second == MerIndex::NOT_FOUND ? 0 : merCounter[itr->second]));
+		}
+		return posFreq;
+	}
+}
+
+/**
+ * @brief Construct a new Early Stop:: Early Stop object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ * @param wildTypeCounts Counts of the wild type samples (one per k)
+ */
+EarlyStop::EarlyStop(Options *options, BitwiseOperation *bitwiseOperation,
+					 const std::vector<SampleCount> &wildTypeCounts)
+{
+	this->options = options;
+	this->bitwiseOperation = bitwiseOperation;
+
+	const unsigned int kmer = this->options->kmer;
+	for (auto itr = wildTypeCounts.begin(); itr != wildTypeCounts.end(); ++itr)
+	{
+		// Positions of each vector (in the order of the statistics files)
+		this->options->kmer = itr->kmer;
+		std::vector<PositionIds> posIds;
+		std::set<std::string> otherMers;
+		VectorSequence vectorSequence(this->options, bitwiseOperation);
+		vectorSequence.read_vectorFile(posIds, otherMers);
+
+		std::vector<unsigned int> wildTypeMerCounter(bitwiseOperation->get_merIndex()->size(), 0);
+		itr->add_merCounter(*bitwiseOperation->get_merIndex(), wildTypeMerCounter);
+
+		std::vector<std::vector<unsigned int>> wildTypePosFreq;
+		for (auto itr_pos = posIds.begin(); itr_pos != posIds.end(); ++itr_pos)
+		{
+			wildTypePosFreq.push_back(pos_freq(wildTypeMerCounter, *itr_pos));
+		}
+		this->vectorPosIds.push_back(posIds);
+		this->wildTypePosFreqs.push_back(wildTypePosFreq);
+		this->wildTypeMerTotals.push_back(itr->mer_total(0));
+	}
+	this->options->kmer = kmer;
+}
+
+/**
+ * @brief Destroy the Early Stop:: Early Stop object
+ *
+ */
+EarlyStop::~EarlyStop()
+{
+}
+
+/**
+ * @brief Decide on the running counts of the mutant samples.
+ *
+ * @param mutantCounts Counts of the mutant samples so far (one per k)
+ * @return DETECTED when a k is detected, ABSENT when every k is absent, otherwise UNDECIDED
+ */
+EarlyStop::Decision EarlyStop::decide(const std::vector<SampleCount> &mutantCounts)
+{
+	std::ostringstream ostr;
+	bool detected = false;
+	bool absent = true;
+	for (size_t n = 0; n < mutantCounts.size(); n++)
+	{
+		const SampleCount &mutantCount = mutantCounts[n];
+		const u_int64_t mutantMerTotal = mutantCount.mer_total(0);
+		ostr << (n > 0 ? ", " : "") << "K-mer = " << mutantCount.kmer;
+		if (mutantMerTotal == 0 || this->wildTypeMerTotals[n] == 0)
+		{
+			ostr << ": no mer";
+			absent = false;
+			continue;
+		}
+
+		// Mutant counter of each mer id
+		const MerIndex *merIndex = this->bitwiseOperation->get_merIndex(mutantCount.kmer);
+		std::vector<unsigned int> mutantMerCounter(merIndex->size(), 0);
+		mutantCount.add_merCounter(*merIndex, mutantMerCounter);
+
+		// Most positions detected in a vector
+		unsigned int positions = 0;
+		size_t vector_len = 0;
+		for (size_t e = 0; e < this->vectorPosIds[n].size(); e++)
+		{
+			const PositionIds &posIds = this->vectorPosIds[n][e];
+			const std::vector<unsigned int> mutantPosFreq = pos_freq(mutantMerCounter, posIds);
+
+			Gtest gtest(this->options);
+			gtest.set_merCounter(mutantMerTotal, this->wildTypeMerTotals[n]);
+			gtest.kmer_match(mutantPosFreq, this->wildTypePosFreqs[n][e]);
+			const std::vector<double> &fdr = gtest.get_fdr();
+			positions = std::max(positions, (unsigned int)std::count_if(
+												fdr.begin(), fdr.end(), [&](const double f)
+												{ return f <= this->options->threshold_fdr; }));
+			vector_len = std::max(vector_len, posIds.size());
+		}
+		ostr << ": " << positions << " positions detected";
+		if (positions >= this->options->early_positions)
+		{
+			detected = true;
+			continue;
+		}
+		if (positions > 0 || this->options->genome_size <= 0.0 || vector_len == 0)
+		{
+			absent = false;
+			continue;
+		}
+
+		// Smallest mutant count called at a position not in the wild type
+		// (Bonferroni over the positions, the worst case of the FDR).
+		Gtest gtest(this->options);
+		gtest.set_merCounter(mutantMerTotal, this->wildTypeMerTotals[n]);
+		unsigned int min_count = 1;
+		while (std::get<1>(gtest.kmer_extension(min_count, 0)) * vector_len > this->options->threshold_fdr)
+		{
+			if (++min_count > mutantMerTotal)
+			{
+				break;
+			}
+		}
+
+		// Mean count at a position of an insert of the target copies
+		const double depth = this->options->copies * mutantMerTotal / this->options->genome_size;
+		const double power = depth > 0.0 ? pdtrc(min_count - 1, depth) : 0.0;
+		ostr << ", power " << power << " (" << min_count << " needed, mean " << depth << ")";
+		if (power < this->options->power)
+		{
+			absent = false;
+		}
+	}
+
+	this->reason = ostr.str();
+	return detected ? DETECTED : (absent ? ABSENT : UNDECIDED);
+}
@@ -0,0 +1,109 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef EARLY_STOP_H_
+#define EARLY_STOP_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "bitwise_operation.h"
+#include "sample_count.h"
+
+/**
+ * @brief Decision rule of the sequential mode (-e).
+ *
+ * The G-test of the match analysis is run on the running counts of the
+ * mutant samples against the counts of the wild type samples. A k-mer is
+ * decided as detected when a vector has at least early_positions positions
+ * at FDR <= threshold, or as absent when none is detected and an insert of
+ * the target copies would have been detected at each of its positions with
+ * the target power (Poisson depth of the mutant reads, genome_size).
+ */
+class EarlyStop
+{
+public:
+	/**
+	 * @brief Decision on the counts so far
+	 *
+	 */
+	enum Decision
+	{
+		UNDECIDED,
+		DETECTED,
+		ABSENT
+	};
+
+	/**
+	 * @brief Construct a new Early Stop object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 * @param wildTypeCounts Counts of the wild type samples (one per k)
+	 */
+	EarlyStop(Options *options, BitwiseOperation *bitwiseOperation,
+			  const std::vector<SampleCount> &wildTypeCounts);
+
+	/**
+	 * @brief Destroy the Early Stop object
+	 *
+	 */
+	virtual ~EarlyStop();
+
+	/**
+	 * @brief Decide on the running counts of the mutant samples.
+	 *
+	 * @param mutantCounts Counts of the mutant samples so far (one per k)
+	 * @return DETECTED when a k is detected, ABSENT when every k is absent, otherwise UNDECIDED
+	 */
+	Decision decide(const std::vector<SampleCount> &mutantCounts);
+
+	/**
+	 * @brief Reason of the last decision for the log.
+	 *
+	 * @return Detected positions or power of each k
+	 */
+	const std::string &get_reason() const
+	{
+		return this->reason;
+	}
+
+private:
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Bitwise operation (k-mer index of each k).
+	 *
+	 */
+	BitwiseOperation *bitwiseOperation;
+
+	/**
+	 * @brief Ids of the k-mer pairs (forward and reverse complement) of the positions of each vector, by k
+	 *
+	 */
+	std::vector<std::vector<PositionIds>> vectorPosIds;
+
+	/**
+	 * @brief Position frequencies of the wild type samples of each vector, by k
+	 *
+	 */
+	std::vector<std::vector<std::vector<unsigned int>>> wildTypePosFreqs;
+
+	/**
+	 * @brief Count of the wild type total mer, by k
+	 *
+	 */
+	std::vector<u_int64_t> wildTypeMerTotals;
+
+	/**
+	 * @brief Reason of the last decision
+	 *
+	 */
+	std::string reason;
+};
+#endif /* EARLY_STOP_H_ */
@@ -0,0 +1,375 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <iostream>
+#include <zlib.h>
+#include "fastq_count.h"
+#include "probes.h"
+#include "read_sampler.h"
+
+/**
+ * @brief Construct a new Fastq Count:: Fastq Count object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ */
+FastqCount::FastqCount(Options *options, BitwiseOperation *bitwiseOperation)
+{
+	this->options = options;
+	this->bitwiseOperation = bitwiseOperation;
+}
+
+/**
+ * @brief Destroy the Fastq Count:: Fastq Count object
+ *
+ */
+FastqCount::~FastqCount()
+{
+}
+
+/**
+ * @brief Read the fastq.gz file.
+ *
+ * The k-mers of every k (-k 16,20,...) are counted in the same pass, and
+ * the hash of the lines read is kept in content_hash of the counts.
+ *
+ * @param fastqFile FASTQ file
+ * @param sampleCounts Counts of the file (one per k, kmer set)
+ * @param offset Resume the scan at this (uncompressed) offset of a checkpoint
+ * @param checkpoint Called with the offset after each block of reads; false stops the scan (nullptr: none)
+ */
+void FastqCount::read_fastqFile(const std::string &fastqFile, std::vector<SampleCount> &sampleCounts,
+								const u_int64_t offset,
+								const std::function<bool(u_int64_t)> &checkpoint) const
+{
+	// File mode
+	const gzFile file = gzopen(fastqFile.c_str(), "rb");
+	if (!file)
+	{
+		std::cerr << "[Error] Could not open (" << fastqFile << ")." << std::endl;
+		std::exit(1);
+	}
+
+	// The blocks of reads are taken from the node of this thread (--numa).
+	this->options->numa.place();
+
+	// Reads shorter than the shortest k are skipped.
+	unsigned int kmerLen = this->options->MAX_KMER;
+	for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+	{
+		kmerLen = std::min(kmerLen, itr->kmer);
+	}
+	const unsigned int max_buff = this->options->max_read_length + 2;
+	char buff[max_buff];
+	std::string aLine[4];
+	unsigned int nLine = 0;
+	u_int64_t readCounter = 0;
+	std::vector<std::string> fastqData;
+	const ReadSampler sampler(this->options->fraction);
+
+	// Byte range of the shard (-s): the records starting in it are counted.
+	const bool shard = this->options->shards > 0;
+	const u_int64_t end = shard ? this->seek_shard(file, fastqFile, buff, max_buff) : 0;
+
+	// Hash of the lines read (continued from a checkpoint)
+	u_int64_t content_hash = sampleCounts.front().content_hash;
+
+	// Resume a checkpoint (the reads before offset are in sampleCounts). The checkpoint keeps
+	// no access point of a gzip file, so gzseek decompresses the prefix again (without
+	// parsing or counting it, a small part of the time of the scan).
+	if (offset > 0)
+	{
+		if (gzseek(file, offset, SEEK_SET) < 0)
+		{
+			std::cerr << "[Error] Could not resume (" << fastqFile << ") at " << offset << "." << std::endl;
+			std::exit(1);
+		}
+		for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+		{
+			readCounter = std::max(readCounter, itr->reads());
+		}
+	}
+
+	// Time of gzgets and of the records (the counting is the scan phase).
+	Metrics::Stopwatch parse;
+	Metrics::Counters counters;
+	Trace::Span read(this->options->trace, "read", fastqFile);
+	const u_int64_t start_in = gzoffset(file);
+	const u_int64_t start_out = gztell(file);
+	Progress::File &progress = this->options->progress.open(
+		fastqFile, "k-mer count", shard ? end : Metrics::file_size(fastqFile), readCounter, start_in);
+
+	bool next = true;
+	while (next && (!shard || nLine != 0 || (u_int64_t)gztell(file) < end) && gzgets(file, buff, max_buff) != Z_NULL)
+	{
+		aLine[nLine] = std::string(buff);
+		content_hash = SampleCount::hash(aLine[nLine].data(), aLine[nLine].length(), content_hash);
+		if (++nLine == 4)
+		{
+			nLine = 0;
+			if ((++counters.reads & 0xfff) == 0)
+			{
+				// gzoffset is a system call: the progress is set every 4096 reads.
+				const u_int64_t offset = gzoffset(file);
+				progress.update(readCounter + counters.reads, offset);
+				GENEDITSCAN_PROBE4(parse, fastqFile.c_str(), readCounter + counters.reads, offset, (u_int64_t)gztell(file));
+			}
+			if (aLine[0][0] != '@' || aLine[2][0] != '+')
+			{
+				aLine[0].pop_back();
+				std::cerr << "[Error] Could not get sequence (" << aLine[0] << ")." << std::endl;
+				exit(1);
+			}
+			else
+			{
+				if (aLine[1].length() > kmerLen && sampler.keep(aLine[0]))
+				{
+					// Delete line break (\n)
+					aLine[1].pop_back();
+					fastqData.push_back(aLine[1]);
+					if (fastqData.size() > this->options->fastq_read_lines)
+					{
+						parse.stop();
+						read.stop();
+						this->count_sample(fastqFile, fastqData, sampleCounts, progress);
+						fastqData.clear();
+						if (checkpoint)
+						{
+							for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+							{
+								itr->content_hash = content_hash;
+							}
+							next = checkpoint(gztell(file));
+						}
+						parse.start();
+						read.start();
+					}
+				}
+			}
+		}
+	}
+
+	parse.stop();
+	read.stop();
+	counters.bytes_in = gzoffset(file) - start_in;
+	counters.bytes_out = gztell(file) - start_out;
+	this->options->metrics.add("decompress_parse", fastqFile, parse.stop(counters));
+	progress.update(readCounter + counters.reads, gzoffset(file));
+
+	this->count_sample(fastqFile, fastqData, sampleCounts, progress);
+	fastqData.clear();
+	for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+	{
+		itr->content_hash = content_hash;
+	}
+	this->options->progress.close(progress);
+	gzclose(file);
+}
+
+/**
+ * @brief Count k-mer and the bases on each side.
+ *
+ * @param fastqFile FASTQ file
+ * @param fastqData FASTQ data
+ * @param sampleCounts Counts of the file (one per k)
+ * @param progress Progress of the file
+ */
+void FastqCount::count_sample(
+	const std::string &fastqFile, std::vector<std::string> &fastqData,
+	std::vector<SampleCount> &sampleCounts, Progress::File &progress) const
+{
+	const unsigned int nbase = this->options->bases_on_each_side;
+	std::vector<const MerIndex *> merIndexes;
+	for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+	{
+		merIndexes.push_back(this->bitwiseOperation->get_merIndex(itr->kmer));
+	}
+	const size_t nKmer = merIndexes.size();
+
+	GENEDITSCAN_PROBE2(batch_start, fastqFile.c_str(), fastqData.size());
+
+	// Counts of the block (by k and mer id), added by each thread
+	typedef std::unordered_map<u_int32_t, std::map<std::pair<std::string, std::string>, unsigned int>> FlankIdCounter;
+	std::vector<std::map<unsigned int, u_int64_t>> blockReadLength(nKmer);
+	std::vector<std::vector<unsigned int>> blockMerIdCounter(nKmer);
+	std::vector<FlankIdCounter> blockFlankIdCounter(nKmer);
+	for (size_t n = 0; n < nKmer; n++)
+	{
+		blockMerIdCounter[n].assign(merIndexes[n]->size(), 0);
+	}
+
+	// Metrics of the scan (CPU time summed over the threads)
+	Metrics::Stopwatch scan;
+	u_int64_t windows = 0, passes = 0, hits = 0;
+	double cpu_seconds = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(this->options->inner_parallel) reduction(+ : windows, passes, hits, cpu_seconds)
+#endif
+	{
+		const double cpu_start = Metrics::thread_cpu_time();
+		Trace::Span threadScan(this->options->trace, "scan", fastqFile);
+
+		// Index copies of the node of this thread (--numa)
+		const unsigned int node = this->options->numa.place();
+		std::vector<const MerIndex *> nodeIndexes;
+		for (size_t n = 0; n < nKmer; n++)
+		{
+			nodeIndexes.push_back(this->bitwiseOperation->get_merIndex(sampleCounts[n].kmer, node));
+		}
+
+		// Counts of this thread (by k and mer id)
+		std::vector<std::map<unsigned int, u_int64_t>> readLength(nKmer);
+		std::vector<std::vector<unsigned int>> merIdCounter(nKmer);
+		std::vector<FlankIdCounter> flankIdCounter(nKmer);
+		for (size_t n = 0; n < nKmer; n++)
+		{
+			merIdCounter[n].assign(merIndexes[n]->size(), 0);
+		}
+
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+		for (size_t i = 0; i < fastqData.size(); i++)
+		{
+			const std::string &read = fastqData[i];
+			const size_t length = read.length();
+			for (size_t n = 0; n < nKmer; n++)
+			{
+				if (length >= sampleCounts[n].kmer)
+				{
+					readLength[n][length]++;
+				}
+			}
+
+			const MerIndex::ScanCount count = MerIndex::scan(
+				read, nodeIndexes, [&](const size_t n, const size_t j, const u_int32_t id)
+				{
+					const size_t kmer = sampleCounts[n].kmer;
+					merIdCounter[n][id]++;
+					GENEDITSCAN_PROBE2(hit, id, j);
+					// Bases on each side, clipped at the ends of the read
+					const size_t p5_length = std::min(j, (size_t)nbase);
+					const size_t p3_length = std::min(length - kmer - j, (size_t)nbase);
+					flankIdCounter[n][id][std::make_pair(
+						read.substr(j - p5_length, p5_length),
+						read.substr(j + kmer, p3_length))]++; });
+			GENEDITSCAN_PROBE3(read_scan, count.windows, count.passes, count.hits);
+			windows += count.windows;
+			passes += count.passes;
+			hits += count.hits;
+		}
+		threadScan.stop();
+
+		for (size_t n = 0; n < nKmer; n++)
+		{
+			Trace::Span wait(this->options->trace, "wait countMerge", fastqFile);
+#ifdef _OPENMP
+#pragma omp critical(countMerge)
+#endif
+			{
+				wait.stop();
+				Trace::Span merge(this->options->trace, "countMerge", fastqFile);
+				for (auto itr = readLength[n].begin(); itr != readLength[n].end(); ++itr)
+				{
+					blockReadLength[n][itr->first] += itr->second;
+				}
+				for (size_t id = 0; id < merIdCounter[n].size(); id++)
+				{
+					blockMerIdCounter[n][id] += merIdCounter[n][id];
+				}
+				for (auto itr = flankIdCounter[n].begin(); itr != flankIdCounter[n].end(); ++itr)
+				{
+					std::map<std::pair<std::string, std::string>, unsigned int> &flanks = blockFlankIdCounter[n][itr->first];
+					for (auto itr_flank = itr->second.begin(); itr_flank != itr->second.end(); ++itr_flank)
+					{
+						flanks[itr_flank->first] += itr_flank->second;
+					}
+				}
+			}
+		}
+		cpu_seconds += Metrics::thread_cpu_time() - cpu_start;
+	}
+
+	// Counts of the block by id and 2-bit code, added to the counts of the file
+	{
+		Trace::Span merge(this->options->trace, "countMerge", fastqFile);
+		for (size_t n = 0; n < nKmer; n++)
+		{
+			SampleCount blockCount;
+			blockCount.readLength = blockReadLength[n];
+			blockCount.set_counts(*merIndexes[n], blockMerIdCounter[n], blockFlankIdCounter[n]);
+			sampleCounts[n].merge(blockCount);
+		}
+	}
+
+	Metrics::Counters counters;
+	counters.reads = fastqData.size();
+	counters.windows = windows;
+	counters.prefilter_pass = passes;
+	counters.hits = hits;
+	scan.stop(counters).cpu_seconds = cpu_seconds;
+	this->options->metrics.add("scan", fastqFile, counters);
+	progress.add_scan(windows, hits);
+	GENEDITSCAN_PROBE4(batch_end, fastqFile.c_str(), fastqData.size(), windows, hits);
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Move to the first record of the shard of an uncompressed FASTQ file.
+ *
+ * The file is split into equal byte ranges; a shard holds the records that
+ * start in its range, so the shards of a file together hold every record once.
+ *
+ * @param file FASTQ file handle
+ * @param fastqFile FASTQ file
+ * @param buff Line buffer
+ * @param max_buff Size of the line buffer
+ * @return End of the byte range
+ */
+u_int64_t FastqCount::seek_shard(const gzFile file, const std::string &fastqFile,
+								 char *buff, const unsigned int max_buff) const
+{
+	if (!gzdirect(file))
+	{
+		std::cerr << "[Error] A shard (-s) needs an uncompressed FASTQ file (" << fastqFile << ")." << std::endl;
+		std::exit(1);
+	}
+	const u_int64_t size = std::filesystem::file_size(fastqFile);
+	const u_int64_t begin = size * (this->options->shard - 1) / this->options->shards;
+	const u_int64_t end = size * this->options->shard / this->options->shards;
+	if (begin == 0)
+	{
+		return end;
+	}
+
+	// Skip the rest of the line running into the range.
+	gzseek(file, begin - 1, SEEK_SET);
+	gzgets(file, buff, max_buff);
+
+	// A record starts at a line beginning with '@' followed two lines later by
+	// a line beginning with '+' (a quality line may also begin with '@').
+	std::vector<std::pair<z_off_t, char>> lines;
+	for (;;)
+	{
+		while (lines.size() < 3)
+		{
+			const z_off_t pos = gztell(file);
+			if (gzgets(file, buff, max_buff) == Z_NULL)
+			{
+				return end;
+			}
+			lines.push_back(std::make_pair(pos, buff[0]));
+		}
+		if (lines[0].second == '@' && lines[2].second == '+')
+		{
+			gzseek(file, lines[0].first, SEEK_SET);
+			return end;
+		}
+		lines.erase(lines.begin());
+	}
+}
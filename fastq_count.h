@@ -0,0 +1,87 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef FASTQ_COUNT_H_
+#define FASTQ_COUNT_H_
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <zlib.h>
+#include "bitwise_operation.h"
+#include "sample_count.h"
+
+/**
+ * @brief Input the read data for the count stage (match and extension at once).
+ */
+class FastqCount
+{
+public:
+	/**
+	 * @brief Construct a new Fastq Count object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 */
+	FastqCount(Options *options, BitwiseOperation *bitwiseOperation);
+
+	/**
+	 * @brief Destroy the Fastq Count object
+	 *
+	 */
+	virtual ~FastqCount();
+
+	/**
+	 * @brief Read the fastq.gz file.
+	 *
+	 * The k-mers of every k (-k 16,20,...) are counted in the same pass, and
+	 * the hash of the lines read is kept in content_hash of the counts.
+	 *
+	 * @param fastqFile FASTQ file
+	 * @param sampleCounts Counts of the file (one per k, kmer set)
+	 * @param offset Resume the scan at this (uncompressed) offset of a checkpoint
+	 * @param checkpoint Called with the offset after each block of reads; false stops the scan (nullptr: none)
+	 */
+	void read_fastqFile(const std::string &fastqFile, std::vector<SampleCount> &sampleCounts,
+						const u_int64_t offset = 0,
+						const std::function<bool(u_int64_t)> &checkpoint = nullptr) const;
+
+	/**
+	 * @brief Count k-mer and the bases on each side.
+	 *
+	 * @param fastqFile FASTQ file
+	 * @param fastqData FASTQ data
+	 * @param sampleCounts Counts of the file (one per k)
+	 * @param progress Progress of the file
+	 */
+	void count_sample(
+		const std::string &fastqFile, std::vector<std::string> &fastqData,
+		std::vector<SampleCount> &sampleCounts, Progress::File &progress) const;
+
+private:
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Bitwise operation.
+	 *
+	 */
+	BitwiseOperation *bitwiseOperation;
+
+	/**
+	 * @brief Move to the first record of the shard of an uncompressed FASTQ file.
+	 *
+	 * @param file FASTQ file handle
+	 * @param fastqFile FASTQ file
+	 * @param buff Line buffer
+	 * @param max_buff Size of the line buffer
+	 * @return End of the byte range
+	 */
+	u_int64_t seek_shard(const gzFile file, const std::string &fastqFile,
+						 char *buff, const unsigned int max_buff) const;
+};
+#endif /* FASTQ_COUNT_H_ */
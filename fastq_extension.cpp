@@ -5,6 +5,8 @@
 #include <iostream>
 #include <zlib.h>
 #include "fastq_extension.h"
+#include "probes.h"
+#include "read_sampler.h"
 
 /**
  * @brief Construct a new Fastq Extension:: Fastq Extension object
@@ -47,6 +49,9 @@ std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>
         std::exit(1);
     }
 
+    // The blocks of reads are taken from the node of this thread (--numa).
+    this->options->numa.place();
+
 #ifdef _OPENMP
 #pragma omp single nowait
 #endif
@@ -58,9 +63,15 @@ std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>
     char buff[max_buff];
     std::string aLine[4];
     unsigned int nLine = 0;
-    u_int64_t readCounter = 0;
     std::vector<std::string> fastqData;
     std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> merLocalPair;
+    const ReadSampler sampler(this->options->fraction);
+
+    // Time of gzgets and of the records (the counting is the outside_scan phase).
+    Metrics::Stopwatch parse;
+    Metrics::Counters counters;
+    Trace::Span read(this->options->trace, "read", fastqFile);
+    Progress::File &progress = this->options->progress.open(fastqFile, "k-mer extension", Metrics::file_size(fastqFile));
 
     while (gzgets(file, buff, max_buff) != Z_NULL)
     {
@@ -68,24 +79,43 @@ std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>
         if (nLine == 4)
         {
             nLine = 0;
-            if (aLine[1].length() > kmer + nbase * 2)
+            if ((++counters.reads & 0xfff) == 0)
+            {
+                // gzoffset is a system call: the progress is set every 4096 reads.
+                const u_int64_t offset = gzoffset(file);
+                progress.update(counters.reads, offset);
+                GENEDITSCAN_PROBE4(parse, fastqFile.c_str(), counters.reads, offset, (u_int64_t)gztell(file));
+            }
+            if (aLine[1].length() > kmer + nbase * 2 && sampler.keep(aLine[0]))
             {
                 // Delete line break (\n)
                 aLine[1].pop_back();
                 fastqData.push_back(aLine[1]);
                 if (fastqData.size() > this->options->fastq_read_lines)
                 {
-                    this->count_extension(fastqFile, fastqData, merCounter,
-                                          merLocalPair, merTotalCounter, readCounter);
+                    parse.stop();
+                    read.stop();
+                    this->count_extension(fastqFile, fastqData, merLocalPair,
+                                          merTotalCounter, progress);
                     fastqData.clear();
+                    parse.start();
+                    read.start();
                 }
             }
         }
     }
 
-    this->count_extension(fastqFile, fastqData, merCounter, merLocalPair,
-                          merTotalCounter, readCounter);
+    parse.stop();
+    read.stop();
+    counters.bytes_in = gzoffset(file);
+    counters.bytes_out = gztell(file);
+    this->options->metrics.add("decompress_parse", fastqFile, parse.stop(counters));
+    progress.update(counters.reads, counters.bytes_in);
+
+    this->count_extension(fastqFile, fastqData, merLocalPair,
+                          merTotalCounter, progress);
     fastqData.clear();
+    this->options->progress.close(progress);
     gzclose(file);
     return merLocalPair;
 }
@@ -98,69 +128,87 @@ std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>
  *
  * @param fastqFile FASTQ file
  * @param fastqData FASTQ data
- * @param merCounter Mer counter at each end
  * @param merLocalPair Mer pairs at each end for parallel processing
  * @param merTotalCounter Mer total counter per file
- * @param readCounter Read counter per file
+ * @param progress Progress of the file
  */
 void FastqExtension::count_extension(
     const std::string &fastqFile, std::vector<std::string> &fastqData,
-    const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merCounter,
     std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merLocalPair,
-    u_int64_t &merTotalCounter, u_int64_t &readCounter) const
+    u_int64_t &merTotalCounter, Progress::File &progress) const
 {
     const unsigned int kmer = this->options->kmer;
     const unsigned int nbase = this->options->bases_on_each_side;
-    const unsigned int mask = this->options->max_chunk_array;
-    const unsigned int chunk_length = this->options->chunk_length;
-    unsigned char *dna2bit = this->bitwiseOperation->get_dna2bit();
-    unsigned char *chunk = this->bitwiseOperation->get_chunk();
-    unsigned int dnabit, j;
-    std::string mer, p5, p3;
+    const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+
+    GENEDITSCAN_PROBE2(batch_start, fastqFile.c_str(), fastqData.size());
+
+    // Metrics of the scan (CPU time summed over the threads)
+    Metrics::Stopwatch scan;
+    u_int64_t windows = 0, passes = 0, hits = 0;
+    double cpu_seconds = 0.0;
 
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(this->options->inner_parallel) private(dnabit, j, mer, p5, p3) \
-    reduction(+ : merTotalCounter)
+#pragma omp parallel num_threads(this->options->inner_parallel) \
+    reduction(+ : merTotalCounter, windows, passes, hits, cpu_seconds)
 #endif
-    for (size_t i = 0; i < fastqData.size(); i++)
     {
-#ifdef _OPENMP
-#pragma omp critical(extension)
-#endif
-        if (++readCounter % this->options->log_output_interval == 0)
-        {
-            std::cerr << fastqFile << ": parsing " << readCounter << " reads (k-mer extension)." << std::endl;
-        }
+        const double cpu_start = Metrics::thread_cpu_time();
+        Trace::Span threadScan(this->options->trace, "outside_scan", fastqFile);
 
-        dnabit = dna2bit[(unsigned char)fastqData[i][0]];
-        for (j = 1; j < chunk_length - 1; j++)
-        {
-            dnabit = (dnabit << 2) + dna2bit[(unsigned char)fastqData[i][j]];
-        }
+        // Index copy of the node of this thread (--numa)
+        const MerIndex *nodeIndex = this->bitwiseOperation->get_merIndex(kmer, this->options->numa.place());
 
-        for (j = 0; j < nbase; j++)
-        {
-            dnabit = (dnabit << 2) + dna2bit[(unsigned char)fastqData[i][chunk_length - 1 + j]];
-        }
+        // Mer pairs of each mer id of this thread
+        std::unordered_map<u_int32_t, std::vector<std::pair<std::string, std::string>>> threadPair;
 
-        for (j = nbase; j <= fastqData[i].length() - kmer - nbase; j++)
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+        for (size_t i = 0; i < fastqData.size(); i++)
         {
-            dnabit = (dnabit << 2) + dna2bit[(unsigned char)fastqData[i][chunk_length - 1 + j]];
-            dnabit = dnabit & mask;
-            if (chunk[dnabit] == 1 || dnabit == mask)
-            {
-                mer.assign(fastqData[i], j, kmer);
-                if (merCounter.find(mer) != merCounter.end())
+            const std::string &read = fastqData[i];
+            const size_t last = read.length() - kmer - nbase;
+            const MerIndex::ScanCount count = nodeIndex->scan(
+                read, [&](const size_t j, const u_int32_t id)
                 {
-                    p5 = fastqData[i].substr(j - nbase, nbase);
-                    p3 = fastqData[i].substr(j + kmer, nbase);
+                    GENEDITSCAN_PROBE2(hit, id, j);
+                    if (j >= nbase && j <= last)
+                    {
+                        threadPair[id].push_back(std::make_pair(
+                            read.substr(j - nbase, nbase), read.substr(j + kmer, nbase)));
+                    } });
+            GENEDITSCAN_PROBE3(read_scan, count.windows, count.passes, count.hits);
+            merTotalCounter += last - nbase + 1;
+            windows += count.windows;
+            passes += count.passes;
+            hits += count.hits;
+        }
+        threadScan.stop();
+
+        Trace::Span wait(this->options->trace, "wait push", fastqFile);
 #ifdef _OPENMP
 #pragma omp critical(push)
 #endif
-                    merLocalPair[mer].push_back(std::make_pair(p5, p3));
-                }
+        {
+            wait.stop();
+            Trace::Span push(this->options->trace, "push", fastqFile);
+            for (auto itr = threadPair.begin(); itr != threadPair.end(); ++itr)
+            {
+                std::vector<std::pair<std::string, std::string>> &pair = merLocalPair[merIndex->mer(itr->first)];
+                pair.insert(pair.end(), itr->second.begin(), itr->second.end());
             }
-            merTotalCounter++;
         }
+        cpu_seconds += Metrics::thread_cpu_time() - cpu_start;
     }
+
+    Metrics::Counters counters;
+    counters.reads = fastqData.size();
+    counters.windows = windows;
+    counters.prefilter_pass = passes;
+    counters.hits = hits;
+    scan.stop(counters).cpu_seconds = cpu_seconds;
+    this->options->metrics.add("outside_scan", fastqFile, counters);
+    progress.add_scan(windows, hits);
+    GENEDITSCAN_PROBE4(batch_end, fastqFile.c_str(), fastqData.size(), windows, hits);
 }
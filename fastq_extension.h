@@ -61,15 +61,13 @@ private:
 	 *
 	 * @param fastqFile FASTQ file
 	 * @param fastqData FASTQ data
-	 * @param merPair Mer pairs at each end
 	 * @param merLocalPair Mer pairs at each end for parallel processing
 	 * @param merTotalCounter Mer total counter per file
-	 * @param readCounter Read counter per file
+	 * @param progress Progress of the file
 	 */
 	void count_extension(
 		const std::string &fastqFile, std::vector<std::string> &fastqData,
-		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merPair,
 		std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merLocalPair,
-		u_int64_t &merTotalCounter, u_int64_t &readCounter) const;
+		u_int64_t &merTotalCounter, Progress::File &progress) const;
 };
 #endif /* FASTQ_EXTENSION_ */
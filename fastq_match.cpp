@@ -5,6 +5,8 @@
 #include <iostream>
 #include <zlib.h>
 #include "fastq_match.h"
+#include "probes.h"
+#include "read_sampler.h"
 
 /**
  * @brief Construct a new Fastq Match:: Fastq Match object
@@ -29,15 +31,14 @@ FastqMatch::~FastqMatch()
 /**
  * @brief Read the fastq.gz file.
  *
+ * The k-mers are searched with the k-mer index of bitwiseOperation.
+ *
  * @param fastqFile FASTQ file
- * @param merCounter Counter of each mer
  * @param merTotalCounter Mer total counter per file
- * @return Counter of each mer for parallel processing
+ * @return Counter of each mer id for parallel processing
  */
-std::unordered_map<std::string, unsigned int> FastqMatch::read_fastqFile(
-	const std::string &fastqFile,
-	const std::unordered_map<std::string, unsigned int> &merCounter,
-	u_int64_t &merTotalCounter) const
+std::vector<unsigned int> FastqMatch::read_fastqFile(
+	const std::string &fastqFile, u_int64_t &merTotalCounter) const
 {
 	// File mode
 	const gzFile file = gzopen(fastqFile.c_str(), "rb");
@@ -47,14 +48,23 @@ std::unordered_map<std::string, unsigned int> FastqMatch::read_fastqFile(
 		std::exit(1);
 	}
 
+	// The blocks of reads are taken from the node of this thread (--numa).
+	this->options->numa.place();
+
 	const unsigned int kmerLen = this->options->kmer;
 	const unsigned int max_buff = this->options->max_read_length + 2;
 	char buff[max_buff];
 	std::string aLine[4];
 	unsigned int nLine = 0;
-	u_int64_t readCounter = 0;
 	std::vector<std::string> fastqData;
-	std::unordered_map<std::string, unsigned int> merLocalCounter;
+	std::vector<unsigned int> merLocalCounter(this->bitwiseOperation->get_merIndex()->size(), 0);
+	const ReadSampler sampler(this->options->fraction);
+
+	// Time of gzgets and of the records (the counting is the scan phase).
+	Metrics::Stopwatch parse;
+	Metrics::Counters counters;
+	Trace::Span read(this->options->trace, "read", fastqFile);
+	Progress::File &progress = this->options->progress.open(fastqFile, "k-mer match", Metrics::file_size(fastqFile));
 
 	while (gzgets(file, buff, max_buff) != Z_NULL)
 	{
@@ -62,6 +72,13 @@ std::unordered_map<std::string, unsigned int> FastqMatch::read_fastqFile(
 		if (nLine == 4)
 		{
 			nLine = 0;
+			if ((++counters.reads & 0xfff) == 0)
+			{
+				// gzoffset is a system call: the progress is set every 4096 reads.
+				const u_int64_t offset = gzoffset(file);
+				progress.update(counters.reads, offset);
+				GENEDITSCAN_PROBE4(parse, fastqFile.c_str(), counters.reads, offset, (u_int64_t)gztell(file));
+			}
 			if (aLine[0][0] != '@' || aLine[2][0] != '+')
 			{
 				aLine[0].pop_back();
@@ -70,25 +87,37 @@ std::unordered_map<std::string, unsigned int> FastqMatch::read_fastqFile(
 			}
 			else
 			{
-				if (aLine[1].length() > kmerLen)
+				if (aLine[1].length() > kmerLen && sampler.keep(aLine[0]))
 				{
 					// Delete line break (\n)
 					aLine[1].pop_back();
 					fastqData.push_back(aLine[1]);
 					if (fastqData.size() > this->options->fastq_read_lines)
 					{
-						this->count_match(fastqFile, fastqData, merCounter,
-										  merLocalCounter, merTotalCounter, readCounter);
+						parse.stop();
+						read.stop();
+						this->count_match(fastqFile, fastqData, merLocalCounter,
+										  merTotalCounter, progress);
 						fastqData.clear();
+						parse.start();
+						read.start();
 					}
 				}
 			}
 		}
 	}
 
-	this->count_match(fastqFile, fastqData, merCounter,
-					  merLocalCounter, merTotalCounter, readCounter);
+	parse.stop();
+	read.stop();
+	counters.bytes_in = gzoffset(file);
+	counters.bytes_out = gztell(file);
+	this->options->metrics.add("decompress_parse", fastqFile, parse.stop(counters));
+	progress.update(counters.reads, counters.bytes_in);
+
+	this->count_match(fastqFile, fastqData, merLocalCounter,
+					  merTotalCounter, progress);
 	fastqData.clear();
+	this->options->progress.close(progress);
 	gzclose(file);
 	return merLocalCounter;
 }
@@ -101,62 +130,77 @@ std::unordered_map<std::string, unsigned int> FastqMatch::read_fastqFile(
  *
  * @param fastqFile FASTQ file
  * @param fastqData FASTQ data
- * @param merCounter Counter of each mer
- * @param merLocalCounter Counter of each mer for parallel processing
+ * @param merLocalCounter Counter of each mer id for parallel processing
  * @param merTotalCounter Mer total counter per file
- * @param readCounter Read counter per file
+ * @param progress Progress of the file
  */
 void FastqMatch::count_match(
 	const std::string &fastqFile, std::vector<std::string> &fastqData,
-	const std::unordered_map<std::string, unsigned int> &merCounter,
-	std::unordered_map<std::string, unsigned int> &merLocalCounter,
-	u_int64_t &merTotalCounter, u_int64_t &readCounter) const
+	std::vector<unsigned int> &merLocalCounter,
+	u_int64_t &merTotalCounter, Progress::File &progress) const
 {
 	const unsigned int kmer = this->options->kmer;
-	const unsigned int mask = this->options->max_chunk_array;
-	const unsigned int chunk_length = this->options->chunk_length;
-	unsigned char *dna2bit = this->bitwiseOperation->get_dna2bit();
-	unsigned char *chunk = this->bitwiseOperation->get_chunk();
-	unsigned int dnabit, j;
-	std::string mer;
+	const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+
+	GENEDITSCAN_PROBE2(batch_start, fastqFile.c_str(), fastqData.size());
+
+	// Metrics of the scan (CPU time summed over the threads)
+	Metrics::Stopwatch scan;
+	u_int64_t windows = 0, passes = 0, hits = 0;
+	double cpu_seconds = 0.0;
 
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(this->options->inner_parallel) private(dnabit, j, mer) \
-	reduction(+ : merTotalCounter)
+#pragma omp parallel num_threads(this->options->inner_parallel) \
+	reduction(+ : merTotalCounter, windows, passes, hits, cpu_seconds)
 #endif
-	for (size_t i = 0; i < fastqData.size(); i++)
 	{
+		const double cpu_start = Metrics::thread_cpu_time();
+		Trace::Span threadScan(this->options->trace, "scan", fastqFile);
+
+		// Index copy and counter of this thread on its node (--numa)
+		const MerIndex *nodeIndex = this->bitwiseOperation->get_merIndex(kmer, this->options->numa.place());
+		std::vector<unsigned int> threadCounter(merIndex->size(), 0);
+
 #ifdef _OPENMP
-#pragma omp critical(match)
+#pragma omp for nowait
 #endif
-		if (++readCounter % this->options->log_output_interval == 0)
+		for (size_t i = 0; i < fastqData.size(); i++)
 		{
-			std::cerr << fastqFile << ": parsing " << readCounter
-					  << " reads (k-mer match)." << std::endl;
-		}
-
-		dnabit = dna2bit[(unsigned char)fastqData[i][0]];
-		for (j = 1; j < chunk_length - 1; j++)
-		{
-			dnabit = (dnabit << 2) + dna2bit[(unsigned char)fastqData[i][j]];
+			const MerIndex::ScanCount count = nodeIndex->scan(
+				fastqData[i], [&threadCounter](const size_t j, const u_int32_t id)
+				{
+					threadCounter[id]++;
+					GENEDITSCAN_PROBE2(hit, id, j); });
+			GENEDITSCAN_PROBE3(read_scan, count.windows, count.passes, count.hits);
+			merTotalCounter += fastqData[i].length() - kmer + 1;
+			windows += count.windows;
+			passes += count.passes;
+			hits += count.hits;
 		}
+		threadScan.stop();
 
-		for (j = 0; j <= fastqData[i].length() - kmer; j++)
-		{
-			dnabit = (dnabit << 2) + dna2bit[(unsigned char)fastqData[i][chunk_length - 1 + j]];
-			dnabit = dnabit & mask;
-			if (chunk[dnabit] == 1 || dnabit == mask)
-			{
-				mer.assign(fastqData[i], j, kmer);
-				if (merCounter.find(mer) != merCounter.end())
-				{
+		Trace::Span wait(this->options->trace, "wait matchMerge", fastqFile);
 #ifdef _OPENMP
-#pragma omp atomic
+#pragma omp critical(matchMerge)
 #endif
-					merLocalCounter[mer]++;
-				}
+		{
+			wait.stop();
+			Trace::Span merge(this->options->trace, "matchMerge", fastqFile);
+			for (size_t id = 0; id < threadCounter.size(); id++)
+			{
+				merLocalCounter[id] += threadCounter[id];
 			}
-			merTotalCounter++;
 		}
+		cpu_seconds += Metrics::thread_cpu_time() - cpu_start;
 	}
+
+	Metrics::Counters counters;
+	counters.reads = fastqData.size();
+	counters.windows = windows;
+	counters.prefilter_pass = passes;
+	counters.hits = hits;
+	scan.stop(counters).cpu_seconds = cpu_seconds;
+	this->options->metrics.add("scan", fastqFile, counters);
+	progress.add_scan(windows, hits);
+	GENEDITSCAN_PROBE4(batch_end, fastqFile.c_str(), fastqData.size(), windows, hits);
 }
@@ -6,7 +6,7 @@
 #define FASTQ_MATCH_H_
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "bitwise_operation.h"
 
 /**
@@ -32,15 +32,14 @@ public:
 	/**
 	 * @brief Read the fastq.gz file.
 	 *
+	 * The k-mers are searched with the k-mer index of bitwiseOperation.
+	 *
 	 * @param fastqFile FASTQ file
-	 * @param merCounter Counter of each mer
 	 * @param merTotalCounter Mer total counter per file
-	 * @return Counter of each mer for parallel processing
+	 * @return Counter of each mer id for parallel processing
 	 */
-	std::unordered_map<std::string, unsigned int> read_fastqFile(
-		const std::string &fastqFile,
-		const std::unordered_map<std::string, unsigned int> &merCounter,
-		u_int64_t &merTotalCounter) const;
+	std::vector<unsigned int> read_fastqFile(
+		const std::string &fastqFile, u_int64_t &merTotalCounter) const;
 
 private:
 	/**
@@ -60,15 +59,13 @@ private:
 	 *
 	 * @param fastqFile FASTQ file
 	 * @param fastqData FASTQ data
-	 * @param merCounter Counter of each mer
-	 * @param merLocalCounter Counter of each mer for parallel processing
+	 * @param merLocalCounter Counter of each mer id for parallel processing
 	 * @param merTotalCounter Mer total counter per file
-	 * @param readCounter Read counter per file
+	 * @param progress Progress of the file
 	 */
 	void count_match(
 		const std::string &fastqFile, std::vector<std::string> &fastqData,
-		const std::unordered_map<std::string, unsigned int> &merCounter,
-		std::unordered_map<std::string, unsigned int> &merLocalCounter,
-		u_int64_t &merTotalCounter, u_int64_t &readCounter) const;
+		std::vector<unsigned int> &merLocalCounter,
+		u_int64_t &merTotalCounter, Progress::File &progress) const;
 };
 #endif /* FASTQ_MATCH_H_ */
@@ -0,0 +1,201 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include "fastq_watch.h"
+#include "read_sampler.h"
+
+/**
+ * @brief Construct a new Fastq Watch:: Fastq Watch object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ * @param inputs FASTQ files or directories
+ */
+FastqWatch::FastqWatch(Options *options, BitwiseOperation *bitwiseOperation, const std::vector<std::string> &inputs)
+	: fastqCount(options, bitwiseOperation)
+{
+	this->options = options;
+	this->inputs = inputs;
+}
+
+/**
+ * @brief Destroy the Fastq Watch:: Fastq Watch object
+ *
+ */
+FastqWatch::~FastqWatch()
+{
+	for (auto itr = this->files.begin(); itr != this->files.end(); ++itr)
+	{
+		this->options->progress.close(*itr->second.progress);
+		gzclose(itr->second.file);
+	}
+}
+
+/**
+ * @brief Count the records written since the last poll.
+ *
+ * @param sampleCounts Running counts of the inputs (one per k, kmer set)
+ * @return Number of new reads
+ */
+u_int64_t FastqWatch::poll(std::vector<SampleCount> &sampleCounts)
+{
+	u_int64_t reads = 0;
+	for (const std::string &path : this->list_files())
+	{
+		auto itr = this->files.find(path);
+		if (itr == this->files.end())
+		{
+			// An empty file may still become a compressed one.
+			std::error_code ec;
+			if (std::filesystem::file_size(path, ec) == 0 || ec)
+			{
+				continue;
+			}
+			const gzFile file = gzopen(path.c_str(), "rb");
+			if (!file)
+			{
+				std::cerr << "[Error] Could not open (" << path << ")." << std::endl;
+				std::exit(1);
+			}
+			std::cout << "Watching " << path << std::endl;
+			// The file grows while it is read: no ETA.
+			Progress::File &progress = this->options->progress.open(path, "k-mer count", 0);
+			itr = this->files.emplace(path, WatchedFile{file, "", {}, 0, &progress}).first;
+		}
+		reads += this->read_records(path, itr->second, sampleCounts);
+	}
+	return reads;
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief FASTQ files of the inputs (sorted within a directory).
+ *
+ * @return FASTQ files
+ */
+std::vector<std::string> FastqWatch::list_files() const
+{
+	static const std::vector<std::string> suffixes = {".fastq", ".fq", ".fastq.gz", ".fq.gz"};
+	std::vector<std::string> paths;
+	for (const std::string &input : this->inputs)
+	{
+		if (!std::filesystem::is_directory(input))
+		{
+			// A file not written yet is picked up by a later poll.
+			if (std::filesystem::exists(input))
+			{
+				paths.push_back(input);
+			}
+			continue;
+		}
+		std::vector<std::string> entries;
+		for (const auto &entry : std::filesystem::directory_iterator(input))
+		{
+			const std::string name = entry.path().filename().string();
+			for (const std::string &suffix : suffixes)
+			{
+				if (entry.is_regular_file() && name.length() > suffix.length() &&
+					name.compare(name.length() - suffix.length(), suffix.length(), suffix) == 0)
+				{
+					entries.push_back(entry.path().string());
+					break;
+				}
+			}
+		}
+		std::sort(entries.begin(), entries.end());
+		paths.insert(paths.end(), entries.begin(), entries.end());
+	}
+	return paths;
+}
+
+/**
+ * @brief Read the complete records of a file.
+ *
+ * A line is complete when its line break is written; the lines read so far
+ * of an unfinished record are kept for the next poll.
+ *
+ * @param path FASTQ file
+ * @param watched Open file
+ * @param sampleCounts Running counts (one per k)
+ * @return Number of new reads
+ */
+u_int64_t FastqWatch::read_records(const std::string &path, WatchedFile &watched,
+								   std::vector<SampleCount> &sampleCounts)
+{
+	// Reads shorter than the shortest k are skipped.
+	unsigned int kmerLen = this->options->MAX_KMER;
+	for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+	{
+		kmerLen = std::min(kmerLen, itr->kmer);
+	}
+	const unsigned int max_buff = this->options->max_read_length + 2;
+	char buff[max_buff];
+	std::vector<std::string> fastqData;
+	const u_int64_t readCounter = watched.readCounter;
+	const ReadSampler sampler(this->options->fraction);
+
+	// Time of gzgets and of the records (the counting is the scan phase).
+	Metrics::Stopwatch parse;
+	Metrics::Counters counters;
+	Trace::Span read(this->options->trace, "read", path);
+	const u_int64_t start_in = gzoffset(watched.file);
+	const u_int64_t start_out = gztell(watched.file);
+
+	// Continue after the end of the file seen by the last poll.
+	gzclearerr(watched.file);
+	while (gzgets(watched.file, buff, max_buff) != Z_NULL)
+	{
+		watched.line += buff;
+		if (watched.line.back() != '\n')
+		{
+			continue;
+		}
+		watched.line.pop_back();
+		watched.record.push_back(watched.line);
+		watched.line.clear();
+		if (watched.record.size() < 4)
+		{
+			continue;
+		}
+		if (watched.record[0][0] != '@' || watched.record[2][0] != '+')
+		{
+			std::cerr << "[Error] Could not get sequence (" << watched.record[0] << ")." << std::endl;
+			std::exit(1);
+		}
+		counters.reads++;
+		if (watched.record[1].length() >= kmerLen && sampler.keep(watched.record[0]))
+		{
+			fastqData.push_back(watched.record[1]);
+			if (fastqData.size() > this->options->fastq_read_lines)
+			{
+				parse.stop();
+				read.stop();
+				watched.readCounter += fastqData.size();
+				this->fastqCount.count_sample(path, fastqData, sampleCounts, *watched.progress);
+				fastqData.clear();
+				parse.start();
+				read.start();
+			}
+		}
+		watched.record.clear();
+	}
+	parse.stop();
+	read.stop();
+	counters.bytes_in = gzoffset(watched.file) - start_in;
+	counters.bytes_out = gztell(watched.file) - start_out;
+	this->options->metrics.add("decompress_parse", path, parse.stop(counters));
+
+	if (!fastqData.empty())
+	{
+		watched.readCounter += fastqData.size();
+		this->fastqCount.count_sample(path, fastqData, sampleCounts, *watched.progress);
+	}
+	watched.progress->update(watched.readCounter, gzoffset(watched.file));
+	return watched.readCounter - readCounter;
+}
@@ -0,0 +1,112 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef FASTQ_WATCH_H_
+#define FASTQ_WATCH_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "bitwise_operation.h"
+#include "fastq_count.h"
+#include "sample_count.h"
+
+/**
+ * @brief Follow FASTQ files that are still being written (watch mode).
+ *
+ * Each input is a FASTQ file that grows, or a directory in which new FASTQ
+ * files (.fastq, .fq, .fastq.gz, .fq.gz) appear. The files are kept open and
+ * every poll counts the records completed since the last one; a record whose
+ * lines are not all written yet is kept until the next poll.
+ */
+class FastqWatch
+{
+public:
+	/**
+	 * @brief Construct a new Fastq Watch object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 * @param inputs FASTQ files or directories
+	 */
+	FastqWatch(Options *options, BitwiseOperation *bitwiseOperation, const std::vector<std::string> &inputs);
+
+	/**
+	 * @brief Destroy the Fastq Watch object
+	 *
+	 */
+	virtual ~FastqWatch();
+
+	/**
+	 * @brief Count the records written since the last poll.
+	 *
+	 * @param sampleCounts Running counts of the inputs (one per k, kmer set)
+	 * @return Number of new reads
+	 */
+	u_int64_t poll(std::vector<SampleCount> &sampleCounts);
+
+	// Getter
+
+	size_t get_files() const
+	{
+		return this->files.size();
+	}
+
+private:
+	/**
+	 * @brief Open FASTQ file and the record being read.
+	 *
+	 */
+	struct WatchedFile
+	{
+		gzFile file;
+		std::string line;
+		std::vector<std::string> record;
+		u_int64_t readCounter;
+		Progress::File *progress;
+	};
+
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Counter of the k-mers.
+	 *
+	 */
+	FastqCount fastqCount;
+
+	/**
+	 * @brief FASTQ files or directories
+	 *
+	 */
+	std::vector<std::string> inputs;
+
+	/**
+	 * @brief Files being followed (by path)
+	 *
+	 */
+	std::map<std::string, WatchedFile> files;
+
+	/**
+	 * @brief FASTQ files of the inputs (sorted within a directory).
+	 *
+	 * @return FASTQ files
+	 */
+	std::vector<std::string> list_files() const;
+
+	/**
+	 * @brief Read the complete records of a file.
+	 *
+	 * @param path FASTQ file
+	 * @param watched Open file
+	 * @param sampleCounts Running counts (one per k)
+	 * @return Number of new reads
+	 */
+	u_int64_t read_records(const std::string &path, WatchedFile &watched, std::vector<SampleCount> &sampleCounts);
+};
+#endif /* FASTQ_WATCH_H_ */
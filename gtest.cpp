@@ -44,6 +44,9 @@ Gtest::~Gtest()
 void Gtest::kmer_match(const std::vector<unsigned int> &mutantPosFreq,
 					   const std::vector<unsigned int> &wildTypePosFreq)
 {
+	Metrics::Stopwatch gtest;
+	Trace::Span gtestSpan(this->options->trace, "gtest");
+
 	// for total
 	const double mutant_mer_total_log = log(this->mutant_mer_total) * this->mutant_mer_total;
 	const double wildType_mer_total_log = log(this->wildType_mer_total) * this->wildType_mer_total;
@@ -55,6 +58,9 @@ void Gtest::kmer_match(const std::vector<unsigned int> &mutantPosFreq,
 	std::map<std::pair<unsigned int, unsigned int>, double> pval_stock;
 	std::map<std::pair<unsigned int, unsigned int>, double> bon_stock;
 	const size_t vector_len = mutantPosFreq.size();
+	this->gval.assign(vector_len, 0.0);
+	this->pval.assign(vector_len, 1.0);
+	this->bon.assign(vector_len, 1.0);
 
 	for (size_t i = 0; i < vector_len; i++)
 	{
@@ -96,8 +102,15 @@ void Gtest::kmer_match(const std::vector<unsigned int> &mutantPosFreq,
 		}
 	}
 
+	Metrics::Counters counters;
+	this->options->metrics.add("gtest", "", gtest.stop(counters));
+	gtestSpan.stop();
+
 	// Calculate FDR using the Benjamini-Hochberg method.
+	Metrics::Stopwatch fdr;
+	Trace::Span fdrSpan(this->options->trace, "fdr");
 	this->fdr_match();
+	this->options->metrics.add("fdr", "", fdr.stop(counters));
 }
 
 /**
@@ -155,6 +168,11 @@ Gtest::fdr_extension(const std::unordered_map<unsigned int, std::unordered_map<u
 		}
 	}
 	sort(v.begin(), v.end());
+	if (v.empty())
+	{
+		// No k-mer passed the threshold (e.g. one of several vectors).
+		return {};
+	}
 
 	std::unordered_map<unsigned int, double> f;
 	const double vector_len = (double)v.size();
@@ -256,11 +274,16 @@ double Gtest::adjusted_g(
 void Gtest::fdr_match()
 {
 	std::vector<std::pair<double, unsigned int>> v;
-	for (auto itr = this->pval.begin(); itr != this->pval.end(); itr++)
+	for (size_t i = 0; i < this->pval.size(); i++)
 	{
-		v.push_back(std::make_pair(itr->second, itr->first));
+		v.push_back(std::make_pair(this->pval[i], i));
 	}
 	sort(v.begin(), v.end());
+	this->fdr.assign(v.size(), 1.0);
+	if (v.empty())
+	{
+		return;
+	}
 
 	const double vector_len = (double)v.size();
 	double vector_pos = 1.0;
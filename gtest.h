@@ -71,22 +71,22 @@ public:
 
 	// Getter
 
-	std::unordered_map<unsigned int, double> get_gval() const
+	const std::vector<double> &get_gval() const
 	{
 		return this->gval;
 	};
 
-	std::unordered_map<unsigned int, double> get_pval() const
+	const std::vector<double> &get_pval() const
 	{
 		return this->pval;
 	};
 
-	std::unordered_map<unsigned int, double> get_fdr() const
+	const std::vector<double> &get_fdr() const
 	{
 		return this->fdr;
 	};
 
-	std::unordered_map<unsigned int, double> get_bon() const
+	const std::vector<double> &get_bon() const
 	{
 		return this->bon;
 	};
@@ -110,22 +110,22 @@ private:
 	/**
 	 * @brief G-value on vector array
 	 */
-	std::unordered_map<unsigned int, double> gval;
+	std::vector<double> gval;
 
 	/**
 	 * @brief P-value on vector array
 	 */
-	std::unordered_map<unsigned int, double> pval;
+	std::vector<double> pval;
 
 	/**
 	 * @brief FDR on vector array (Benjamini-Hochberg)
 	 */
-	std::unordered_map<unsigned int, double> fdr;
+	std::vector<double> fdr;
 
 	/**
 	 * @brief Bonferroni on vector array
 	 */
-	std::unordered_map<unsigned int, double> bon;
+	std::vector<double> bon;
 
 	/**
 	 * @brief Williams's correction of G-value.
@@ -0,0 +1,644 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include "kmer_count.h"
+#include "early_stop.h"
+#include "vector_sequence.h"
+
+/**
+ * @brief Construct a new Kmer Count:: Kmer Count object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ */
+KmerCount::KmerCount(Options *options, BitwiseOperation *bitwiseOperation)
+{
+	this->options = options;
+	this->bitwiseOperation = bitwiseOperation;
+
+	// FASTQ count
+	this->fastqCount = new FastqCount(this->options, this->bitwiseOperation);
+}
+
+/**
+ * @brief Destroy the Kmer Count:: Kmer Count object
+ *
+ */
+KmerCount::~KmerCount()
+{
+	delete this->fastqCount;
+}
+
+/**
+ * @brief Count k-mer of each FASTQ file and save the count files.
+ *
+ * Each FASTQ file is read once for all k of the run (one count file per k).
+ */
+void KmerCount::execution() const
+{
+	std::cout << "\n---------- Count of k-mer (K-mer = " << this->kmer_list()
+			  << ", Bases = " << this->options->bases_on_each_side << ") ----------" << std::endl;
+
+	// Create the k-mer index of each k.
+	VectorSequence *vectorSequence = new VectorSequence(this->options, this->bitwiseOperation);
+	vectorSequence->create_merIndexes();
+	delete vectorSequence;
+	const u_int64_t vector_hash = this->vector_hash();
+
+	std::filesystem::create_directories(this->options->cache_dir);
+
+	std::vector<std::string> fastqFiles(this->options->mutant_files);
+	fastqFiles.insert(fastqFiles.end(), this->options->wildType_files.begin(),
+					  this->options->wildType_files.end());
+
+#ifdef _OPENMP
+#if _OPENMP < 202011
+	omp_set_nested(1);
+#endif
+	omp_set_max_active_levels(2);
+	omp_set_dynamic(0);
+#pragma omp parallel for num_threads(this->options->outer_parallel)
+#endif
+	for (size_t i = 0; i < fastqFiles.size(); i++)
+	{
+		// With checkpoints, the files counted before an interruption are skipped.
+		std::vector<SampleCount> sampleCounts = this->empty_counts(fastqFiles[i], vector_hash);
+		const bool counted = !this->options->checkpoint_dir.empty() &&
+							 this->load_saved(sampleCounts, this->options->cache_dir, "");
+		if (!counted)
+		{
+			sampleCounts = this->count_file(fastqFiles[i], vector_hash);
+		}
+		for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+		{
+			const std::string countFile = this->options->cache_dir + "/" + this->count_name(*itr);
+			if (!counted)
+			{
+				itr->save(countFile);
+			}
+#ifdef _OPENMP
+#pragma omp critical(countFile)
+#endif
+			std::cout << fastqFiles[i] << " -> " << countFile
+					  << " (" << itr->reads() << " reads" << (counted ? ", counted before" : "") << ")" << std::endl;
+		}
+		this->remove_saved(sampleCounts, ".ckpt");
+	}
+}
+
+/**
+ * @brief Load the counts of the mutant and wild type samples.
+ *
+ * @param mutantCount Counts of the mutant samples
+ * @param wildTypeCount Counts of the wild type samples
+ */
+void KmerCount::load_counts(SampleCount &mutantCount, SampleCount &wildTypeCount) const
+{
+	std::cout << "\n---------- Load counts of k-mer (" << this->options->cache_dir
+			  << ") ----------" << std::endl;
+
+	const u_int64_t vector_hash = this->vector_hash();
+	mutantCount.kmer = this->options->kmer;
+	wildTypeCount.kmer = this->options->kmer;
+
+	for (auto itr = this->options->mutant_files.begin(); itr != this->options->mutant_files.end(); ++itr)
+	{
+		this->load_count(*itr, vector_hash, mutantCount);
+	}
+	for (auto itr = this->options->wildType_files.begin(); itr != this->options->wildType_files.end(); ++itr)
+	{
+		this->load_count(*itr, vector_hash, wildTypeCount);
+	}
+}
+
+/**
+ * @brief Merge count files (shards of a FASTQ file or samples) into one count file.
+ *
+ * The merge is associative, so partial merges may be merged again. When the
+ * result is a whole FASTQ file, it is saved under its name in the cache
+ * directory, otherwise to <out_prefix>.cnt.
+ *
+ * @param countFiles Count files
+ */
+void KmerCount::merge(const std::vector<std::string> &countFiles) const
+{
+	std::cout << "\n---------- Merge of count files ----------" << std::endl;
+
+	SampleCount mergedCount;
+	for (auto itr = countFiles.begin(); itr != countFiles.end(); ++itr)
+	{
+		SampleCount fileCount;
+		if (!fileCount.load(*itr))
+		{
+			std::cerr << "[Error] Not a count file of this version (" << *itr << ")." << std::endl;
+			std::exit(1);
+		}
+		const std::string error = mergedCount.add_partial(fileCount);
+		if (!error.empty())
+		{
+			std::cerr << "[Error] Count file (" << *itr << ") " << error << std::endl;
+			std::exit(1);
+		}
+		std::cout << *itr << ": " << fileCount.reads() << " reads" << std::endl;
+	}
+
+	std::string countFile = this->options->out_prefix + ".cnt";
+	if (mergedCount.shards == 0 && mergedCount.fingerprint != 0)
+	{
+		std::filesystem::create_directories(this->options->cache_dir);
+		countFile = this->options->cache_dir + "/" + this->count_name(mergedCount);
+	}
+	mergedCount.save(countFile);
+
+	std::cout << "-> " << countFile << " (" << mergedCount.reads() << " reads";
+	if (mergedCount.shards > 0)
+	{
+		std::cout << ", " << mergedCount.shardSet.size() << " of " << mergedCount.shards << " shards";
+	}
+	std::cout << ")" << std::endl;
+}
+
+/**
+ * @brief Counts of the samples for all k of the run, each FASTQ file read once.
+ *
+ * With -c, the wild type counts are read from the cache directory. A wild
+ * type file without usable count files is read and its count files are
+ * saved, so that the next run with the same control set skips it. With -I,
+ * the mutant files are cached in the same way, so that only new files are read.
+ *
+ * @param wildTypeCounts Counts of the wild type samples (one per k)
+ * @param mutantCounts Counts of the mutant samples (one per k, nullptr: not counted)
+ */
+void KmerCount::sample_counts(std::vector<SampleCount> &wildTypeCounts,
+							  std::vector<SampleCount> *mutantCounts) const
+{
+	std::cout << "\n---------- Counts of k-mer (K-mer = " << this->kmer_list() << ") ----------" << std::endl;
+
+	// Create the k-mer index of each k.
+	VectorSequence *vectorSequence = new VectorSequence(this->options, this->bitwiseOperation);
+	vectorSequence->create_merIndexes();
+	delete vectorSequence;
+	const u_int64_t vector_hash = this->vector_hash();
+
+	const std::vector<unsigned int> &kmers = this->options->kmers;
+	wildTypeCounts.assign(kmers.size(), SampleCount());
+	for (size_t n = 0; n < kmers.size(); n++)
+	{
+		wildTypeCounts[n].kmer = kmers[n];
+	}
+	if (mutantCounts)
+	{
+		*mutantCounts = wildTypeCounts;
+	}
+	if (this->options->cache_wildType || this->options->incremental)
+	{
+		std::filesystem::create_directories(this->options->cache_dir);
+	}
+
+	// Number of files read (the others were cached)
+	size_t nRead = 0;
+
+	// Mutant files (if counted) and wild type files; in the sequential mode (-e)
+	// the mutant files are read after the wild type files.
+	const bool early = mutantCounts && this->options->early_positions > 0;
+	const size_t nMutant = mutantCounts ? this->options->mutant_files.size() : 0;
+	const size_t nSample = nMutant + this->options->wildType_files.size();
+
+#ifdef _OPENMP
+#if _OPENMP < 202011
+	omp_set_nested(1);
+#endif
+	omp_set_max_active_levels(2);
+	omp_set_dynamic(0);
+#pragma omp parallel for num_threads(this->options->outer_parallel)
+#endif
+	for (size_t i = early ? nMutant : 0; i < nSample; i++)
+	{
+		const bool mutant = i < nMutant;
+		const std::string &fastqFile = mutant ? this->options->mutant_files[i]
+											  : this->options->wildType_files[i - nMutant];
+		const bool cache = this->options->incremental || (!mutant && this->options->cache_wildType);
+
+		std::vector<SampleCount> sampleCounts = this->empty_counts(fastqFile, vector_hash);
+		bool cached = cache;
+		for (size_t n = 0; cached && n < kmers.size(); n++)
+		{
+			// A broken or old count file (e.g. left by a failed run) is a miss: the file is counted again.
+			const std::string cacheFile = SampleCount::cache_file(this->options, fastqFile, vector_hash, kmers[n]);
+			SampleCount fileCount = sampleCounts[n];
+			const bool loaded = sampleCounts[n].load(cacheFile);
+			if (!loaded && std::filesystem::exists(cacheFile))
+			{
+				std::cerr << "[Warning] Broken or old count file (" << cacheFile << "); " << fastqFile
+						  << " is counted again." << std::endl;
+			}
+			cached = loaded && sampleCounts[n].same_file(fileCount) &&
+					 this->check_count(sampleCounts[n], vector_hash, kmers[n]).empty();
+		}
+		// Counts of a file finished before an interruption (-p)
+		const bool checkpoint = !cache && !this->options->checkpoint_dir.empty();
+		bool finished = false;
+		if (checkpoint)
+		{
+			sampleCounts = this->empty_counts(fastqFile, vector_hash);
+			finished = this->load_saved(sampleCounts, this->options->checkpoint_dir, "");
+		}
+		if (!cached && !finished)
+		{
+			sampleCounts = this->count_file(fastqFile, vector_hash);
+			for (size_t n = 0; n < kmers.size(); n++)
+			{
+				if (cache)
+				{
+					sampleCounts[n].save(SampleCount::cache_file(this->options, fastqFile, vector_hash, kmers[n]));
+				}
+				else if (checkpoint)
+				{
+					sampleCounts[n].save(this->options->checkpoint_dir + "/" + this->count_name(sampleCounts[n]));
+				}
+			}
+			this->remove_saved(sampleCounts, ".ckpt");
+		}
+
+		Metrics::Stopwatch merge;
+		Trace::Span wait(this->options->trace, "wait sampleCount", fastqFile);
+#ifdef _OPENMP
+#pragma omp critical(sampleCount)
+#endif
+		{
+			wait.stop();
+			Trace::Span span(this->options->trace, "merge", fastqFile);
+			nRead += (cached || finished) ? 0 : 1;
+			for (size_t n = 0; n < kmers.size(); n++)
+			{
+				std::cout << fastqFile << ": " << sampleCounts[n].reads() << " reads";
+				if (cache)
+				{
+					std::cout << " (" << (cached ? "cached " : "saved to ")
+							  << SampleCount::cache_file(this->options, fastqFile, vector_hash, kmers[n]) << ")";
+				}
+				else if (finished)
+				{
+					std::cout << " (K-mer = " << kmers[n] << ", counted before)";
+				}
+				else if (kmers.size() > 1)
+				{
+					std::cout << " (K-mer = " << kmers[n] << ")";
+				}
+				std::cout << std::endl;
+				(mutant ? (*mutantCounts)[n] : wildTypeCounts[n]).merge(sampleCounts[n]);
+			}
+		}
+		Metrics::Counters counters;
+		this->options->metrics.add("merge", fastqFile, merge.stop(counters));
+	}
+	if (early)
+	{
+		nRead += this->sequential_counts(*mutantCounts, wildTypeCounts);
+	}
+	std::cout << "Files read: " << nRead << " of " << nSample << std::endl;
+}
+
+/**
+ * @brief Remove the counts kept in the checkpoint directory for this run.
+ *
+ * Called when the analyses of a kmer run are finished.
+ */
+void KmerCount::clear_checkpoints() const
+{
+	const u_int64_t vector_hash = this->vector_hash();
+	std::vector<std::string> fastqFiles;
+	if (!this->options->incremental)
+	{
+		fastqFiles = this->options->mutant_files;
+	}
+	if (!this->options->cache_wildType && !this->options->incremental)
+	{
+		fastqFiles.insert(fastqFiles.end(), this->options->wildType_files.begin(),
+						  this->options->wildType_files.end());
+	}
+	for (auto itr = fastqFiles.begin(); itr != fastqFiles.end(); ++itr)
+	{
+		const std::vector<SampleCount> sampleCounts = this->empty_counts(*itr, vector_hash);
+		this->remove_saved(sampleCounts, "");
+	}
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief K-mers of the run for the log (16,20,...).
+ *
+ * @return K-mers connected with comma
+ */
+std::string KmerCount::kmer_list() const
+{
+	std::ostringstream ostr;
+	for (size_t n = 0; n < this->options->kmers.size(); n++)
+	{
+		ostr << (n > 0 ? "," : "") << this->options->kmers[n];
+	}
+	return ostr.str();
+}
+
+/**
+ * @brief Empty counts of a FASTQ file for all k of the run (header only).
+ *
+ * @param fastqFile FASTQ file
+ * @param vector_hash Hash of the vector sequence
+ * @return Counts of the file (one per k)
+ */
+std::vector<SampleCount> KmerCount::empty_counts(const std::string &fastqFile, const u_int64_t vector_hash) const
+{
+	std::vector<SampleCount> sampleCounts(this->options->kmers.size());
+	SampleCount fileCount;
+	fileCount.set_file(fastqFile);
+	for (size_t n = 0; n < sampleCounts.size(); n++)
+	{
+		sampleCounts[n] = fileCount;
+		sampleCounts[n].kmer = this->options->kmers[n];
+		sampleCounts[n].bases = this->options->bases_on_each_side;
+		sampleCounts[n].max_read_length = this->options->max_read_length;
+		sampleCounts[n].vector_hash = vector_hash;
+		// The hash of the lines of a shard is seeded with its number.
+		sampleCounts[n].content_hash = this->options->shards > 0 ? this->options->shard : 0;
+		sampleCounts[n].fraction = this->options->fraction;
+		if (this->options->shards > 0)
+		{
+			sampleCounts[n].shards = this->options->shards;
+			sampleCounts[n].shardSet.insert(this->options->shard);
+		}
+	}
+	return sampleCounts;
+}
+
+/**
+ * @brief Counts of a FASTQ file for all k of the run.
+ *
+ * With -p, the counts are saved to the checkpoint directory after each block
+ * of reads (-r), and a scan interrupted before resumes from its checkpoint.
+ *
+ * @param fastqFile FASTQ file
+ * @param vector_hash Hash of the vector sequence
+ * @return Counts of the file (one per k)
+ */
+std::vector<SampleCount> KmerCount::count_file(const std::string &fastqFile, const u_int64_t vector_hash) const
+{
+	std::vector<SampleCount> sampleCounts = this->empty_counts(fastqFile, vector_hash);
+	if (this->options->checkpoint_dir.empty())
+	{
+		this->fastqCount->read_fastqFile(fastqFile, sampleCounts);
+		return sampleCounts;
+	}
+	std::filesystem::create_directories(this->options->checkpoint_dir);
+
+	// Resume the checkpoint of an interrupted scan (all k at the same offset).
+	u_int64_t offset = 0;
+	std::vector<SampleCount> checkpoints(sampleCounts);
+	if (this->load_saved(checkpoints, this->options->checkpoint_dir, ".ckpt") && checkpoints.front().offset > 0 &&
+		std::all_of(checkpoints.begin(), checkpoints.end(), [&](const SampleCount &checkpoint)
+					{ return checkpoint.offset == checkpoints.front().offset; }))
+	{
+		offset = checkpoints.front().offset;
+		sampleCounts.swap(checkpoints);
+		for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+		{
+			itr->offset = 0;
+		}
+#ifdef _OPENMP
+#pragma omp critical(checkpoint)
+#endif
+		std::cout << fastqFile << ": resumed at byte " << offset << " ("
+				  << sampleCounts.front().reads() << " reads counted before)" << std::endl;
+	}
+
+	this->fastqCount->read_fastqFile(fastqFile, sampleCounts, offset, [&](const u_int64_t position)
+									 {
+										 for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+										 {
+											 itr->offset = position;
+											 itr->save(this->options->checkpoint_dir + "/" + this->count_name(*itr) + ".ckpt");
+											 itr->offset = 0;
+										 }
+										 return true; });
+	return sampleCounts;
+}
+
+/**
+ * @brief Read the mutant files one after another until the sequential rule decides (-e).
+ *
+ * The rule is checked on the running counts after each block of reads (-r)
+ * and at the end of each file; the files after a decision are not read.
+ *
+ * @param mutantCounts Counts of the mutant samples (one per k)
+ * @param wildTypeCounts Counts of the wild type samples (one per k)
+ * @return Number of files read
+ */
+size_t KmerCount::sequential_counts(std::vector<SampleCount> &mutantCounts,
+									const std::vector<SampleCount> &wildTypeCounts) const
+{
+	EarlyStop earlyStop(this->options, this->bitwiseOperation, wildTypeCounts);
+	EarlyStop::Decision decision = EarlyStop::UNDECIDED;
+
+	// One file at a time with all threads
+	const unsigned int outer_parallel = this->options->outer_parallel;
+	const unsigned int inner_parallel = this->options->inner_parallel;
+	this->options->inner_parallel = outer_parallel * inner_parallel;
+	this->options->outer_parallel = 1;
+
+	size_t nRead = 0;
+	for (auto itr = this->options->mutant_files.begin(); itr != this->options->mutant_files.end(); ++itr)
+	{
+		if (decision != EarlyStop::UNDECIDED)
+		{
+			std::cout << *itr << ": not read (early stop)" << std::endl;
+			continue;
+		}
+		const u_int64_t reads = mutantCounts.front().reads();
+		this->fastqCount->read_fastqFile(*itr, mutantCounts, 0, [&](const u_int64_t)
+										 {
+											 decision = earlyStop.decide(mutantCounts);
+											 return decision == EarlyStop::UNDECIDED; });
+		if (decision == EarlyStop::UNDECIDED)
+		{
+			decision = earlyStop.decide(mutantCounts);
+		}
+		nRead++;
+		std::cout << *itr << ": " << mutantCounts.front().reads() - reads << " reads" << std::endl;
+	}
+	std::cout << "Early stop: "
+			  << (decision == EarlyStop::DETECTED ? "detected" : (decision == EarlyStop::ABSENT ? "absent" : "undecided"))
+			  << " after " << mutantCounts.front().reads() << " mutant reads; " << earlyStop.get_reason() << std::endl;
+
+	this->options->outer_parallel = outer_parallel;
+	this->options->inner_parallel = inner_parallel;
+	return nRead;
+}
+
+/**
+ * @brief Name of the count file of counts made by count_file.
+ *
+ * @param sampleCount Counts of a FASTQ file
+ * @return Count file name (without directory)
+ */
+std::string KmerCount::count_name(const SampleCount &sampleCount) const
+{
+	return SampleCount::count_name(sampleCount.fingerprint, sampleCount.vector_hash, sampleCount.kmer,
+								   this->options->shard, this->options->shards, sampleCount.fraction);
+}
+
+/**
+ * @brief Load the saved counts of a FASTQ file for all k.
+ *
+ * @param sampleCounts Counts of the file (one per k, header from empty_counts)
+ * @param directory Directory of the count files
+ * @param suffix Suffix after the count file name (".ckpt" for checkpoints)
+ * @return true if the counts of all k were saved by the same kind of scan
+ */
+bool KmerCount::load_saved(std::vector<SampleCount> &sampleCounts, const std::string &directory,
+						   const std::string &suffix) const
+{
+	std::vector<SampleCount> savedCounts(sampleCounts.size());
+	for (size_t n = 0; n < sampleCounts.size(); n++)
+	{
+		const SampleCount &sampleCount = sampleCounts[n];
+		SampleCount &savedCount = savedCounts[n];
+		if (!savedCount.load(directory + "/" + this->count_name(sampleCount) + suffix) ||
+			savedCount.kmer != sampleCount.kmer || savedCount.bases != sampleCount.bases ||
+			savedCount.max_read_length != sampleCount.max_read_length ||
+			savedCount.fingerprint != sampleCount.fingerprint || !savedCount.same_file(sampleCount) ||
+			savedCount.vector_hash != sampleCount.vector_hash ||
+			savedCount.shards != sampleCount.shards || savedCount.shardSet != sampleCount.shardSet ||
+			(suffix.empty() && savedCount.offset > 0))
+		{
+			return false;
+		}
+	}
+	sampleCounts.swap(savedCounts);
+	return true;
+}
+
+/**
+ * @brief Remove the saved counts of a FASTQ file from the checkpoint directory.
+ *
+ * @param sampleCounts Counts of the file (one per k)
+ * @param suffix Suffix after the count file name (".ckpt" for checkpoints)
+ */
+void KmerCount::remove_saved(const std::vector<SampleCount> &sampleCounts, const std::string &suffix) const
+{
+	if (this->options->checkpoint_dir.empty())
+	{
+		return;
+	}
+	for (auto itr = sampleCounts.begin(); itr != sampleCounts.end(); ++itr)
+	{
+		std::error_code error;
+		std::filesystem::remove(this->options->checkpoint_dir + "/" + this->count_name(*itr) + suffix, error);
+	}
+}
+
+/**
+ * @brief Hash of the vector sequences.
+ *
+ * @return Hash
+ */
+u_int64_t KmerCount::vector_hash() const
+{
+	VectorSequence *vectorSequence = new VectorSequence(this->options, this->bitwiseOperation);
+	const std::vector<std::pair<std::string, std::string>> records = vectorSequence->read_sequences();
+	delete vectorSequence;
+
+	u_int64_t hash = 0;
+	for (auto itr = records.begin(); itr != records.end(); ++itr)
+	{
+		std::string sequence = itr->second;
+		transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
+		hash = SampleCount::hash(sequence.data(), sequence.length(), hash);
+	}
+	return hash;
+}
+
+/**
+ * @brief Check that a count file fits the current options.
+ *
+ * @param sampleCount Counts of a sample
+ * @param vector_hash Hash of the vector sequence
+ * @param kmer K-mer
+ * @return Reason why the counts can not be used (empty if they can)
+ */
+std::string KmerCount::check_count(const SampleCount &sampleCount, const u_int64_t vector_hash,
+								  const unsigned int kmer) const
+{
+	std::ostringstream ostr;
+	if (sampleCount.kmer != kmer || sampleCount.vector_hash != vector_hash)
+	{
+		ostr << "was made with another vector or k-mer.";
+	}
+	else if (sampleCount.bases < this->options->bases_on_each_side)
+	{
+		ostr << "has " << sampleCount.bases << " bases on each side; count with -b "
+			 << this->options->bases_on_each_side << " or more.";
+	}
+	else if (sampleCount.max_read_length != this->options->max_read_length)
+	{
+		ostr << "was made with maximum read length " << sampleCount.max_read_length << ".";
+	}
+	else if (sampleCount.fraction != this->options->fraction)
+	{
+		ostr << "was made from fraction " << sampleCount.fraction << " of the reads (--fraction).";
+	}
+	else if (sampleCount.shards > 0)
+	{
+		ostr << "holds " << sampleCount.shardSet.size() << " of " << sampleCount.shards
+			 << " shards; merge all shards of the FASTQ file first.";
+	}
+	else if (sampleCount.offset > 0)
+	{
+		ostr << "is the checkpoint of an unfinished scan.";
+	}
+	return ostr.str();
+}
+
+/**
+ * @brief Load the counts of a sample and add them.
+ *
+ * @param file FASTQ file (looked up in the cache directory) or count file (.cnt)
+ * @param vector_hash Hash of the vector sequence
+ * @param sampleCount Counts of the samples
+ */
+void KmerCount::load_count(const std::string &file, const u_int64_t vector_hash,
+						   SampleCount &sampleCount) const
+{
+	const std::string suffix = ".cnt";
+	const bool isCountFile = file.length() > suffix.length() &&
+							 file.compare(file.length() - suffix.length(), suffix.length(), suffix) == 0;
+	const std::string countFile = isCountFile ? file : SampleCount::cache_file(this->options, file, vector_hash,
+																			   this->options->kmer);
+
+	SampleCount fileCount;
+	if (!fileCount.load(countFile))
+	{
+		std::cerr << "[Error] Count file of (" << file << ") is not found or is old (" << countFile
+				  << "). Run the count stage first." << std::endl;
+		std::exit(1);
+	}
+	SampleCount fastqCount;
+	if (!isCountFile)
+	{
+		fastqCount.set_file(file);
+	}
+	const std::string error = !isCountFile && !fileCount.same_file(fastqCount)
+								  ? "was made before the FASTQ file was changed; run the count stage again."
+								  : this->check_count(fileCount, vector_hash, this->options->kmer);
+	if (!error.empty())
+	{
+		std::cerr << "[Error] Count file (" << countFile << ") " << error << std::endl;
+		std::exit(1);
+	}
+
+	std::cout << file << ": " << fileCount.reads() << " reads (" << countFile << ")" << std::endl;
+	sampleCount.merge(fileCount);
+}
@@ -0,0 +1,192 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef KMER_COUNT_H_
+#define KMER_COUNT_H_
+
+#include "bitwise_operation.h"
+#include "fastq_count.h"
+#include "sample_count.h"
+
+/**
+ * @brief Count stage ("count once") and input of the test stage ("test many").
+ *
+ */
+class KmerCount
+{
+public:
+	/**
+	 * @brief Construct a new Kmer Count object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 */
+	KmerCount(Options *options, BitwiseOperation *bitwiseOperation);
+
+	/**
+	 * @brief Destroy the Kmer Count object
+	 *
+	 */
+	virtual ~KmerCount();
+
+	/**
+	 * @brief Count k-mer of each FASTQ file and save the count files.
+	 *
+	 * Each FASTQ file is read once for all k of the run (one count file per k).
+	 */
+	void execution() const;
+
+	/**
+	 * @brief Load the counts of the mutant and wild type samples.
+	 *
+	 * @param mutantCount Counts of the mutant samples
+	 * @param wildTypeCount Counts of the wild type samples
+	 */
+	void load_counts(SampleCount &mutantCount, SampleCount &wildTypeCount) const;
+
+	/**
+	 * @brief Merge count files (shards of a FASTQ file or samples) into one count file.
+	 *
+	 * The merge is associative, so partial merges may be merged again. When the
+	 * result is a whole FASTQ file, it is saved under its name in the cache
+	 * directory, otherwise to <out_prefix>.cnt.
+	 *
+	 * @param countFiles Count files
+	 */
+	void merge(const std::vector<std::string> &countFiles) const;
+
+	/**
+	 * @brief Counts of the samples for all k of the run, each FASTQ file read once.
+	 *
+	 * With -c, the wild type counts are read from the cache directory. A wild
+	 * type file without usable count files is read and its count files are
+	 * saved, so that the next run with the same control set skips it. With -I,
+	 * the mutant files are cached in the same way, so that only new files are read.
+	 *
+	 * @param wildTypeCounts Counts of the wild type samples (one per k)
+	 * @param mutantCounts Counts of the mutant samples (one per k, nullptr: not counted)
+	 */
+	void sample_counts(std::vector<SampleCount> &wildTypeCounts,
+					   std::vector<SampleCount> *mutantCounts = nullptr) const;
+
+	/**
+	 * @brief Remove the counts kept in the checkpoint directory for this run.
+	 *
+	 * Called when the analyses of a kmer run are finished.
+	 */
+	void clear_checkpoints() const;
+
+private:
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Bitwise operation.
+	 *
+	 */
+	BitwiseOperation *bitwiseOperation;
+
+	/**
+	 * @brief Input the read data for the count stage.
+	 *
+	 */
+	FastqCount *fastqCount;
+
+	/**
+	 * @brief K-mers of the run for the log (16,20,...).
+	 *
+	 * @return K-mers connected with comma
+	 */
+	std::string kmer_list() const;
+
+	/**
+	 * @brief Empty counts of a FASTQ file for all k of the run (header only).
+	 *
+	 * @param fastqFile FASTQ file
+	 * @param vector_hash Hash of the vector sequence
+	 * @return Counts of the file (one per k)
+	 */
+	std::vector<SampleCount> empty_counts(const std::string &fastqFile, const u_int64_t vector_hash) const;
+
+	/**
+	 * @brief Counts of a FASTQ file for all k of the run.
+	 *
+	 * With -p, the counts are saved to the checkpoint directory after each block
+	 * of reads (-r), and a scan interrupted before resumes from its checkpoint.
+	 *
+	 * @param fastqFile FASTQ file
+	 * @param vector_hash Hash of the vector sequence
+	 * @return Counts of the file (one per k)
+	 */
+	std::vector<SampleCount> count_file(const std::string &fastqFile, const u_int64_t vector_hash) const;
+
+	/**
+	 * @brief Read the mutant files one after another until the sequential rule decides (-e).
+	 *
+	 * @param mutantCounts Counts of the mutant samples (one per k)
+	 * @param wildTypeCounts Counts of the wild type samples (one per k)
+	 * @return Number of files read
+	 */
+	size_t sequential_counts(std::vector<SampleCount> &mutantCounts,
+							 const std::vector<SampleCount> &wildTypeCounts) const;
+
+	/**
+	 * @brief Name of the count file of counts made by count_file.
+	 *
+	 * @param sampleCount Counts of a FASTQ file
+	 * @return Count file name (without directory)
+	 */
+	std::string count_name(const SampleCount &sampleCount) const;
+
+	/**
+	 * @brief Load the saved counts of a FASTQ file for all k.
+	 *
+	 * @param sampleCounts Counts of the file (one per k, header from empty_counts)
+	 * @param directory Directory of the count files
+	 * @param suffix Suffix after the count file name (".ckpt" for checkpoints)
+	 * @return true if the counts of all k were saved by the same kind of scan
+	 */
+	bool load_saved(std::vector<SampleCount> &sampleCounts, const std::string &directory,
+					const std::string &suffix) const;
+
+	/**
+	 * @brief Remove the saved counts of a FASTQ file from the checkpoint directory.
+	 *
+	 * @param sampleCounts Counts of the file (one per k)
+	 * @param suffix Suffix after the count file name (".ckpt" for checkpoints)
+	 */
+	void remove_saved(const std::vector<SampleCount> &sampleCounts, const std::string &suffix) const;
+
+	/**
+	 * @brief Hash of the vector sequences.
+	 *
+	 * @return Hash
+	 */
+	u_int64_t vector_hash() const;
+
+	/**
+	 * @brief Check that a count file fits the current options.
+	 *
+	 * @param sampleCount Counts of a sample
+	 * @param vector_hash Hash of the vector sequence
+	 * @param kmer K-mer
+	 * @return Reason why the counts can not be used (empty if they can)
+	 */
+	std::string check_count(const SampleCount &sampleCount, const u_int64_t vector_hash,
+							const unsigned int kmer) const;
+
+	/**
+	 * @brief Load the counts of a sample and add them.
+	 *
+	 * @param file FASTQ file (looked up in the cache directory) or count file (.cnt)
+	 * @param vector_hash Hash of the vector sequence
+	 * @param sampleCount Counts of the samples
+	 */
+	void load_count(const std::string &file, const u_int64_t vector_hash,
+					SampleCount &sampleCount) const;
+};
+#endif /* KMER_COUNT_H_ */
@@ -10,14 +10,14 @@
  *
  * @param options Execution options.
  * @param bitwiseOperation Bitwise operation.
- * @param statisticsFile Create statistics files.
+ * @param statisticsFiles Create statistics files (one per vector).
  */
 KmerExtension::KmerExtension(Options *options, BitwiseOperation *bitwiseOperation,
-							 StatisticsFile *statisticsFile)
+							 const std::vector<StatisticsFile *> &statisticsFiles)
 {
 	this->options = options;
 	this->bitwiseOperation = bitwiseOperation;
-	this->statisticsFile = statisticsFile;
+	this->statisticsFiles = statisticsFiles;
 
 	// FASTQ extension
 	this->fastqExtension = new FastqExtension(this->options, this->bitwiseOperation);
@@ -34,8 +34,9 @@ KmerExtension::~KmerExtension()
 /**
  * @brief Execute extension analysis of k-mer.
  *
+ * @param wildTypeCount Cached counts of the wild type samples (nullptr: read the wild type files)
  */
-void KmerExtension::execution() const
+void KmerExtension::execution(const SampleCount *wildTypeCount) const
 {
 	std::cout << "\n---------- Extension analysis of k-mer (FDR <= "
 			  << this->options->threshold_fdr << ") ----------" << std::endl;
@@ -50,6 +51,9 @@ void KmerExtension::execution() const
 		return;
 	}
 
+	// Create the k-mer index.
+	this->create_merIndex(mutantMerCounter);
+
 	// Wild type mer pairs at each end
 	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> wildTypeMerCounter(mutantMerCounter);
 
@@ -57,8 +61,9 @@ void KmerExtension::execution() const
 	u_int64_t mutantMerTotalCounter = 0;
 	u_int64_t wildTypeMerTotalCounter = 0;
 
-	// Number of fastq files
+	// Number of fastq files (only the mutant files are read if the wild type counts are cached)
 	const size_t nMutant = this->options->mutant_files.size();
+	const size_t nSample = wildTypeCount ? nMutant : this->options->number_of_samples();
 
 	// Mer pair
 	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> merPair;
@@ -75,7 +80,7 @@ void KmerExtension::execution() const
 #pragma omp parallel for num_threads(this->options->outer_parallel) private(merTotalCounter, merPair) \
 	reduction(+ : mutantMerTotalCounter, wildTypeMerTotalCounter)
 #endif
-	for (size_t i = 0; i < this->options->number_of_samples(); i++)
+	for (size_t i = 0; i < nSample; i++)
 	{
 		merTotalCounter = 0;
 		if (i < nMutant)
@@ -84,18 +89,26 @@ void KmerExtension::execution() const
 			merPair = this->fastqExtension->read_fastqFile(this->options->mutant_files[i],
 														   mutantMerCounter, merTotalCounter);
 			mutantMerTotalCounter += merTotalCounter;
+			Metrics::Stopwatch merge;
+			Trace::Span wait(this->options->trace, "wait mutantPair", this->options->mutant_files[i]);
 #ifdef _OPENMP
 #pragma omp critical(mutantPair)
 #endif
-			for (auto itr = merPair.begin(); itr != merPair.end(); ++itr)
 			{
-				for (auto itr_second = itr->second.begin();
-					 itr_second != itr->second.end(); ++itr_second)
+				wait.stop();
+				Trace::Span span(this->options->trace, "merge", this->options->mutant_files[i]);
+				for (auto itr = merPair.begin(); itr != merPair.end(); ++itr)
 				{
-					mutantMerCounter[itr->first].push_back(
-						std::make_pair(itr_second->first, itr_second->second));
+					for (auto itr_second = itr->second.begin();
+						 itr_second != itr->second.end(); ++itr_second)
+					{
+						mutantMerCounter[itr->first].push_back(
+							std::make_pair(itr_second->first, itr_second->second));
+					}
 				}
 			}
+			Metrics::Counters counters;
+			this->options->metrics.add("merge", this->options->mutant_files[i], merge.stop(counters));
 		}
 		else
 		{
@@ -103,37 +116,105 @@ void KmerExtension::execution() const
 			merPair = this->fastqExtension->read_fastqFile(this->options->wildType_files[i - nMutant],
 														   wildTypeMerCounter, merTotalCounter);
 			wildTypeMerTotalCounter += merTotalCounter;
+			Metrics::Stopwatch merge;
+			Trace::Span wait(this->options->trace, "wait wildTypePair", this->options->wildType_files[i - nMutant]);
 #ifdef _OPENMP
 #pragma omp critical(wildTypePair)
 #endif
-			for (auto itr = merPair.begin(); itr != merPair.end(); ++itr)
 			{
-				for (auto itr_second = itr->second.begin();
-					 itr_second != itr->second.end(); ++itr_second)
+				wait.stop();
+				Trace::Span span(this->options->trace, "merge", this->options->wildType_files[i - nMutant]);
+				for (auto itr = merPair.begin(); itr != merPair.end(); ++itr)
 				{
-					wildTypeMerCounter[itr->first].push_back(
-						std::make_pair(itr_second->first, itr_second->second));
+					for (auto itr_second = itr->second.begin();
+						 itr_second != itr->second.end(); ++itr_second)
+					{
+						wildTypeMerCounter[itr->first].push_back(
+							std::make_pair(itr_second->first, itr_second->second));
+					}
 				}
 			}
+			Metrics::Counters counters;
+			this->options->metrics.add("merge", this->options->wildType_files[i - nMutant], merge.stop(counters));
 		}
 	}
 
+	if (wildTypeCount)
+	{
+		const unsigned int nbase = this->options->bases_on_each_side;
+		wildTypeCount->add_merPair(nbase, wildTypeMerCounter);
+		wildTypeMerTotalCounter = wildTypeCount->mer_total(nbase);
+	}
+
+	this->create_results(mutantMerCounter, wildTypeMerCounter,
+						 mutantMerTotalCounter, wildTypeMerTotalCounter);
+}
+
+/**
+ * @brief Execute extension analysis of k-mer from the counts of the samples.
+ *
+ * @param mutantCount Counts of the mutant samples
+ * @param wildTypeCount Counts of the wild type samples
+ */
+void KmerExtension::execution(const SampleCount &mutantCount, const SampleCount &wildTypeCount) const
+{
+	std::cout << "\n---------- Extension analysis of k-mer (FDR <= "
+			  << this->options->threshold_fdr << ") ----------" << std::endl;
+
+	// Mutant mer pairs at each end
+	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> mutantMerCounter;
+
+	// Set k-mer pairs
+	if (this->set_merCounter(mutantMerCounter) == 0)
+	{
+		std::cout << "Count of target mer    = 0" << std::endl;
+		return;
+	}
+	std::cout << "Count of target mer    = " << mutantMerCounter.size() << std::endl;
+
+	// Wild type mer pairs at each end
+	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> wildTypeMerCounter(mutantMerCounter);
+
+	const unsigned int nbase = this->options->bases_on_each_side;
+	mutantCount.add_merPair(nbase, mutantMerCounter);
+	wildTypeCount.add_merPair(nbase, wildTypeMerCounter);
+
+	this->create_results(mutantMerCounter, wildTypeMerCounter,
+						 mutantCount.mer_total(nbase), wildTypeCount.mer_total(nbase));
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Write the outside.txt file.
+ *
+ * @param mutantMerCounter Mutant mer pairs at each end
+ * @param wildTypeMerCounter Wild type mer pairs at each end
+ * @param mutantMerTotalCounter Count of mutant total mer
+ * @param wildTypeMerTotalCounter Count of wild type total mer
+ */
+void KmerExtension::create_results(
+	const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &mutantMerCounter,
+	const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &wildTypeMerCounter,
+	const u_int64_t mutantMerTotalCounter, const u_int64_t wildTypeMerTotalCounter) const
+{
 	std::cout << "Count of mutant mer    = " << mutantMerTotalCounter << std::endl;
 	std::cout << "Count of wild type mer = " << wildTypeMerTotalCounter << std::endl;
 
 	if (this->options->threshold_fdr >= 0.0)
 	{
-		// Set mer total count.
-		this->statisticsFile->set_merCounter(mutantMerTotalCounter, wildTypeMerTotalCounter);
+		for (auto itr = this->statisticsFiles.begin(); itr != this->statisticsFiles.end(); ++itr)
+		{
+			// Set mer total count.
+			(*itr)->set_merCounter(mutantMerTotalCounter, wildTypeMerTotalCounter);
 
-		// Write the output.txt file.
-		this->statisticsFile->create_outsideFile(mutantMerCounter, wildTypeMerCounter);
+			// Write the output.txt file.
+			(*itr)->create_outsideFile(mutantMerCounter, wildTypeMerCounter);
+		}
 	}
 }
 
-//============================================================================//
-// Private function
-//============================================================================//
 /**
  * @brief Set k-mer in hash table.
  *
@@ -144,54 +225,42 @@ unsigned int KmerExtension::set_merCounter(
 	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &mutantMerCounter) const
 {
 	Complementary complementary;
-	const std::string vectorArray = this->statisticsFile->get_vectorArray();
-	const std::unordered_map<unsigned int, double> fdr = this->statisticsFile->get_fdr();
-
-	// Set k-mer pairs
 	std::vector<std::pair<std::string, std::string>> listPair;
-	for (auto itr = fdr.begin(); itr != fdr.end(); ++itr)
+
+	// Set k-mer pairs of all vectors
+	for (auto itr_file = this->statisticsFiles.begin(); itr_file != this->statisticsFiles.end(); ++itr_file)
 	{
-		if (itr->second <= this->options->threshold_fdr)
+		const std::string vectorArray = (*itr_file)->get_vectorArray();
+		const std::vector<double> &fdr = (*itr_file)->get_fdr();
+
+		for (size_t i = 0; i < fdr.size(); i++)
 		{
-			const std::string mer = vectorArray.substr(itr->first, this->options->kmer);
-			// Obtain the complementary sequence of k-mer.
-			const std::string revMer = complementary.mer(mer);
-			mutantMerCounter[mer] = listPair;
-			mutantMerCounter[revMer] = listPair;
+			if (fdr[i] <= this->options->threshold_fdr)
+			{
+				const std::string mer = vectorArray.substr(i, this->options->kmer);
+				// Obtain the complementary sequence of k-mer.
+				const std::string revMer = complementary.mer(mer);
+				mutantMerCounter[mer] = listPair;
+				mutantMerCounter[revMer] = listPair;
+			}
 		}
 	}
-	// Create chunk array.
-	this->create_chunk(mutantMerCounter);
-
 	return mutantMerCounter.size();
 }
 
 /**
- * @brief Create chunk array.
+ * @brief Create the k-mer index.
  *
  * @param merCounter Mer counter at each end
  */
-void KmerExtension::create_chunk(
+void KmerExtension::create_merIndex(
 	const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merCounter) const
 {
-	unsigned char *dna2bit = this->bitwiseOperation->get_dna2bit();
-	unsigned char *chunk = this->bitwiseOperation->get_chunk();
-
-	for (unsigned int i = 0; i < this->options->max_chunk_array; i++)
-	{
-		chunk[i] = 0;
-	}
-
+	MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+	merIndex->clear(this->options->kmer);
 	for (auto itr = merCounter.begin(); itr != merCounter.end(); ++itr)
 	{
-		unsigned int dnabit = dna2bit[(unsigned char)itr->first[0]];
-		for (unsigned int i = 1; i < this->options->chunk_length; i++)
-		{
-			dnabit = (dnabit << 2) + dna2bit[(unsigned char)itr->first[i]];
-		}
-		if (dnabit != this->options->max_chunk_array)
-		{
-			chunk[dnabit] = 1;
-		}
+		merIndex->add(itr->first);
 	}
+	this->bitwiseOperation->replicate_merIndexes();
 }
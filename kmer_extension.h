@@ -8,6 +8,7 @@
 #include "bitwise_operation.h"
 #include "statistics_file.h"
 #include "fastq_extension.h"
+#include "sample_count.h"
 
 /**
  * @brief Extension analysis of k-mer.
@@ -21,10 +22,10 @@ public:
 	 *
 	 * @param options Execution options.
 	 * @param bitwiseOperation Bitwise operation.
-	 * @param statisticsFile Create statistics files.
+	 * @param statisticsFiles Create statistics files (one per vector).
 	 */
 	KmerExtension(Options *options, BitwiseOperation *bitwiseOperation,
-				  StatisticsFile *statisticsFile);
+				  const std::vector<StatisticsFile *> &statisticsFiles);
 
 	/**
 	 * @brief Destroy the Kmer Extension object
@@ -35,8 +36,17 @@ public:
 	/**
 	 * @brief Execute extension analysis of k-mer.
 	 *
+	 * @param wildTypeCount Cached counts of the wild type samples (nullptr: read the wild type files)
 	 */
-	void execution() const;
+	void execution(const SampleCount *wildTypeCount = nullptr) const;
+
+	/**
+	 * @brief Execute extension analysis of k-mer from the counts of the samples.
+	 *
+	 * @param mutantCount Counts of the mutant samples
+	 * @param wildTypeCount Counts of the wild type samples
+	 */
+	void execution(const SampleCount &mutantCount, const SampleCount &wildTypeCount) const;
 
 private:
 	/**
@@ -55,7 +65,7 @@ private:
 	 * @brief Run statistical analysis.
 	 *
 	 */
-	StatisticsFile *statisticsFile;
+	std::vector<StatisticsFile *> statisticsFiles;
 
 	/**
 	 * @brief Input the read data for the extension analysis.
@@ -63,6 +73,19 @@ private:
 	 */
 	FastqExtension *fastqExtension;
 
+	/**
+	 * @brief Write the outside.txt file.
+	 *
+	 * @param mutantMerCounter Mutant mer pairs at each end
+	 * @param wildTypeMerCounter Wild type mer pairs at each end
+	 * @param mutantMerTotalCounter Count of mutant total mer
+	 * @param wildTypeMerTotalCounter Count of wild type total mer
+	 */
+	void create_results(
+		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &mutantMerCounter,
+		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &wildTypeMerCounter,
+		const u_int64_t mutantMerTotalCounter, const u_int64_t wildTypeMerTotalCounter) const;
+
 	/**
 	 * @brief Set k-mer in hash table.
 	 *
@@ -75,12 +98,11 @@ private:
 		std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merCounter) const;
 
 	/**
-	 * @brief Create chunk array.
+	 * @brief Create the k-mer index.
 	 *
 	 * @param merCounter Mer counter at each end
-	 * @param chunk For bitwise operation. Chunk array.
 	 */
-	void create_chunk(
+	void create_merIndex(
 		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merCounter) const;
 };
 #endif /* KMER_EXTENSION_H_ */
@@ -2,23 +2,24 @@
  * GenEditScan
  * Copyright 2018 National Agriculture and Food Research Organization (NARO)
  */
-#include <fstream>
 #include "kmer_match.h"
 #include "vector_sequence.h"
+#include "result_writer.h"
+#include "mer_code.h"
 
 /**
  * @brief Construct a new Kmer Match:: Kmer Match object
  *
  * @param options Execution options.
  * @param bitwiseOperation Bitwise operation.
- * @param statisticsFile Create statistics files.
+ * @param statisticsFiles Create statistics files (one per vector).
  */
 KmerMatch::KmerMatch(Options *options, BitwiseOperation *bitwiseOperation,
-					 StatisticsFile *statisticsFile)
+					 const std::vector<StatisticsFile *> &statisticsFiles)
 {
 	this->options = options;
 	this->bitwiseOperation = bitwiseOperation;
-	this->statisticsFile = statisticsFile;
+	this->statisticsFiles = statisticsFiles;
 
 	// FASTQ match
 	this->fastqMatch = new FastqMatch(this->options, this->bitwiseOperation);
@@ -35,37 +36,32 @@ KmerMatch::~KmerMatch()
 /**
  * @brief Execute match analysis of k-mer.
  *
+ * @param wildTypeCount Cached counts of the wild type samples (nullptr: read the wild type files)
  */
-void KmerMatch::execution() const
+void KmerMatch::execution(const SampleCount *wildTypeCount) const
 {
 	std::cout << "\n---------- Match analysis of k-mer (K-mer = "
 			  << this->options->kmer << ") ----------" << std::endl;
 
-	// Position and k-mer complementary pair on vector
-	std::unordered_map<unsigned int, std::pair<std::string, std::string>> vectorPosPair;
-
-	// Mutant mer counter
-	std::unordered_map<std::string, unsigned int> mutantMerCounter;
-
 	// Read the vector file
-	VectorSequence *vectorSequence = new VectorSequence(this->options, this->bitwiseOperation);
-	const std::string vectorArray = vectorSequence->read_vectorFile(mutantMerCounter, vectorPosPair);
-
-	this->statisticsFile->set_vectorArray(vectorArray);
-	this->statisticsFile->set_vectorPosPair(vectorPosPair);
+	std::set<std::string> otherMers;
+	this->set_vectors(otherMers);
+	const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
 
-	// Wild type mer counter
-	std::unordered_map<std::string, unsigned int> wildTypeMerCounter(mutantMerCounter);
+	// Mutant and wild type mer counters (indexed by the mer ids)
+	std::vector<unsigned int> mutantMerCounter(merIndex->size(), 0);
+	std::vector<unsigned int> wildTypeMerCounter(merIndex->size(), 0);
 
 	// Counter
 	u_int64_t mutantMerTotalCounter = 0;
 	u_int64_t wildTypeMerTotalCounter = 0;
 
-	// Number of fastq files
+	// Number of fastq files (only the mutant files are read if the wild type counts are cached)
 	const size_t nMutant = this->options->mutant_files.size();
+	const size_t nSample = wildTypeCount ? nMutant : this->options->number_of_samples();
 
 	// Mer counter
-	std::unordered_map<std::string, unsigned int> merCounter;
+	std::vector<unsigned int> merCounter;
 
 	// Total mer counter
 	u_int64_t merTotalCounter = 0;
@@ -79,64 +75,228 @@ void KmerMatch::execution() const
 #pragma omp parallel for num_threads(this->options->outer_parallel) private(merTotalCounter, merCounter) \
 	reduction(+ : mutantMerTotalCounter, wildTypeMerTotalCounter)
 #endif
-	for (size_t i = 0; i < this->options->number_of_samples(); i++)
+	for (size_t i = 0; i < nSample; i++)
 	{
 		merTotalCounter = 0;
 		if (i < nMutant)
 		{
 			// Read the fastq.gz file (mutant_files)
-			merCounter = this->fastqMatch->read_fastqFile(this->options->mutant_files[i],
-														  mutantMerCounter, merTotalCounter);
+			merCounter = this->fastqMatch->read_fastqFile(this->options->mutant_files[i], merTotalCounter);
 			mutantMerTotalCounter += merTotalCounter;
+			Metrics::Stopwatch merge;
+			Trace::Span wait(this->options->trace, "wait mutant", this->options->mutant_files[i]);
 #ifdef _OPENMP
 #pragma omp critical(mutant)
 #endif
-			for (auto itr = mutantMerCounter.begin(); itr != mutantMerCounter.end(); ++itr)
 			{
-				mutantMerCounter[itr->first] += merCounter[itr->first];
+				wait.stop();
+				Trace::Span span(this->options->trace, "merge", this->options->mutant_files[i]);
+				for (size_t id = 0; id < merCounter.size(); id++)
+				{
+					mutantMerCounter[id] += merCounter[id];
+				}
 			}
+			Metrics::Counters counters;
+			this->options->metrics.add("merge", this->options->mutant_files[i], merge.stop(counters));
 		}
 		else
 		{
 			// Read the fastq.gz file (wildType_files)
 			merCounter = this->fastqMatch->read_fastqFile(this->options->wildType_files[i - nMutant],
-														  wildTypeMerCounter, merTotalCounter);
+														  merTotalCounter);
 			wildTypeMerTotalCounter += merTotalCounter;
+			Metrics::Stopwatch merge;
+			Trace::Span wait(this->options->trace, "wait wildType", this->options->wildType_files[i - nMutant]);
 #ifdef _OPENMP
 #pragma omp critical(wildType)
 #endif
-			for (auto itr = wildTypeMerCounter.begin(); itr != wildTypeMerCounter.end(); ++itr)
 			{
-				wildTypeMerCounter[itr->first] += merCounter[itr->first];
+				wait.stop();
+				Trace::Span span(this->options->trace, "merge", this->options->wildType_files[i - nMutant]);
+				for (size_t id = 0; id < merCounter.size(); id++)
+				{
+					wildTypeMerCounter[id] += merCounter[id];
+				}
 			}
+			Metrics::Counters counters;
+			this->options->metrics.add("merge", this->options->wildType_files[i - nMutant], merge.stop(counters));
 		}
 	}
 
-	std::cout << "Count of mutant mer    = " << mutantMerTotalCounter << std::endl;
-	std::cout << "Count of wild type mer = " << wildTypeMerTotalCounter << std::endl;
+	if (wildTypeCount)
+	{
+		wildTypeCount->add_merCounter(*merIndex, wildTypeMerCounter);
+		wildTypeMerTotalCounter = wildTypeCount->mer_total(0);
+	}
 
-	this->control_freqFile(mutantMerCounter, wildTypeMerCounter);
+	this->create_results(mutantMerCounter, wildTypeMerCounter, otherMers,
+						 mutantMerTotalCounter, wildTypeMerTotalCounter);
+}
 
-	// Set mer total count.
-	this->statisticsFile->set_merCounter(mutantMerTotalCounter, wildTypeMerTotalCounter);
+/**
+ * @brief Execute match analysis of k-mer from the counts of the samples.
+ *
+ * @param mutantCount Counts of the mutant samples
+ * @param wildTypeCount Counts of the wild type samples
+ */
+void KmerMatch::execution(const SampleCount &mutantCount, const SampleCount &wildTypeCount) const
+{
+	std::cout << "\n---------- Match analysis of k-mer (K-mer = "
+			  << this->options->kmer << ") ----------" << std::endl;
+
+	// Read the vector file
+	std::set<std::string> otherMers;
+	this->set_vectors(otherMers);
+	const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+
+	// Mutant and wild type mer counters (indexed by the mer ids)
+	std::vector<unsigned int> mutantMerCounter(merIndex->size(), 0);
+	std::vector<unsigned int> wildTypeMerCounter(merIndex->size(), 0);
+
+	mutantCount.add_merCounter(*merIndex, mutantMerCounter);
+	wildTypeCount.add_merCounter(*merIndex, wildTypeMerCounter);
 
-	// Write the statistics.txt file.
-	this->statisticsFile->create_statisticsFile();
+	this->create_results(mutantMerCounter, wildTypeMerCounter, otherMers,
+						 mutantCount.mer_total(0), wildTypeCount.mer_total(0));
 }
 
 //============================================================================//
 // Private function
 //============================================================================//
+/**
+ * @brief Read the vector file and set the vectors of the statistics files.
+ *
+ * @param otherMers K-mers with a base other than ACGT
+ */
+void KmerMatch::set_vectors(std::set<std::string> &otherMers) const
+{
+	// Ids of the k-mer and its complementary k-mer at each position of each vector
+	std::vector<PositionIds> vectorPosIds;
+
+	VectorSequence *vectorSequence = new VectorSequence(this->options, this->bitwiseOperation);
+	const std::vector<std::string> vectorArrays = vectorSequence->read_vectorFile(vectorPosIds, otherMers);
+	delete vectorSequence;
+
+	for (size_t i = 0; i < this->statisticsFiles.size(); i++)
+	{
+		this->statisticsFiles[i]->set_vectorArray(vectorArrays[i]);
+		this->statisticsFiles[i]->set_vectorPosIds(vectorPosIds[i]);
+	}
+}
+
+/**
+ * @brief Write merFreq.txt and statistics.txt files.
+ *
+ * @param mutantMerCounter Mutant mer counter
+ * @param wildTypeMerCounter Wild type mer counter
+ * @param otherMers K-mers with a base other than ACGT
+ * @param mutantMerTotalCounter Count of mutant total mer
+ * @param wildTypeMerTotalCounter Count of wild type total mer
+ */
+void KmerMatch::create_results(
+	const std::vector<unsigned int> &mutantMerCounter,
+	const std::vector<unsigned int> &wildTypeMerCounter,
+	const std::set<std::string> &otherMers,
+	const u_int64_t mutantMerTotalCounter, const u_int64_t wildTypeMerTotalCounter) const
+{
+	std::cout << "Count of mutant mer    = " << mutantMerTotalCounter << std::endl;
+	std::cout << "Count of wild type mer = " << wildTypeMerTotalCounter << std::endl;
+	if (this->options->fraction < 1.0)
+	{
+		// The G-test uses the counts of the subsample; both groups have the same fraction.
+		std::cout << "Fraction of the reads  = " << this->options->fraction << " (about "
+				  << (u_int64_t)(mutantMerTotalCounter / this->options->fraction) << " mutant and "
+				  << (u_int64_t)(wildTypeMerTotalCounter / this->options->fraction)
+				  << " wild type mer in all reads)" << std::endl;
+	}
+
+	this->control_freqFile(mutantMerCounter, wildTypeMerCounter, otherMers);
+
+	for (auto itr = this->statisticsFiles.begin(); itr != this->statisticsFiles.end(); ++itr)
+	{
+		// Set mer total count.
+		(*itr)->set_merCounter(mutantMerTotalCounter, wildTypeMerTotalCounter);
+
+		// Write the statistics.txt file.
+		(*itr)->create_statisticsFile();
+	}
+
+	// Write the elements.txt file (several vectors).
+	if (this->statisticsFiles.size() > 1)
+	{
+		this->create_elementsFile();
+	}
+}
+
+/**
+ * @brief Write the elements.txt file (summary of each vector).
+ *
+ */
+void KmerMatch::create_elementsFile() const
+{
+	// Number of vectors having each k-mer
+	std::vector<unsigned int> elements(this->bitwiseOperation->get_merIndex()->size(), 0);
+	std::vector<unsigned int> lastElement(elements.size(), 0);
+	for (size_t e = 0; e < this->statisticsFiles.size(); e++)
+	{
+		const PositionIds &posIds = this->statisticsFiles[e]->get_vectorPosIds();
+		for (auto itr = posIds.begin(); itr != posIds.end(); ++itr)
+		{
+			for (const u_int32_t id : {itr->first, itr->second})
+			{
+				if (id == MerIndex::NOT_FOUND)
+				{
+					continue;
+				}
+				if (elements[id] == 0 || lastElement[id] != e)
+				{
+					elements[id]++;
+					lastElement[id] = e;
+				}
+			}
+		}
+	}
+
+	Metrics::Stopwatch write;
+	Trace::Span writeSpan(this->options->trace, "write", this->options->out_prefix + ".elements");
+	const std::string outfile = ResultWriter::file_name(
+		this->options->out_prefix + ".elements.txt", this->options->compress);
+	ResultWriter ofs(outfile);
+	ofs << "#K-mer\t" << this->options->kmer << "\tFDR\t" << this->options->threshold_fdr << '\n';
+	ofs << "#Element\tLength\tShared\tDetected\tMutantMax\tWildTypeMax\tGvalMax\tFDRMin\n";
+	for (auto itr_file = this->statisticsFiles.begin(); itr_file != this->statisticsFiles.end(); ++itr_file)
+	{
+		// Positions whose k-mer is also in another vector
+		unsigned int shared = 0;
+		const PositionIds &posIds = (*itr_file)->get_vectorPosIds();
+		for (auto itr = posIds.begin(); itr != posIds.end(); ++itr)
+		{
+			if (itr->first != MerIndex::NOT_FOUND && elements[itr->first] > 1)
+			{
+				shared++;
+			}
+		}
+		(*itr_file)->write_element(ofs, shared);
+	}
+	ofs.close();
+	this->options->metrics.add_written(outfile, write);
+}
+
 /**
  * @brief Set position frequencies and write merFreq.txt files.
  *
  * @param mutantMerCounter Mutant mer counter
  * @param wildTypeMerCounter Wild type mer counter
+ * @param otherMers K-mers with a base other than ACGT
  */
 void KmerMatch::control_freqFile(
-	const std::unordered_map<std::string, unsigned int> &mutantMerCounter,
-	const std::unordered_map<std::string, unsigned int> &wildTypeMerCounter) const
+	const std::vector<unsigned int> &mutantMerCounter,
+	const std::vector<unsigned int> &wildTypeMerCounter,
+	const std::set<std::string> &otherMers) const
 {
+	// K-mers in the order of the strings (for both merFreq files)
+	const std::vector<std::pair<u_int64_t, unsigned int>> sortedMers = this->sort_mers();
+
 //========== Output ==========//
 #ifdef _OPENMP
 #pragma omp parallel sections
@@ -144,15 +304,16 @@ void KmerMatch::control_freqFile(
 #pragma omp section
 		{
 #endif
-			std::map<unsigned int, std::pair<std::string, std::string>> vectorPosPair(
-				this->statisticsFile->get_vectorPosPair().begin(),
-				this->statisticsFile->get_vectorPosPair().end());
+			for (auto itr = this->statisticsFiles.begin(); itr != this->statisticsFiles.end(); ++itr)
+			{
+				const PositionIds &posIds = (*itr)->get_vectorPosIds();
 
-			// Set position frequencies.
-			const std::vector<unsigned int> mutantPosFreq = this->set_posFreq(mutantMerCounter, vectorPosPair);
-			const std::vector<unsigned int> wildTypePosFreq = this->set_posFreq(wildTypeMerCounter, vectorPosPair);
-			this->statisticsFile->set_mutantPosFreq(mutantPosFreq);
-			this->statisticsFile->set_wildTypePosFreq(wildTypePosFreq);
+				// Set position frequencies.
+				const std::vector<unsigned int> mutantPosFreq = this->set_posFreq(mutantMerCounter, posIds);
+				const std::vector<unsigned int> wildTypePosFreq = this->set_posFreq(wildTypeMerCounter, posIds);
+				(*itr)->set_mutantPosFreq(mutantPosFreq);
+				(*itr)->set_wildTypePosFreq(wildTypePosFreq);
+			}
 
 #ifdef _OPENMP
 		}
@@ -160,8 +321,13 @@ void KmerMatch::control_freqFile(
 		{
 #endif
 			// Create merFreq.txt file.
-			this->create_merFreqFile(mutantMerCounter, ".mutant");
-			this->create_merFreqFile(wildTypeMerCounter, ".wildtype");
+			this->create_merFreqFile(mutantMerCounter, sortedMers, otherMers, ".mutant");
+#ifdef _OPENMP
+		}
+#pragma omp section
+		{
+#endif
+			this->create_merFreqFile(wildTypeMerCounter, sortedMers, otherMers, ".wildtype");
 #ifdef _OPENMP
 		}
 	}
@@ -171,20 +337,22 @@ void KmerMatch::control_freqFile(
 /**
  * @brief Set position frequencies.
  *
- * @param merCounter Counter of each mer
- * @param vectorPosPair Position and k-mer complementary pair on vector
+ * @param merCounter Counter of each mer id
+ * @param posIds Ids of the k-mer and its complementary k-mer at each position on vector
  * @return Position frequencies
  */
 std::vector<unsigned int> KmerMatch::set_posFreq(
-	const std::unordered_map<std::string, unsigned int> &merCounter,
-	std::map<unsigned int, std::pair<std::string, std::string>> &vectorPosPair) const
+	const std::vector<unsigned int> &merCounter,
+	const PositionIds &posIds) const
 {
 	std::vector<unsigned int> posBothFreq;
-	for (std::map<unsigned int, std::pair<std::string, std::string>>::iterator itr = vectorPosPair.begin();
-		 itr != vectorPosPair.end(); ++itr)
+	posBothFreq.reserve(posIds.size());
+	for (auto itr = posIds.begin(); itr != posIds.end(); ++itr)
 	{
-		const unsigned int merBothCounter = merCounter.at(itr->second.first) +
-										 merCounter.at(itr->second.second);
+		// A k-mer with a base other than ACGT is never counted.
+		const unsigned int merBothCounter =
+			(itr->first == MerIndex::NOT_FOUND ? 0 : merCounter[itr->first]) +
+			(itr->second == MerIndex::NOT_FOUND ? 0 : merCounter[itr->second]);
 		posBothFreq.push_back(merBothCounter);
 	}
 	return posBothFreq;
@@ -193,26 +361,99 @@ std::vector<unsigned int> KmerMatch::set_posFreq(
 /**
  * @brief Create merFreq.txt file.
  *
- * @param merCounter Counter of each mer
+ * @param merCounter Counter of each mer id
+ * @param sortedMers Codes and ids of the k-mers in the order of the strings
+ * @param otherMers K-mers with a base other than ACGT
  * @param type '_mutant' or '_wildtype'
  */
-void KmerMatch::create_merFreqFile(const std::unordered_map<std::string, unsigned int> &merCounter,
+void KmerMatch::create_merFreqFile(const std::vector<unsigned int> &merCounter,
+								   const std::vector<std::pair<u_int64_t, unsigned int>> &sortedMers,
+								   const std::set<std::string> &otherMers,
 								   const std::string type) const
 {
-	const std::string outfile = this->options->out_prefix + type + ".merFreq.txt";
-	std::ofstream ofs(outfile.c_str());
-	if (!ofs)
+	Metrics::Stopwatch write;
+	Trace::Span writeSpan(this->options->trace, "write", this->options->out_prefix + type + ".merFreq");
+	if (this->options->binary)
 	{
-		std::cerr << "[Error] Could not open (" << outfile << ")." << std::endl;
-		std::exit(1);
+		std::vector<std::string> mer_column;
+		std::vector<u_int32_t> count_column;
+		mer_column.reserve(merCounter.size() + otherMers.size());
+		count_column.reserve(merCounter.size() + otherMers.size());
+		this->output_merCounter(merCounter, sortedMers, otherMers, [&](const std::string &mer, const unsigned int count)
+							  {
+								  mer_column.push_back(mer);
+								  count_column.push_back(count); });
+
+		ColumnarWriter writer(this->options->out_prefix + type + ".merFreq.gesc");
+		this->statisticsFiles.front()->add_metaTable(writer, "merFreq");
+		writer.add_table("merFreq", mer_column.size());
+		writer.add_column("mer", mer_column);
+		writer.add_column("count", count_column);
+		writer.close();
+		this->options->metrics.add_written(this->options->out_prefix + type + ".merFreq.gesc", write);
+		return;
 	}
 
-	std::map<std::string, unsigned int> sortedCount(merCounter.begin(), merCounter.end());
+	const std::string outfile = ResultWriter::file_name(
+		this->options->out_prefix + type + ".merFreq.txt", this->options->compress);
+	ResultWriter ofs(outfile);
+	this->output_merCounter(merCounter, sortedMers, otherMers, [&ofs](const std::string &mer, const unsigned int count)
+						  { ofs << mer << '\t' << count << '\n'; });
+	ofs.close();
+	this->options->metrics.add_written(outfile, write);
+}
 
-	for (std::map<std::string, unsigned int>::iterator itr = sortedCount.begin();
-		 itr != sortedCount.end(); ++itr)
+/**
+ * @brief Codes and ids of the k-mers in the order of the strings.
+ *
+ * @return Codes and ids sorted by the code
+ */
+std::vector<std::pair<u_int64_t, unsigned int>> KmerMatch::sort_mers() const
+{
+	const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+	const u_int64_t *codes = merIndex->get_codes();
+	std::vector<std::pair<u_int64_t, unsigned int>> sortedMers;
+	sortedMers.reserve(merIndex->size());
+	for (size_t id = 0; id < merIndex->size(); id++)
 	{
-		ofs << itr->first << '\t' << itr->second << std::endl;
+		sortedMers.push_back(std::make_pair(codes[id], id));
+	}
+
+	// Sort the 2-bit codes; their order is the order of the k-mer strings.
+	MerCode::radix_sort(sortedMers, this->options->kmer);
+	return sortedMers;
+}
+
+/**
+ * @brief Output mer counts in the order of the k-mer strings.
+ *
+ * @param merCounter Counter of each mer id
+ * @param sortedMers Codes and ids of the k-mers in the order of the strings
+ * @param otherMers K-mers with a base other than ACGT (count 0)
+ * @param output Output of a k-mer and its count
+ */
+void KmerMatch::output_merCounter(
+	const std::vector<unsigned int> &merCounter,
+	const std::vector<std::pair<u_int64_t, unsigned int>> &sortedMers,
+	const std::set<std::string> &otherMers,
+	const std::function<void(const std::string &, const unsigned int)> &output) const
+{
+	const unsigned int kmer = this->options->kmer;
+	std::string mer(kmer, 'A');
+
+	// The other k-mers (already sorted) are merged in.
+	auto itr_other = otherMers.begin();
+	for (auto itr = sortedMers.begin(); itr != sortedMers.end(); ++itr)
+	{
+		MerCode::decode(itr->first, kmer, &mer[0]);
+		for (; itr_other != otherMers.end() && *itr_other < mer; ++itr_other)
+		{
+			output(*itr_other, 0);
+		}
+		output(mer, merCounter[itr->second]);
+	}
+	for (; itr_other != otherMers.end(); ++itr_other)
+	{
+		output(*itr_other, 0);
 	}
-	ofs.close();
 }
@@ -5,10 +5,12 @@
 #ifndef KMER_MATCH_H_
 #define KMER_MATCH_H_
 
-#include <map>
+#include <functional>
+#include <set>
 #include "bitwise_operation.h"
 #include "statistics_file.h"
 #include "fastq_match.h"
+#include "sample_count.h"
 
 /**
  * @brief Match analysis of k-mer.
@@ -22,10 +24,10 @@ public:
 	 *
 	 * @param options Execution options.
 	 * @param bitwiseOperation Bitwise operation.
-	 * @param statisticsFile Create statistics files.
+	 * @param statisticsFiles Create statistics files (one per vector).
 	 */
 	KmerMatch(Options *options, BitwiseOperation *bitwiseOperation,
-			  StatisticsFile *statisticsFile);
+			  const std::vector<StatisticsFile *> &statisticsFiles);
 
 	/**
 	 * @brief Destroy the Kmer Match object
@@ -36,8 +38,17 @@ public:
 	/**
 	 * @brief Execute match analysis of k-mer.
 	 *
+	 * @param wildTypeCount Cached counts of the wild type samples (nullptr: read the wild type files)
 	 */
-	void execution() const;
+	void execution(const SampleCount *wildTypeCount = nullptr) const;
+
+	/**
+	 * @brief Execute match analysis of k-mer from the counts of the samples.
+	 *
+	 * @param mutantCount Counts of the mutant samples
+	 * @param wildTypeCount Counts of the wild type samples
+	 */
+	void execution(const SampleCount &mutantCount, const SampleCount &wildTypeCount) const;
 
 private:
 	/**
@@ -56,7 +67,7 @@ private:
 	 * @brief Run statistical analysis.
 	 *
 	 */
-	StatisticsFile *statisticsFile;
+	std::vector<StatisticsFile *> statisticsFiles;
 
 	/**
 	 * @brief Input the read data for the match analysis.
@@ -64,34 +75,89 @@ private:
 	 */
 	FastqMatch *fastqMatch;
 
+	/**
+	 * @brief Read the vector file and set the vectors of the statistics files.
+	 *
+	 * @param otherMers K-mers with a base other than ACGT
+	 */
+	void set_vectors(std::set<std::string> &otherMers) const;
+
+	/**
+	 * @brief Write merFreq.txt and statistics.txt files.
+	 *
+	 * @param mutantMerCounter Mutant mer counter
+	 * @param wildTypeMerCounter Wild type mer counter
+	 * @param otherMers K-mers with a base other than ACGT
+	 * @param mutantMerTotalCounter Count of mutant total mer
+	 * @param wildTypeMerTotalCounter Count of wild type total mer
+	 */
+	void create_results(
+		const std::vector<unsigned int> &mutantMerCounter,
+		const std::vector<unsigned int> &wildTypeMerCounter,
+		const std::set<std::string> &otherMers,
+		const u_int64_t mutantMerTotalCounter, const u_int64_t wildTypeMerTotalCounter) const;
+
+	/**
+	 * @brief Write the elements.txt file (summary of each vector).
+	 *
+	 */
+	void create_elementsFile() const;
+
 	/**
 	 * @brief Set position frequencies and write merFreq.txt files.
 	 *
 	 * @param mutantMerCounter Mutant mer counter
 	 * @param wildTypeMerCounter Wild type mer counter
+	 * @param otherMers K-mers with a base other than ACGT
 	 */
 	void control_freqFile(
-		const std::unordered_map<std::string, unsigned int> &mutantMerCounter,
-		const std::unordered_map<std::string, unsigned int> &wildTypeMerCounter) const;
+		const std::vector<unsigned int> &mutantMerCounter,
+		const std::vector<unsigned int> &wildTypeMerCounter,
+		const std::set<std::string> &otherMers) const;
 
 	/**
 	 * @brief Set position frequencies.
 	 *
-	 * @param merCounter Counter of each mer
-	 * @param vectorPosPair Position and k-mer complementary pair on vector
+	 * @param merCounter Counter of each mer id
+	 * @param posIds Ids of the k-mer and its complementary k-mer at each position on vector
 	 * @return Position frequencies
 	 */
 	std::vector<unsigned int> set_posFreq(
-		const std::unordered_map<std::string, unsigned int> &merCounter,
-		std::map<unsigned int, std::pair<std::string, std::string>> &vectorPosPair) const;
+		const std::vector<unsigned int> &merCounter,
+		const PositionIds &posIds) const;
 
 	/**
 	 * @brief Create merFreq.txt file.
 	 *
-	 * @param merCounter Counter of each mer
+	 * @param merCounter Counter of each mer id
+	 * @param sortedMers Codes and ids of the k-mers in the order of the strings
+	 * @param otherMers K-mers with a base other than ACGT
 	 * @param type '.mutant' or '.wildtype'
 	 */
-	void create_merFreqFile(const std::unordered_map<std::string, unsigned int> &merCounter,
+	void create_merFreqFile(const std::vector<unsigned int> &merCounter,
+							const std::vector<std::pair<u_int64_t, unsigned int>> &sortedMers,
+							const std::set<std::string> &otherMers,
 							const std::string type) const;
+
+	/**
+	 * @brief Codes and ids of the k-mers in the order of the strings.
+	 *
+	 * @return Codes and ids sorted by the code
+	 */
+	std::vector<std::pair<u_int64_t, unsigned int>> sort_mers() const;
+
+	/**
+	 * @brief Output mer counts in the order of the k-mer strings.
+	 *
+	 * @param merCounter Counter of each mer id
+	 * @param sortedMers Codes and ids of the k-mers in the order of the strings
+	 * @param otherMers K-mers with a base other than ACGT (count 0)
+	 * @param output Output of a k-mer and its count
+	 */
+	void output_merCounter(
+		const std::vector<unsigned int> &merCounter,
+		const std::vector<std::pair<u_int64_t, unsigned int>> &sortedMers,
+		const std::set<std::string> &otherMers,
+		const std::function<void(const std::string &, const unsigned int)> &output) const;
 };
 #endif /* KMER_MATCH_H_ */
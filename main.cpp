@@ -6,13 +6,22 @@
 // Description : K-mer analysis tool
 //============================================================================//
 #include <getopt.h>
-#include <math.h>
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <sstream>
+#include <thread>
 #include "bitwise_operation.h"
 #include "statistics_file.h"
 #include "kmer_match.h"
 #include "kmer_extension.h"
+#include "kmer_count.h"
+#include "auto_tuner.h"
+#include "fastq_watch.h"
+#include "memory_planner.h"
+#include "vector_sequence.h"
+#include "columnar_file.h"
+#include "result_writer.h"
 
 /**
  * @brief Split the delimiter separator.
@@ -45,22 +54,288 @@ void help(const Options &options, const std::string &version, const std::string
 {
 	std::cerr << version << std::endl;
 	std::cerr << "Usage : " << execute << " kmer [options]\n";
+	std::cerr << "        " << execute << " count [options]  (count k-mer of each Fastq file once)\n";
+	std::cerr << "        " << execute << " test [options]   (analysis from the count files)\n";
+	std::cerr << "        " << execute << " watch [options]  (follow the -m files or directories while they are written)\n";
+	std::cerr << "        " << execute << " merge [-c dir] [-o prefix] file.cnt ...  (merge count files of shards or samples)\n";
+	std::cerr << "        " << execute << " index -v vector.fa [-k kmer] [-o prefix]  (write prefix.gidx)\n";
+	std::cerr << "        " << execute << " convert [-z none|gz|zst] file.gesc ...\n";
 	std::cerr << "\n[required]\n";
-	std::cerr << "-v | --vector   : Vector file\n";
+	std::cerr << "-v | --vector   : Vector file (fasta, or an index file made by index)\n";
 	std::cerr << "-m | --mutant   : Mutant files (connect with comma)\n";
 	std::cerr << "-w | --wild     : Wild type files (connect with comma)\n";
 	std::cerr << "\n[optional]\n";
-	std::cerr << "-k | --kmer     : K-mer (" << options.kmer << ")\n";
+	std::cerr << "-k | --kmer     : K-mer (" << options.kmer << "); several (connect with comma) are counted\n";
+	std::cerr << "                  in one pass and written to out_prefix.k<kmer>.*\n";
 	std::cerr << "-f | --fdr      : Threshold by FDR (" << options.threshold_fdr << ")\n";
 	std::cerr << "-b | --bases    : Number of bases on each side (" << options.bases_on_each_side << ")\n";
 	std::cerr << "-o | --out      : Output prefix (" << options.out_prefix << ")\n";
 	std::cerr << "-t | --threads  : Number of threads (all threads)\n";
 	std::cerr << "-l | --length   : Maximum read length (" << options.max_read_length << ")\n";
 	std::cerr << "-r | --read     : Number of lines of Fastq file to be read in memory (" << options.fastq_read_lines << ")\n";
-	std::cerr << "-i | --interval : Log output interval (" << options.log_output_interval << ")\n";
+	std::cerr << "-i | --interval : Log output interval in reads (" << options.log_output_interval << ")\n";
+	std::cerr << "-z | --compress : Compression of result files; none, gz or zst (" << options.compress << ")\n";
+	std::cerr << "-B | --binary   : Write result files in the binary columnar format (.gesc)\n";
+	std::cerr << "-c | --cache    : Directory of the count files for count and test (" << options.cache_dir << ");\n";
+	std::cerr << "                  with kmer, the wild type counts are cached there\n";
+	std::cerr << "-I | --incremental : Keep the counts of every Fastq file in the -c directory and read\n";
+	std::cerr << "                  only the files not counted before (kmer)\n";
+	std::cerr << "-p | --checkpoint : Directory of checkpoints of the Fastq scans (saved every -r reads);\n";
+	std::cerr << "                  a run started again resumes from them\n";
+	std::cerr << "-s | --shard    : Count only byte-range shard i of n of each uncompressed Fastq file (i/n)\n";
+	std::cerr << "-F | --fraction : Analyse this fraction of the reads, chosen by the hash of the read name (1)\n";
+	std::cerr << "-e | --early    : Sequential mode (kmer); stop reading the mutant files when a vector has\n";
+	std::cerr << "                  this many positions detected, or when an insert is ruled out (-g)\n";
+	std::cerr << "-g | --genome   : Haploid genome size in bases for the power of -e (none: stop on a detection only)\n";
+	std::cerr << "-C | --copies   : Copies per haploid genome of the insert to be ruled out by -e (" << options.copies << ")\n";
+	std::cerr << "-P | --power    : Power to rule out the insert with -e (" << options.power << ")\n";
+	std::cerr << "-W | --watch    : Seconds between the polls of the watched files (" << options.watch_interval << ");\n";
+	std::cerr << "                  touch out_prefix.stop to end the watch\n";
+	std::cerr << "-A | --auto-tune : Choose the files read at once, the threads per file and -r from a probe\n";
+	std::cerr << "                  of the first reads of each Fastq file (kmer, count)\n";
+	std::cerr << "-M | --max-memory : Memory limit (e.g. 16G); -r and the files read at once are lowered to fit\n";
+	std::cerr << "-T | --trace    : Write a timeline of the phases of each thread to this file (Chrome trace JSON)\n";
+	std::cerr << "-N | --numa     : Bind the threads to the NUMA nodes and copy the k-mer index to each node (make NUMA=1)\n";
 	std::cerr << "-h | --help     : Print this menu\n";
 }
 
+/**
+ * @brief Convert binary columnar files (.gesc) to the text format.
+ *
+ * @param options Execution options.
+ * @param files Binary columnar files
+ * @return Exit code
+ */
+int convert(const Options &options, const std::vector<std::string> &files)
+{
+	const std::string suffix = ".gesc";
+	for (auto itr = files.begin(); itr != files.end(); ++itr)
+	{
+		std::string outfile = *itr;
+		if (outfile.length() > suffix.length() &&
+			outfile.compare(outfile.length() - suffix.length(), suffix.length(), suffix) == 0)
+		{
+			outfile.erase(outfile.length() - suffix.length());
+		}
+		outfile = ResultWriter::file_name(outfile + ".txt", options.compress);
+
+		ColumnarReader reader(*itr);
+		reader.write_text(outfile);
+		std::cout << *itr << " -> " << outfile << std::endl;
+	}
+	return files.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Write the vector index file (<prefix>.gidx) of the vector fasta file.
+ *
+ * @param options Execution options.
+ * @return Exit code
+ */
+int create_index(Options &options)
+{
+	if (VectorIndex::is_index(options.vector_file))
+	{
+		std::cerr << "[Error] The vector file (" << options.vector_file << ") is already an index file." << std::endl;
+		return EXIT_FAILURE;
+	}
+	BitwiseOperation bitwiseOperation(&options);
+	VectorSequence vectorSequence(&options, &bitwiseOperation);
+	std::vector<PositionIds> posIds;
+	std::set<std::string> otherMers;
+	vectorSequence.read_vectorFile(posIds, otherMers);
+
+	const std::string indexFile = options.out_prefix + ".gidx";
+	const std::vector<std::pair<std::string, std::string>> records = vectorSequence.read_sequences();
+	VectorIndex::write(indexFile, records, *bitwiseOperation.get_merIndex(), options.kmer, posIds);
+	std::cout << options.vector_file << " -> " << indexFile << " (" << records.size() << " vectors, "
+			  << bitwiseOperation.get_merIndex()->size() << " " << options.kmer << "-mers)" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Run the match and extension analyses of each k-mer.
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ * @param mutantCounts Counts of the mutant samples (one per k)
+ * @param wildTypeCounts Counts of the wild type samples (one per k)
+ * @param from_counts Analyse the counts (false: read the Fastq files, wild type counts with -c)
+ */
+void analysis(Options &options, BitwiseOperation *bitwiseOperation, std::vector<SampleCount> &mutantCounts,
+			  std::vector<SampleCount> &wildTypeCounts, const bool from_counts)
+{
+	const bool multi_kmer = options.kmers.size() > 1;
+	const std::string out_prefix = options.out_prefix;
+	for (size_t n = 0; n < options.kmers.size(); n++)
+	{
+		options.kmer = options.kmers[n];
+		if (multi_kmer)
+		{
+			options.out_prefix = out_prefix + ".k" + std::to_string(options.kmer);
+			std::cout << "\n========== K-mer = " << options.kmer << " -> " << options.out_prefix
+					  << " ==========" << std::endl;
+		}
+
+		/**
+		 * Create statistics files (one per vector of the vector file).
+		 */
+		std::vector<StatisticsFile *> statisticsFiles;
+		VectorSequence vectorSequence(&options, bitwiseOperation);
+		const std::vector<std::pair<std::string, std::string>> vectors = vectorSequence.read_sequences();
+		for (auto itr = vectors.begin(); itr != vectors.end(); ++itr)
+		{
+			if (itr->second.length() < options.kmer)
+			{
+				// Skipped by the k-mer match analysis
+				continue;
+			}
+			std::string vector_prefix = options.out_prefix;
+			if (vectors.size() > 1)
+			{
+				std::string name = itr->first;
+				std::replace(name.begin(), name.end(), '/', '_');
+				vector_prefix += "." + name;
+				std::cout << "Vector " << itr->first << " -> " << vector_prefix << std::endl;
+			}
+			statisticsFiles.push_back(new StatisticsFile(&options, itr->first, vector_prefix));
+		}
+
+		/**
+		 * K-mer match analysis
+		 */
+		KmerMatch *kmerMatch = new KmerMatch(&options, bitwiseOperation, statisticsFiles);
+		if (from_counts)
+		{
+			kmerMatch->execution(mutantCounts[n], wildTypeCounts[n]);
+		}
+		else
+		{
+			kmerMatch->execution(options.cache_wildType ? &wildTypeCounts[n] : nullptr);
+		}
+		delete kmerMatch;
+
+		/**
+		 * K-mer extension analysis
+		 */
+		KmerExtension *kmerExtension = new KmerExtension(&options, bitwiseOperation,
+														 statisticsFiles);
+		if (from_counts)
+		{
+			kmerExtension->execution(mutantCounts[n], wildTypeCounts[n]);
+		}
+		else
+		{
+			kmerExtension->execution(options.cache_wildType ? &wildTypeCounts[n] : nullptr);
+		}
+		delete kmerExtension;
+
+		for (auto itr = statisticsFiles.begin(); itr != statisticsFiles.end(); ++itr)
+		{
+			delete *itr;
+		}
+	}
+	options.out_prefix = out_prefix;
+}
+
+/**
+ * @brief Follow the mutant Fastq files while they are written (watch mode).
+ *
+ * Every watch interval the records written since the last poll are counted;
+ * if there are new ones, the analyses are run on the running counts and the
+ * result files are rewritten (a snapshot), then <prefix>.snapshot tells the
+ * snapshot number, time and reads. The run ends after the poll following the
+ * creation of <prefix>.stop.
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ * @return Exit code
+ */
+int watch(Options &options, BitwiseOperation *bitwiseOperation)
+{
+	// Wild type counts (cached with -c) and the k-mer indexes
+	std::vector<SampleCount> wildTypeCounts;
+	KmerCount *kmerCount = new KmerCount(&options, bitwiseOperation);
+	kmerCount->sample_counts(wildTypeCounts);
+	delete kmerCount;
+
+	// The watched files are read one after another with all threads.
+	options.inner_parallel = options.outer_parallel * options.inner_parallel;
+	options.outer_parallel = 1;
+
+	std::vector<SampleCount> mutantCounts(options.kmers.size());
+	for (size_t n = 0; n < options.kmers.size(); n++)
+	{
+		mutantCounts[n].kmer = options.kmers[n];
+	}
+
+	const std::string stopFile = options.out_prefix + ".stop";
+	const std::string snapshotFile = options.out_prefix + ".snapshot";
+	std::filesystem::remove(stopFile);
+	std::cout << "\n---------- Watch the mutant files (stop: touch " << stopFile << ") ----------" << std::endl;
+
+	FastqWatch fastqWatch(&options, bitwiseOperation, options.mutant_files);
+	unsigned int snapshot = 0;
+	for (;;)
+	{
+		const bool stop = std::filesystem::exists(stopFile);
+		if (fastqWatch.poll(mutantCounts) > 0)
+		{
+			snapshot++;
+			const std::string now = options.get_now();
+			std::cout << "\n========== Snapshot " << snapshot << " (" << now << "): "
+					  << mutantCounts.front().reads() << " mutant reads in " << fastqWatch.get_files()
+					  << " files ==========" << std::endl;
+			analysis(options, bitwiseOperation, mutantCounts, wildTypeCounts, true);
+
+			// Written after the result files, so that a complete snapshot can be picked up.
+			std::ofstream ofs(snapshotFile + ".tmp");
+			ofs << "snapshot\t" << snapshot << "\ntime\t" << now << "\nmutant_reads\t"
+				<< mutantCounts.front().reads() << "\nfiles\t" << fastqWatch.get_files() << std::endl;
+			ofs.close();
+			std::filesystem::rename(snapshotFile + ".tmp", snapshotFile);
+		}
+		if (stop)
+		{
+			break;
+		}
+		for (unsigned int i = 0; i < options.watch_interval && !std::filesystem::exists(stopFile); i++)
+		{
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+	}
+	std::filesystem::remove(stopFile);
+
+	if (snapshot == 0)
+	{
+		std::cerr << "[Error] No mutant reads were found in the watched files." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Snapshots: " << snapshot << std::endl;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Write the metrics and the trace of the run, then print the end and elapsed time.
+ *
+ * @param options Execution options.
+ * @param version Program version
+ * @param status Exit code of the run
+ * @return Exit code
+ */
+int finish(Options &options, const std::string &version, const int status)
+{
+	options.metrics.write(options.out_prefix + ".metrics.json", version, options.calc_mode,
+						  options.outer_parallel * options.inner_parallel);
+	if (!options.trace_file.empty())
+	{
+		options.trace.write(options.trace_file);
+	}
+	std::cout << "\nEnd time    : " << options.get_now() << std::endl;
+	std::cout << "Elapsed time: " << options.get_elapsed() << std::endl;
+	return status;
+}
+
 /**
  * @brief Main function.
  *
@@ -91,6 +366,22 @@ int main(int argc, char *argv[])
 		{"read", required_argument, NULL, 'r'},
 		{"length", required_argument, NULL, 'l'},
 		{"interval", required_argument, NULL, 'i'},
+		{"compress", required_argument, NULL, 'z'},
+		{"binary", no_argument, NULL, 'B'},
+		{"cache", required_argument, NULL, 'c'},
+		{"incremental", no_argument, NULL, 'I'},
+		{"checkpoint", required_argument, NULL, 'p'},
+		{"shard", required_argument, NULL, 's'},
+		{"watch", required_argument, NULL, 'W'},
+		{"fraction", required_argument, NULL, 'F'},
+		{"early", required_argument, NULL, 'e'},
+		{"genome", required_argument, NULL, 'g'},
+		{"copies", required_argument, NULL, 'C'},
+		{"power", required_argument, NULL, 'P'},
+		{"auto-tune", no_argument, NULL, 'A'},
+		{"max-memory", required_argument, NULL, 'M'},
+		{"trace", required_argument, NULL, 'T'},
+		{"numa", no_argument, NULL, 'N'},
 		{"help", required_argument, NULL, 'h'},
 		{0, 0, 0, 0}};
 
@@ -99,7 +390,7 @@ int main(int argc, char *argv[])
 		int c;
 		int long_index;
 		unsigned int kmer;
-		while ((c = getopt_long(argc, argv, "v:m:w:k:f:b:o:t:r:l:i:h::", long_options, &long_index)) != -1)
+		while ((c = getopt_long(argc, argv, "v:m:w:k:f:b:o:t:r:l:i:z:Bc:Ip:s:W:F:e:g:C:P:AM:T:Nh::", long_options, &long_index)) != -1)
 		{
 			switch (c)
 			{
@@ -113,16 +404,22 @@ int main(int argc, char *argv[])
 				options.wildType_files = split(optarg, DELIMITER);
 				break;
 			case 'k':
-				kmer = std::stoi(optarg);
-				if (kmer >= options.MIN_CHUNKLENGTH)
+				options.kmers.clear();
+				for (const std::string &str : split(optarg, DELIMITER))
 				{
-					options.kmer = kmer;
-				}
-				else
-				{
-					std::cerr << "[Error] K-mer (" << kmer << ") must be >= " << options.MIN_CHUNKLENGTH << "." << std::endl;
-					return EXIT_FAILURE;
+					kmer = std::stoi(str);
+					if (kmer < options.MIN_KMER || kmer > options.MAX_KMER)
+					{
+						std::cerr << "[Error] K-mer (" << kmer << ") must be >= " << options.MIN_KMER
+								  << " and <= " << options.MAX_KMER << "." << std::endl;
+						return EXIT_FAILURE;
+					}
+					if (std::find(options.kmers.begin(), options.kmers.end(), kmer) == options.kmers.end())
+					{
+						options.kmers.push_back(kmer);
+					}
 				}
+				options.kmer = options.kmers.front();
 				break;
 			case 'f':
 				options.threshold_fdr = std::stod(optarg);
@@ -144,7 +441,99 @@ int main(int argc, char *argv[])
 				break;
 			case 'i':
 				options.log_output_interval = std::stoi(optarg);
+				options.progress.set_interval(options.log_output_interval);
+				break;
+			case 'z':
+				options.compress = optarg;
+				if (options.compress != "none" && options.compress != "gz" && options.compress != "zst")
+				{
+					std::cerr << "[Error] Compression (" << options.compress << ") must be none, gz or zst." << std::endl;
+					return EXIT_FAILURE;
+				}
+#ifndef HAVE_ZSTD
+				if (options.compress == "zst")
+				{
+					std::cerr << "[Error] zstd output is not supported in this build (make ZSTD=1)." << std::endl;
+					return EXIT_FAILURE;
+				}
+#endif
+				break;
+			case 'B':
+				options.binary = true;
+				break;
+			case 'c':
+				options.cache_dir = optarg;
+				options.cache_wildType = true;
+				break;
+			case 'I':
+				options.incremental = true;
+				break;
+			case 'p':
+				options.checkpoint_dir = optarg;
+				break;
+			case 's':
+				if (sscanf(optarg, "%u/%u", &options.shard, &options.shards) != 2 ||
+					options.shard < 1 || options.shard > options.shards)
+				{
+					std::cerr << "[Error] Shard (" << optarg << ") must be i/n with 1 <= i <= n." << std::endl;
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'W':
+				options.watch_interval = std::stoi(optarg);
 				break;
+			case 'F':
+				options.fraction = std::stod(optarg);
+				if (options.fraction <= 0.0 || options.fraction > 1.0)
+				{
+					std::cerr << "[Error] Fraction (" << optarg << ") must be > 0 and <= 1." << std::endl;
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'e':
+				options.early_positions = std::stoi(optarg);
+				break;
+			case 'g':
+				options.genome_size = std::stod(optarg);
+				break;
+			case 'C':
+				options.copies = std::stod(optarg);
+				break;
+			case 'P':
+				options.power = std::stod(optarg);
+				if (options.power <= 0.0 || options.power >= 1.0)
+				{
+					std::cerr << "[Error] Power (" << optarg << ") must be > 0 and < 1." << std::endl;
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'A':
+				options.auto_tune = true;
+				break;
+			case 'M':
+				options.max_memory = MemoryPlanner::parse_size(optarg);
+				if (options.max_memory == 0)
+				{
+					std::cerr << "[Error] Memory limit (" << optarg << ") must be a size such as 512M or 16G." << std::endl;
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'T':
+				options.trace_file = optarg;
+				options.trace.enable();
+				break;
+			case 'N':
+#ifndef HAVE_NUMA
+				std::cerr << "[Error] NUMA placement is not supported in this build (make NUMA=1)." << std::endl;
+				return EXIT_FAILURE;
+#else
+				if (!options.numa.enable())
+				{
+					std::cerr << "[Error] NUMA is not available on this system." << std::endl;
+					return EXIT_FAILURE;
+				}
+				break;
+#endif
 			case 'h':
 				help(options, version, argv[0]);
 				return EXIT_FAILURE;
@@ -154,16 +543,58 @@ int main(int argc, char *argv[])
 			}
 		}
 
-		if (optind == argc || strcmp(argv[optind], "kmer") != 0 || options.vector_file.length() == 0
-		 || options.mutant_files.size() == 0 || options.wildType_files.size() == 0)
+		if (optind < argc && strcmp(argv[optind], "convert") == 0)
+		{
+			return convert(options, std::vector<std::string>(argv + optind + 1, argv + argc));
+		}
+
+		if (optind < argc && strcmp(argv[optind], "merge") == 0 && optind + 1 < argc)
+		{
+			BitwiseOperation bitwiseOperation(&options);
+			KmerCount kmerCount(&options, &bitwiseOperation);
+			kmerCount.merge(std::vector<std::string>(argv + optind + 1, argv + argc));
+			return EXIT_SUCCESS;
+		}
+
+		if (optind < argc && strcmp(argv[optind], "index") == 0 && options.vector_file.length() > 0)
+		{
+			if (options.kmers.size() > 1)
+			{
+				std::cerr << "[Error] An index file is made for one k-mer." << std::endl;
+				return EXIT_FAILURE;
+			}
+			return create_index(options);
+		}
+
+		const std::string calc_mode = optind < argc ? argv[optind] : "";
+		const bool count_mode = calc_mode == "count";
+		if ((calc_mode != "kmer" && calc_mode != "count" && calc_mode != "test" && calc_mode != "watch") || options.vector_file.length() == 0
+		 || (count_mode && options.number_of_samples() == 0)
+		 || (!count_mode && (options.mutant_files.size() == 0 || options.wildType_files.size() == 0)))
 		{
 			help(options, version, argv[0]);
 			return EXIT_FAILURE;
 		}
 
-		options.calc_mode = argv[optind];
-		options.chunk_length = std::min(options.kmer, options.MAX_CHUNKLENGTH);
-		options.max_chunk_array = (unsigned int)(pow(2.0, 2.0 * options.chunk_length) - 1.0);
+		if (options.shards > 0 && !count_mode)
+		{
+			std::cerr << "[Error] A shard (-s) is counted with the count command." << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		if (options.early_positions > 0 && (calc_mode != "kmer" || options.incremental || !options.checkpoint_dir.empty()))
+		{
+			std::cerr << "[Error] The sequential mode (-e) is used with kmer, without -I or -p." << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		if (calc_mode == "watch" && (options.incremental || !options.checkpoint_dir.empty()))
+		{
+			std::cerr << "[Error] The watch command keeps its counts in memory (no -I or -p)." << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		options.calc_mode = calc_mode;
 		options.output(version);
 	}
 	catch (const std::exception &e)
@@ -183,31 +614,87 @@ int main(int argc, char *argv[])
 		BitwiseOperation *bitwiseOperation = new BitwiseOperation(&options);
 
 		/**
-		 * Create statistics files.
+		 * Threads and blocks from a probe of the FASTQ files (-A), then the
+		 * memory estimate of the FASTQ scans, fitted to the limit (-M).
+		 */
+		if (options.auto_tune && (options.calc_mode == "kmer" || options.calc_mode == "count"))
+		{
+			AutoTuner autoTuner(&options, bitwiseOperation);
+			autoTuner.tune();
+		}
+		if (options.calc_mode != "test")
+		{
+			MemoryPlanner memoryPlanner(&options, bitwiseOperation);
+			memoryPlanner.plan();
+		}
+
+		/**
+		 * Count stage: count files only.
 		 */
-		StatisticsFile *statisticsFile = new StatisticsFile(&options);
+		if (options.calc_mode == "count")
+		{
+			KmerCount *kmerCount = new KmerCount(&options, bitwiseOperation);
+			kmerCount->execution();
+			delete kmerCount;
+			delete bitwiseOperation;
+
+			return finish(options, version, EXIT_SUCCESS);
+		}
 
 		/**
-		 * K-mer match analysis
+		 * Watch: analyses of the running counts of growing files.
 		 */
-		KmerMatch *kmerMatch = new KmerMatch(&options, bitwiseOperation, statisticsFile);
-		kmerMatch->execution();
-		delete kmerMatch;
+		if (options.calc_mode == "watch")
+		{
+			const int status = watch(options, bitwiseOperation);
+			delete bitwiseOperation;
+
+			return finish(options, version, status);
+		}
 
 		/**
-		 * K-mer extension analysis
+		 * Counts of the samples: wild type from the cache (-c), or all samples
+		 * for several k (one pass over the FASTQ files for all k) or with
+		 * checkpoints (-p).
 		 */
-		KmerExtension *kmerExtension = new KmerExtension(&options, bitwiseOperation,
-														 statisticsFile);
-		kmerExtension->execution();
-		delete kmerExtension;
+		const bool multi_kmer = options.kmers.size() > 1;
+		const bool all_counts = multi_kmer || options.incremental || !options.checkpoint_dir.empty() ||
+								options.early_positions > 0;
+		std::vector<SampleCount> mutantCounts(options.kmers.size());
+		std::vector<SampleCount> wildTypeCounts(options.kmers.size());
+		if (options.calc_mode == "kmer" && (all_counts || options.cache_wildType))
+		{
+			KmerCount *kmerCount = new KmerCount(&options, bitwiseOperation);
+			kmerCount->sample_counts(wildTypeCounts, all_counts ? &mutantCounts : nullptr);
+			delete kmerCount;
+		}
+
+		/**
+		 * Test stage: counts of the samples from the count files.
+		 */
+		if (options.calc_mode == "test")
+		{
+			KmerCount *kmerCount = new KmerCount(&options, bitwiseOperation);
+			for (size_t n = 0; n < options.kmers.size(); n++)
+			{
+				options.kmer = options.kmers[n];
+				kmerCount->load_counts(mutantCounts[n], wildTypeCounts[n]);
+			}
+			delete kmerCount;
+		}
+		analysis(options, bitwiseOperation, mutantCounts, wildTypeCounts,
+				 options.calc_mode == "test" || all_counts);
 
-		delete statisticsFile;
+		// The counts kept for a restart are no longer needed.
+		if (options.calc_mode == "kmer" && !options.checkpoint_dir.empty())
+		{
+			KmerCount *kmerCount = new KmerCount(&options, bitwiseOperation);
+			kmerCount->clear_checkpoints();
+			delete kmerCount;
+		}
 		delete bitwiseOperation;
 
-		std::cout << "\nEnd time    : " << options.get_now() << std::endl;
-		std::cout << "Elapsed time: " << options.get_elapsed() << std::endl;
-		return EXIT_SUCCESS;
+		return finish(options, version, EXIT_SUCCESS);
 	}
 	catch (const std::bad_alloc &e)
 	{
@@ -0,0 +1,385 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <zlib.h>
+#include "complementary.h"
+#include "memory_planner.h"
+#include "mer_code.h"
+#include "sample_count.h"
+#include "vector_sequence.h"
+
+namespace
+{
+	// Bytes of the program itself (code, libraries, zlib buffers and thread stacks in use)
+	const u_int64_t PROGRAM_BYTES = (u_int64_t)24 << 20;
+
+	// Records read from the start of each FASTQ file
+	const unsigned int SAMPLE_RECORDS = 10000;
+
+	// Bytes of a counter of a vector k-mer (arrays indexed by the k-mer id)
+	const u_int64_t COUNTER_BYTES = sizeof(unsigned int);
+
+	// Bytes of a vector position of the match analysis held from the start: the ids of its
+	// k-mer pair and its base
+	const u_int64_t POSITION_BYTES = 2 * sizeof(u_int32_t) + 1;
+
+	// Bytes of a vector position in the G-test: the counts of both groups and the G-value,
+	// P-value, FDR and Bonferroni
+	const u_int64_t GTEST_BYTES = 2 * sizeof(unsigned int) + 4 * sizeof(double);
+
+	// Bytes of a vector k-mer sorted for the merFreq files (code and id, and the buffer of the radix sort)
+	const u_int64_t SORT_BYTES = 2 * sizeof(std::pair<u_int64_t, unsigned int>);
+
+	// Bytes of a k-mer of the counts of a sample (array sorted by the k-mer id, and the copy of a merge)
+	const u_int64_t COUNT_BYTES = 2 * sizeof(SampleCount::MerCount);
+
+	// Smallest -r chosen to fit the limit before fewer files are read at once
+	const u_int64_t MIN_READ_LINES = 100000;
+
+	/**
+	 * @brief Bytes of a std::string of a length (object and heap block).
+	 *
+	 * @param length Length
+	 * @return Bytes
+	 */
+	u_int64_t string_bytes(const u_int64_t length)
+	{
+		return sizeof(std::string) + (length < 16 ? 0 : (length + 24) / 16 * 16);
+	}
+}
+
+/**
+ * @brief Construct a new Memory Planner:: Memory Planner object
+ *
+ * @param options Execution options.
+ * @param bitwiseOperation Bitwise operation.
+ */
+MemoryPlanner::MemoryPlanner(Options *options, BitwiseOperation *bitwiseOperation)
+{
+	this->options = options;
+	this->bitwiseOperation = bitwiseOperation;
+}
+
+/**
+ * @brief Destroy the Memory Planner:: Memory Planner object
+ *
+ */
+MemoryPlanner::~MemoryPlanner()
+{
+}
+
+/**
+ * @brief Print the estimate and fit -r and the OpenMP outer/inner parallel to the limit.
+ *
+ * -r is lowered first, down to 100000 reads; then the files are read one
+ * fewer at a time, with their threads given to the inner parallel, and -r
+ * is fitted again. The run stops if the estimate exceeds the limit even
+ * with one file at a time.
+ */
+void MemoryPlanner::plan()
+{
+	this->sample();
+
+	const unsigned int threads = this->options->outer_parallel * this->options->inner_parallel;
+	const Estimate current = this->estimate(this->options->fastq_read_lines,
+											this->options->outer_parallel, this->options->inner_parallel);
+	std::cout << "Memory estimate               = " << format_size(current.total())
+			  << " (program " << format_size(current.program)
+			  << ", vector index " << format_size(current.index)
+			  << ", read blocks " << format_size(current.blocks)
+			  << ", counters " << format_size(current.counters)
+			  << ", sample counts " << format_size(current.samples)
+			  << ", bases on each side " << format_size(current.outside)
+			  << ", analysis " << format_size(current.analysis) << ")" << std::endl;
+	if (this->options->max_memory == 0 || current.total() <= this->options->max_memory)
+	{
+		std::cout << std::flush;
+		return;
+	}
+
+	const u_int64_t limit = this->options->max_memory;
+	for (unsigned int outer = this->options->outer_parallel; outer > 0; outer--)
+	{
+		// Largest -r that fits (the estimate grows with -r)
+		const unsigned int inner = std::max(threads / outer, 1u);
+		u_int64_t readLines = 0;
+		u_int64_t high = this->options->fastq_read_lines;
+		while (readLines < high)
+		{
+			const u_int64_t middle = readLines + (high - readLines + 1) / 2;
+			if (this->estimate(middle, outer, inner).total() <= limit)
+			{
+				readLines = middle;
+			}
+			else
+			{
+				high = middle - 1;
+			}
+		}
+		if (readLines == 0 || (readLines < std::min(MIN_READ_LINES, (u_int64_t)this->options->fastq_read_lines) && outer > 1))
+		{
+			continue;
+		}
+		this->options->fastq_read_lines = readLines;
+		this->options->outer_parallel = outer;
+		this->options->inner_parallel = inner;
+		std::cout << "Memory limit                  = " << format_size(limit) << std::endl;
+		std::cout << "  Reads in memory (-r)        = " << this->options->fastq_read_lines << std::endl;
+		std::cout << "  OpenMP outer parallel       = " << this->options->outer_parallel << std::endl;
+		std::cout << "  OpenMP inner parallel       = " << this->options->inner_parallel << std::endl;
+		std::cout << "  Memory estimate             = "
+				  << format_size(this->estimate(readLines, outer, inner).total()) << std::endl;
+		std::cout << std::flush;
+		return;
+	}
+
+	std::cerr << "[Error] The memory estimate (" << format_size(this->estimate(1, 1, threads).total())
+			  << " with one file at a time) exceeds the memory limit (" << format_size(limit) << ")." << std::endl;
+	std::exit(1);
+}
+
+/**
+ * @brief Parse a memory size (bytes, or with the suffix K, M, G or T; powers of 1024).
+ *
+ * @param size Memory size
+ * @return Bytes (0 if the size is not valid)
+ */
+u_int64_t MemoryPlanner::parse_size(const std::string &size)
+{
+	size_t end = 0;
+	double value;
+	try
+	{
+		value = std::stod(size, &end);
+	}
+	catch (const std::exception &)
+	{
+		return 0;
+	}
+	std::string suffix = size.substr(end);
+	if (!suffix.empty() && (suffix.back() == 'B' || suffix.back() == 'b'))
+	{
+		suffix.pop_back();
+	}
+	const std::string units = "KMGT";
+	u_int64_t unit = 1;
+	if (!suffix.empty())
+	{
+		const size_t i = units.find(std::toupper(suffix[0]));
+		if (suffix.length() > 2 || i == std::string::npos || (suffix.length() == 2 && suffix[1] != 'i'))
+		{
+			return 0;
+		}
+		unit = (u_int64_t)1 << (10 * (i + 1));
+	}
+	return value > 0.0 ? (u_int64_t)(value * unit) : 0;
+}
+
+/**
+ * @brief Format a memory size.
+ *
+ * @param bytes Bytes
+ * @return Size in B, KiB, MiB or GiB
+ */
+std::string MemoryPlanner::format_size(const u_int64_t bytes)
+{
+	static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+	double value = bytes;
+	unsigned int i = 0;
+	while (value >= 1024.0 && i < 3)
+	{
+		value /= 1024.0;
+		i++;
+	}
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(i == 0 ? 0 : 1) << value << " " << units[i];
+	return oss.str();
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Sample the vector and the first reads of each FASTQ file.
+ *
+ * The vector k-mers are counted in an index of the first k. The reads of a
+ * file are estimated from the compressed bytes of the first records, and
+ * the k-mers found per read from their vector k-mers; files
+ * that do not exist yet (watch) are left out.
+ */
+void MemoryPlanner::sample()
+{
+	const unsigned int kmer = this->options->kmer;
+	const unsigned int nbase = this->options->bases_on_each_side;
+
+	// Vector k-mers of the first k (both strands, circular), indexed as in the run
+	// (or mapped from the vector index file)
+	VectorSequence vectorSequence(this->options, this->bitwiseOperation);
+	const VectorIndex *vectorIndex = this->bitwiseOperation->get_vectorIndex();
+	Complementary complementary;
+	MerIndex merIndex(kmer);
+	if (vectorIndex)
+	{
+		vectorIndex->attach(merIndex);
+	}
+	u_int64_t bases = 0;
+	for (const auto &record : vectorSequence.read_sequences())
+	{
+		std::string sequence = record.second;
+		bases += sequence.length();
+		if (vectorIndex)
+		{
+			continue;
+		}
+		sequence += sequence.substr(0, std::min((size_t)kmer - 1, sequence.length()));
+		transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
+		for (size_t i = 0; i + kmer <= sequence.length(); i++)
+		{
+			const std::string mer = sequence.substr(i, kmer);
+			merIndex.add(mer);
+			merIndex.add(complementary.mer(mer));
+		}
+	}
+	this->vectorBases = bases;
+	this->vectorMers = merIndex.size();
+
+	// Longest mean read length and the k-mers found in all files
+	std::vector<std::string> fastqFiles = this->options->mutant_files;
+	fastqFiles.insert(fastqFiles.end(), this->options->wildType_files.begin(), this->options->wildType_files.end());
+	const unsigned int max_buff = this->options->max_read_length + 2;
+	char buff[max_buff];
+	double meanLength = 0.0;
+	double hits = 0.0;
+	for (const std::string &fastqFile : fastqFiles)
+	{
+		const gzFile file = gzopen(fastqFile.c_str(), "rb");
+		if (!file)
+		{
+			continue;
+		}
+		u_int64_t records = 0, length = 0, found = 0;
+		unsigned int nLine = 0;
+		while (records < SAMPLE_RECORDS && gzgets(file, buff, max_buff) != Z_NULL)
+		{
+			if (++nLine == 2)
+			{
+				std::string read(buff);
+				if (!read.empty() && read.back() == '\n')
+				{
+					read.pop_back();
+				}
+				length += read.length();
+				for (size_t j = 0; j + kmer <= read.length(); j++)
+				{
+					u_int64_t code;
+					if (MerCode::encode(read.substr(j, kmer), code) && merIndex.find(code) != MerIndex::NOT_FOUND)
+					{
+						found++;
+					}
+				}
+			}
+			if (nLine == 4)
+			{
+				nLine = 0;
+				records++;
+			}
+		}
+		const bool complete = gzgets(file, buff, max_buff) == Z_NULL;
+		const u_int64_t offset = gzoffset(file);
+		gzclose(file);
+		if (records == 0)
+		{
+			continue;
+		}
+
+		// Reads of the whole file (or of its shard), of the --fraction kept
+		double reads = complete ? records : (double)records * Metrics::file_size(fastqFile) / std::max(offset, (u_int64_t)1);
+		reads *= this->options->fraction / std::max(this->options->shards, 1u);
+		meanLength = std::max(meanLength, (double)length / records);
+		this->fileReads = std::max(this->fileReads, (u_int64_t)reads + 1);
+		this->fileHits = std::max(this->fileHits, (u_int64_t)(reads * found / records));
+		hits += reads * found / records;
+	}
+	this->readBytes = string_bytes(meanLength > 0.0 ? (u_int64_t)meanLength : this->options->max_read_length);
+	if (this->fileReads == 0)
+	{
+		this->fileReads = this->options->fastq_read_lines + 1;
+	}
+	this->outsideBytes = hits * this->options->kmers.size() * 2 * string_bytes(nbase);
+	this->hits = (u_int64_t)hits;
+}
+
+/**
+ * @brief Estimate the components for -r and the OpenMP outer/inner parallel.
+ *
+ * The components follow the structures of the run, with the vector
+ * k-mers of the first k for each k.
+ * The FASTQ files of the match analysis of one k are counted in arrays
+ * indexed by the k-mer id (one per file read at once and one per thread);
+ * the counts of the samples (count files, -c, several k, -e, watch) are
+ * made by each thread for all k and keep only the k-mers found. The
+ * G-test and the merFreq files of one k follow the scans.
+ *
+ * @param readLines Reads of a block
+ * @param outer Files read at once
+ * @param inner Threads of a file
+ * @return Estimate
+ */
+MemoryPlanner::Estimate MemoryPlanner::estimate(const u_int64_t readLines, const unsigned int outer,
+												const unsigned int inner) const
+{
+	const Options *options = this->options;
+	const u_int64_t nKmer = options->kmers.size();
+	const unsigned int kmer = *std::max_element(options->kmers.begin(), options->kmers.end());
+	const u_int64_t mers = this->vectorMers;
+
+	// Modes of main: counts of the samples, and the match analysis from the FASTQ files
+	const bool all_counts = nKmer > 1 || options->incremental || !options->checkpoint_dir.empty() ||
+							options->early_positions > 0;
+	const bool sample_counts = options->calc_mode != "kmer" || all_counts || options->cache_wildType;
+	const bool match_scan = options->calc_mode == "kmer" && !all_counts;
+	const bool analysis = options->calc_mode != "count";
+
+	Estimate estimate;
+	estimate.program = PROGRAM_BYTES;
+	estimate.index = nKmer * MerIndex::bytes(mers) * (options->numa.is_enabled() ? 1 + options->numa.size() : 1);
+	estimate.blocks = outer * std::min(readLines + 1, this->fileReads) * this->readBytes;
+	if (sample_counts)
+	{
+		// Counts of the threads of a file and of the block, then of the file
+		estimate.counters = outer * nKmer * ((inner + 1) * mers * COUNTER_BYTES +
+											 std::min(mers, this->fileHits) * COUNT_BYTES);
+	}
+	if (match_scan)
+	{
+		estimate.counters = std::max(estimate.counters, outer * (inner + 1) * mers * COUNTER_BYTES);
+	}
+	if (analysis)
+	{
+		// Counters of both groups and the positions, held from the start of the match analysis
+		estimate.counters += 2 * mers * COUNTER_BYTES + this->vectorBases * POSITION_BYTES;
+		estimate.analysis = 2 * mers * COUNTER_BYTES + this->vectorBases * (POSITION_BYTES + GTEST_BYTES) +
+							mers * SORT_BYTES;
+		if (options->binary)
+		{
+			// Columns of both merFreq files
+			estimate.analysis += 2 * mers * (string_bytes(kmer) + sizeof(u_int32_t));
+		}
+	}
+	if (options->calc_mode != "count" && (all_counts || options->calc_mode == "watch"))
+	{
+		estimate.samples = 2 * nKmer * std::min(mers, this->hits) * COUNT_BYTES;
+	}
+	else if (options->calc_mode == "kmer" && options->cache_wildType)
+	{
+		estimate.samples = nKmer * std::min(mers, this->hits) * COUNT_BYTES;
+	}
+	estimate.outside = this->outsideBytes;
+	return estimate;
+}
@@ -0,0 +1,131 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef MEMORY_PLANNER_H_
+#define MEMORY_PLANNER_H_
+
+#include <string>
+#include <sys/types.h>
+#include "bitwise_operation.h"
+
+/**
+ * @brief Estimate of the memory of a run and its fit to --max-memory.
+ *
+ * The components are estimated from the options, the vector and the first
+ * reads of each FASTQ file: the program itself, the k-mer index, the blocks of reads held by
+ * the files read at once (-r), the counters of the files and threads, the
+ * counts of the samples, the bases on each side of the k-mers found and
+ * the analysis after the scans. With a limit, -r and then the number of
+ * files read at once are lowered until the estimate fits.
+ */
+class MemoryPlanner
+{
+public:
+	/**
+	 * @brief Construct a new Memory Planner object
+	 *
+	 * @param options Execution options.
+	 * @param bitwiseOperation Bitwise operation.
+	 */
+	MemoryPlanner(Options *options, BitwiseOperation *bitwiseOperation);
+
+	/**
+	 * @brief Destroy the Memory Planner object
+	 *
+	 */
+	virtual ~MemoryPlanner();
+
+	/**
+	 * @brief Print the estimate and fit -r and the OpenMP outer/inner parallel to the limit.
+	 *
+	 */
+	void plan();
+
+	/**
+	 * @brief Parse a memory size (bytes, or with the suffix K, M, G or T; powers of 1024).
+	 *
+	 * @param size Memory size
+	 * @return Bytes (0 if the size is not valid)
+	 */
+	static u_int64_t parse_size(const std::string &size);
+
+	/**
+	 * @brief Format a memory size.
+	 *
+	 * @param bytes Bytes
+	 * @return Size in B, KiB, MiB or GiB
+	 */
+	static std::string format_size(const u_int64_t bytes);
+
+private:
+	/**
+	 * @brief Estimate of the components (bytes)
+	 *
+	 */
+	struct Estimate
+	{
+		u_int64_t program = 0;
+		u_int64_t index = 0;
+		u_int64_t blocks = 0;
+		u_int64_t counters = 0;
+		u_int64_t samples = 0;
+		u_int64_t outside = 0;
+		u_int64_t analysis = 0;
+
+		// The memory freed by the scans is not always given back before the analysis, so all are added.
+		u_int64_t total() const
+		{
+			return this->program + this->index + this->blocks + this->counters + this->samples +
+				   this->outside + this->analysis;
+		}
+	};
+
+	/**
+	 * @brief Execution options.
+	 *
+	 */
+	Options *options;
+
+	/**
+	 * @brief Bitwise operation.
+	 *
+	 */
+	BitwiseOperation *bitwiseOperation;
+
+	// Bases of the vector (positions of each k)
+	u_int64_t vectorBases = 0;
+
+	// Vector k-mers of the first k (both strands)
+	u_int64_t vectorMers = 0;
+
+	// Bytes of a read held in a block
+	u_int64_t readBytes = 0;
+
+	// Reads of the largest file (a block holds no more)
+	u_int64_t fileReads = 0;
+
+	// K-mers found in the largest file and in all files
+	u_int64_t fileHits = 0;
+	u_int64_t hits = 0;
+
+	// Bytes of the bases on each side of the k-mers found in all files
+	u_int64_t outsideBytes = 0;
+
+	/**
+	 * @brief Sample the vector and the first reads of each FASTQ file.
+	 *
+	 */
+	void sample();
+
+	/**
+	 * @brief Estimate the components for -r and the OpenMP outer/inner parallel.
+	 *
+	 * @param readLines Reads of a block
+	 * @param outer Files read at once
+	 * @param inner Threads of a file
+	 * @return Estimate
+	 */
+	Estimate estimate(const u_int64_t readLines, const unsigned int outer, const unsigned int inner) const;
+};
+#endif /* MEMORY_PLANNER_H_ */
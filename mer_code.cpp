@@ -0,0 +1,91 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include "mer_code.h"
+
+/**
+ * @brief Encode a k-mer.
+ *
+ * @param mer K-mer sequence
+ * @param code Code of the k-mer
+ * @return false if the k-mer is too long or has a base other than ACGT
+ */
+bool MerCode::encode(const std::string &mer, u_int64_t &code)
+{
+	if (mer.length() > MAX_KMER)
+	{
+		return false;
+	}
+	code = 0;
+	for (size_t i = 0; i < mer.length(); i++)
+	{
+		switch (mer[i])
+		{
+		case 'A':
+			code = code << 2;
+			break;
+		case 'C':
+			code = (code << 2) | 1;
+			break;
+		case 'G':
+			code = (code << 2) | 2;
+			break;
+		case 'T':
+			code = (code << 2) | 3;
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Decode a k-mer.
+ *
+ * @param code Code of the k-mer
+ * @param kmer K-mer
+ * @param mer K-mer sequence (kmer bytes)
+ */
+void MerCode::decode(u_int64_t code, const unsigned int kmer, char *mer)
+{
+	static const char bases[4] = {'A', 'C', 'G', 'T'};
+	for (unsigned int i = kmer; i > 0; i--)
+	{
+		mer[i - 1] = bases[code & 3];
+		code >>= 2;
+	}
+}
+
+/**
+ * @brief Sort k-mer codes and counts by the code (LSD radix sort).
+ *
+ * @param merCodes K-mer codes and counts
+ * @param kmer K-mer
+ */
+void MerCode::radix_sort(std::vector<std::pair<u_int64_t, unsigned int>> &merCodes,
+						 const unsigned int kmer)
+{
+	const unsigned int passes = (2 * kmer + 7) / 8;
+	std::vector<std::pair<u_int64_t, unsigned int>> work(merCodes.size());
+
+	for (unsigned int pass = 0; pass < passes; pass++)
+	{
+		const unsigned int shift = pass * 8;
+		size_t offset[257] = {0};
+		for (auto itr = merCodes.begin(); itr != merCodes.end(); ++itr)
+		{
+			offset[((itr->first >> shift) & 0xff) + 1]++;
+		}
+		for (unsigned int i = 1; i < 257; i++)
+		{
+			offset[i] += offset[i - 1];
+		}
+		for (auto itr = merCodes.begin(); itr != merCodes.end(); ++itr)
+		{
+			work[offset[(itr->first >> shift) & 0xff]++] = *itr;
+		}
+		merCodes.swap(work);
+	}
+}
@@ -0,0 +1,55 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef MER_CODE_H_
+#define MER_CODE_H_
+
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief K-mer packed in 2 bits per base (A=0, C=1, G=2, T=3).
+ *
+ * With this order the integer order of the codes of k-mers of the same length
+ * is their lexicographic order, so sorting codes sorts the k-mer strings.
+ */
+class MerCode
+{
+public:
+	/**
+	 * @brief Longest k-mer that fits in a code
+	 *
+	 */
+	static constexpr unsigned int MAX_KMER = 32;
+
+	/**
+	 * @brief Encode a k-mer.
+	 *
+	 * @param mer K-mer sequence
+	 * @param code Code of the k-mer
+	 * @return false if the k-mer is too long or has a base other than ACGT
+	 */
+	static bool encode(const std::string &mer, u_int64_t &code);
+
+	/**
+	 * @brief Decode a k-mer.
+	 *
+	 * @param code Code of the k-mer
+	 * @param kmer K-mer
+	 * @param mer K-mer sequence (kmer bytes)
+	 */
+	static void decode(u_int64_t code, const unsigned int kmer, char *mer);
+
+	/**
+	 * @brief Sort k-mer codes and counts by the code (LSD radix sort).
+	 *
+	 * @param merCodes K-mer codes and counts
+	 * @param kmer K-mer
+	 */
+	static void radix_sort(std::vector<std::pair<u_int64_t, unsigned int>> &merCodes,
+						   const unsigned int kmer);
+};
+#endif /* MER_CODE_H_ */
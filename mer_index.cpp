@@ -0,0 +1,232 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include "mer_index.h"
+#include "mer_code.h"
+
+/**
+ * @brief Code of each base (A=0, C=1, G=2, T=3, others 4)
+ *
+ */
+const unsigned char MerIndex::BASE_CODE[256] = {
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 0, 4, 1, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4};
+
+/**
+ * @brief Construct a new Mer Index:: Mer Index object
+ *
+ * @param kmer K-mer
+ */
+MerIndex::MerIndex(const unsigned int kmer)
+{
+	this->clear(kmer);
+}
+
+/**
+ * @brief Destroy the Mer Index:: Mer Index object
+ *
+ */
+MerIndex::~MerIndex()
+{
+}
+
+/**
+ * @brief Remove all k-mers.
+ *
+ * @param kmer K-mer
+ */
+void MerIndex::clear(const unsigned int kmer)
+{
+	this->kmer = kmer;
+	this->codeMask = kmer >= MerCode::MAX_KMER ? ~0ULL : (1ULL << (2 * kmer)) - 1;
+	this->codeArray.clear();
+	this->rehash(0);
+}
+
+/**
+ * @brief Bytes of an index of a number of k-mers (built by add).
+ *
+ * The code array grows by doubling, and the hash table has the smallest
+ * power of 2 slots of at least twice the k-mers (see rehash).
+ *
+ * @param number Number of k-mers
+ * @return Bytes of the codes, the hash table and the filter
+ */
+u_int64_t MerIndex::bytes(const size_t number)
+{
+	u_int64_t codes = 1;
+	while (codes < number)
+	{
+		codes *= 2;
+	}
+	u_int64_t slots = (u_int64_t)1 << 4;
+	while (slots < number * 2)
+	{
+		slots *= 2;
+	}
+	return codes * sizeof(u_int64_t) + slots * sizeof(u_int32_t) + slots / 2;
+}
+
+/**
+ * @brief Use arrays made by another index (read only, not copied).
+ *
+ * @param kmer K-mer
+ * @param number Number of k-mers
+ * @param codes Code of each id
+ * @param slotBits Number of slots = 2^slotBits
+ * @param slots Hash table
+ * @param filter Filter bits (2^(slotBits + 2) bits)
+ */
+void MerIndex::attach(const unsigned int kmer, const size_t number, const u_int64_t *codes,
+					  const unsigned int slotBits, const u_int32_t *slots, const u_int64_t *filter)
+{
+	this->kmer = kmer;
+	this->codeMask = kmer >= MerCode::MAX_KMER ? ~0ULL : (1ULL << (2 * kmer)) - 1;
+	this->codeArray.clear();
+	this->slotArray.clear();
+	this->filterArray.clear();
+
+	this->number = number;
+	this->codes = codes;
+	this->slotBits = slotBits;
+	this->slots = slots;
+	this->slotMask = ((u_int64_t)1 << slotBits) - 1;
+	this->filter = filter;
+	this->filterShift = 64 - (slotBits + 2);
+}
+
+/**
+ * @brief Copy the arrays of another index (into memory first touched by the calling thread).
+ *
+ * Used for a copy of the index on each NUMA node (--numa); the ids are the same.
+ *
+ * @param other Index to copy
+ */
+void MerIndex::copy(const MerIndex &other)
+{
+	this->kmer = other.kmer;
+	this->codeMask = other.codeMask;
+	this->codeArray.assign(other.codes, other.codes + other.number);
+	this->slotArray.assign(other.slots, other.slots + other.slotMask + 1);
+	this->filterArray.assign(other.filter, other.filter + ((size_t)1 << (other.slotBits + 2)) / 64);
+
+	this->number = this->codeArray.size();
+	this->codes = this->codeArray.data();
+	this->slotBits = other.slotBits;
+	this->slots = this->slotArray.data();
+	this->slotMask = other.slotMask;
+	this->filter = this->filterArray.data();
+	this->filterShift = other.filterShift;
+}
+
+/**
+ * @brief Add a k-mer.
+ *
+ * @param mer K-mer sequence
+ * @return Id of the k-mer (NOT_FOUND if it has a base other than ACGT)
+ */
+u_int32_t MerIndex::add(const std::string &mer)
+{
+	u_int64_t code;
+	if (mer.length() != this->kmer || !MerCode::encode(mer, code))
+	{
+		return NOT_FOUND;
+	}
+	u_int32_t id = this->find(code);
+	if (id != NOT_FOUND)
+	{
+		return id;
+	}
+
+	// Attached arrays are copied before they are changed.
+	if (this->slotArray.empty())
+	{
+		this->codeArray.assign(this->codes, this->codes + this->number);
+		this->rehash(this->number);
+	}
+
+	id = this->number;
+	this->codeArray.push_back(code);
+	this->codes = this->codeArray.data();
+	this->number = this->codeArray.size();
+	// Keep the load factor of the hash table at 1/2 or less.
+	if (this->number * 2 > this->slotMask + 1)
+	{
+		this->rehash(this->number);
+	}
+	else
+	{
+		this->insert(id);
+	}
+	return id;
+}
+
+/**
+ * @brief K-mer sequence of an id.
+ *
+ * @param id Id of the k-mer
+ * @return K-mer sequence
+ */
+std::string MerIndex::mer(const u_int32_t id) const
+{
+	std::string mer(this->kmer, 'A');
+	MerCode::decode(this->codes[id], this->kmer, &mer[0]);
+	return mer;
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Size the hash table and the filter for a number of k-mers.
+ *
+ * @param capacity Number of k-mers
+ */
+void MerIndex::rehash(const size_t capacity)
+{
+	// Slots: power of 2 and at least twice the k-mers, filter: 4 bits per slot.
+	this->slotBits = 4;
+	while (((size_t)1 << this->slotBits) < capacity * 2)
+	{
+		this->slotBits++;
+	}
+	this->slotArray.assign((size_t)1 << this->slotBits, 0);
+	this->slots = this->slotArray.data();
+	this->slotMask = this->slotArray.size() - 1;
+	this->filterArray.assign(((size_t)1 << (this->slotBits + 2)) / 64, 0);
+	this->filter = this->filterArray.data();
+	this->filterShift = 64 - (this->slotBits + 2);
+
+	this->codes = this->codeArray.data();
+	this->number = this->codeArray.size();
+	for (u_int32_t id = 0; id < this->number; id++)
+	{
+		this->insert(id);
+	}
+}
+
+/**
+ * @brief Put an id in the hash table and the filter.
+ *
+ * @param id Id of the k-mer
+ */
+void MerIndex::insert(const u_int32_t id)
+{
+	const u_int64_t h = hash(this->codes[id]);
+	const u_int64_t bit = h >> this->filterShift;
+	this->filterArray[bit >> 6] |= 1ULL << (bit & 63);
+
+	u_int64_t slot = h & this->slotMask;
+	while (this->slotArray[slot] != 0)
+	{
+		slot = (slot + 1) & this->slotMask;
+	}
+	this->slotArray[slot] = id + 1;
+}
@@ -0,0 +1,460 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef MER_INDEX_H_
+#define MER_INDEX_H_
+
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Index of the vector k-mers (k <= 32).
+ *
+ * Each k-mer is packed in 2 bits per base (see MerCode) and given a dense id
+ * (0, 1, 2, ...), so that counters can be plain arrays indexed by the id.
+ * The ids are found with an open addressing hash table of 32-bit slots, and
+ * a bit array in front of it rejects most of the read k-mers without touching
+ * the table. Memory is about 20 bytes per k-mer: the code (8), two slots (8)
+ * and 8-16 filter bits.
+ *
+ * The arrays may also be attached read only (e.g. from a memory-mapped vector
+ * index file); adding a k-mer then copies them first.
+ */
+class MerIndex
+{
+public:
+	/**
+	 * @brief Id of a k-mer that is not in the index
+	 *
+	 */
+	static constexpr u_int32_t NOT_FOUND = 0xffffffff;
+
+	/**
+	 * @brief Version of the hash function and the table layout (kept in index files)
+	 *
+	 */
+	static constexpr u_int32_t LAYOUT = 1;
+
+	/**
+	 * @brief Construct a new Mer Index object
+	 *
+	 * @param kmer K-mer
+	 */
+	MerIndex(const unsigned int kmer = 0);
+
+	/**
+	 * @brief Destroy the Mer Index object
+	 *
+	 */
+	virtual ~MerIndex();
+
+	/**
+	 * @brief Remove all k-mers.
+	 *
+	 * @param kmer K-mer
+	 */
+	void clear(const unsigned int kmer);
+
+	/**
+	 * @brief Add a k-mer.
+	 *
+	 * @param mer K-mer sequence
+	 * @return Id of the k-mer (NOT_FOUND if it has a base other than ACGT)
+	 */
+	u_int32_t add(const std::string &mer);
+
+	/**
+	 * @brief Number of k-mers.
+	 *
+	 * @return Number of k-mers
+	 */
+	size_t size() const
+	{
+		return this->number;
+	}
+
+	/**
+	 * @brief Bytes of an index of a number of k-mers (built by add).
+	 *
+	 * @param number Number of k-mers
+	 * @return Bytes of the codes, the hash table and the filter
+	 */
+	static u_int64_t bytes(const size_t number);
+
+	/**
+	 * @brief Use arrays made by another index (read only, not copied).
+	 *
+	 * @param kmer K-mer
+	 * @param number Number of k-mers
+	 * @param codes Code of each id
+	 * @param slotBits Number of slots = 2^slotBits
+	 * @param slots Hash table
+	 * @param filter Filter bits (2^(slotBits + 2) bits)
+	 */
+	void attach(const unsigned int kmer, const size_t number, const u_int64_t *codes,
+				const unsigned int slotBits, const u_int32_t *slots, const u_int64_t *filter);
+
+	/**
+	 * @brief Copy the arrays of another index (into memory first touched by the calling thread).
+	 *
+	 * @param other Index to copy
+	 */
+	void copy(const MerIndex &other);
+
+	// Getter (arrays for attach)
+
+	const u_int64_t *get_codes() const
+	{
+		return this->codes;
+	}
+
+	unsigned int get_slotBits() const
+	{
+		return this->slotBits;
+	}
+
+	const u_int32_t *get_slots() const
+	{
+		return this->slots;
+	}
+
+	const u_int64_t *get_filter() const
+	{
+		return this->filter;
+	}
+
+	/**
+	 * @brief K-mer sequence of an id.
+	 *
+	 * @param id Id of the k-mer
+	 * @return K-mer sequence
+	 */
+	std::string mer(const u_int32_t id) const;
+
+	/**
+	 * @brief Id of a k-mer code.
+	 *
+	 * @param code Code of the k-mer
+	 * @return Id of the k-mer (NOT_FOUND if not in the index)
+	 */
+	u_int32_t find(const u_int64_t code) const
+	{
+		const u_int64_t h = hash(code);
+		return this->in_filter(h) ? this->probe(code, h) : NOT_FOUND;
+	}
+
+	/**
+	 * @brief K-mer windows of a scan (for the metrics).
+	 *
+	 */
+	struct ScanCount
+	{
+		// Windows of ACGT bases (one per k-mer position, summed over the indexes)
+		u_int32_t windows = 0;
+
+		// Windows passing the filter in front of the hash table
+		u_int32_t passes = 0;
+
+		// K-mers found in the index
+		u_int32_t hits = 0;
+	};
+
+	/**
+	 * @brief Find the k-mers of a read.
+	 *
+	 * K-mers with a base other than ACGT are skipped.
+	 *
+	 * @param read Read sequence
+	 * @param found Called with (start position, id) of each k-mer in the index
+	 * @return Windows of the read
+	 */
+	template <typename Found>
+	ScanCount scan(const std::string &read, Found found) const
+	{
+		ScanCount count;
+		u_int64_t code = 0;
+		unsigned int valid = 0;
+		for (size_t i = 0; i < read.length(); i++)
+		{
+			const unsigned char base = BASE_CODE[(unsigned char)read[i]];
+			if (base > 3)
+			{
+				valid = 0;
+				continue;
+			}
+			code = ((code << 2) | base) & this->codeMask;
+			if (++valid >= this->kmer)
+			{
+				count.windows++;
+				const u_int64_t h = hash(code);
+				if (this->in_filter(h))
+				{
+					count.passes++;
+					const u_int32_t id = this->probe(code, h);
+					if (id != NOT_FOUND)
+					{
+						count.hits++;
+						found(i + 1 - this->kmer, id);
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+	/**
+	 * @brief Find the k-mers of a read in several indexes (one k each) at once.
+	 *
+	 * The read is encoded once: the code of a k-mer is the low 2k bits of the
+	 * rolling code of the longest k.
+	 *
+	 * @param read Read sequence
+	 * @param merIndexes Indexes
+	 * @param found Called with (index number, start position, id) of each k-mer in the indexes
+	 * @return Windows of the read
+	 */
+	template <typename Found>
+	static ScanCount scan(const std::string &read, const std::vector<const MerIndex *> &merIndexes, Found found)
+	{
+		ScanCount count;
+		u_int64_t code = 0;
+		unsigned int valid = 0;
+		for (size_t i = 0; i < read.length(); i++)
+		{
+			const unsigned char base = BASE_CODE[(unsigned char)read[i]];
+			if (base > 3)
+			{
+				valid = 0;
+				continue;
+			}
+			code = (code << 2) | base;
+			valid++;
+			for (size_t n = 0; n < merIndexes.size(); n++)
+			{
+				const MerIndex *merIndex = merIndexes[n];
+				if (valid >= merIndex->kmer)
+				{
+					count.windows++;
+					const u_int64_t mer = code & merIndex->codeMask;
+					const u_int64_t h = hash(mer);
+					if (merIndex->in_filter(h))
+					{
+						count.passes++;
+						const u_int32_t id = merIndex->probe(mer, h);
+						if (id != NOT_FOUND)
+						{
+							count.hits++;
+							found(n, i + 1 - merIndex->kmer, id);
+						}
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+private:
+	/**
+	 * @brief Code of each base (A=0, C=1, G=2, T=3, others 4)
+	 *
+	 */
+	static const unsigned char BASE_CODE[256];
+
+	/**
+	 * @brief K-mer
+	 *
+	 */
+	unsigned int kmer;
+
+	/**
+	 * @brief Bits of a k-mer code
+	 *
+	 */
+	u_int64_t codeMask;
+
+	/**
+	 * @brief Number of k-mers and code of each id
+	 *
+	 */
+	size_t number;
+	const u_int64_t *codes;
+
+	/**
+	 * @brief Hash table (id + 1, 0: empty)
+	 *
+	 */
+	unsigned int slotBits;
+	const u_int32_t *slots;
+	u_int64_t slotMask;
+
+	/**
+	 * @brief Filter bits (one hash)
+	 *
+	 */
+	const u_int64_t *filter;
+	unsigned int filterShift;
+
+	/**
+	 * @brief Arrays owned by this index (empty while attached)
+	 *
+	 */
+	std::vector<u_int64_t> codeArray;
+	std::vector<u_int32_t> slotArray;
+	std::vector<u_int64_t> filterArray;
+
+	/**
+	 * @brief Hash of a k-mer code.
+	 *
+	 * @param code Code of the k-mer
+	 * @return Hash
+	 */
+	static u_int64_t hash(u_int64_t code)
+	{
+		code ^= code >> 33;
+		code *= 0xff51afd7ed558ccdULL;
+		code ^= code >> 33;
+		code *= 0xc4ceb9fe1a85ec53ULL;
+		code ^= code >> 33;
+		return code;
+	}
+
+	/**
+	 * @brief Filter bit of a hash.
+	 *
+	 * @param h Hash of the k-mer code
+	 * @return False if the k-mer is not in the index
+	 */
+	bool in_filter(const u_int64_t h) const
+	{
+		return ((this->filter[(h >> this->filterShift) >> 6] >> ((h >> this->filterShift) & 63)) & 1) != 0;
+	}
+
+	/**
+	 * @brief Look up the hash table.
+	 *
+	 * @param code Code of the k-mer
+	 * @param h Hash of the code
+	 * @return Id of the k-mer (NOT_FOUND if not in the index)
+	 */
+	u_int32_t probe(const u_int64_t code, const u_int64_t h) const
+	{
+		for (u_int64_t slot = h & this->slotMask;; slot = (slot + 1) & this->slotMask)
+		{
+			const u_int32_t entry = this->slots[slot];
+			if (entry == 0)
+			{
+				return NOT_FOUND;
+			}
+			if (this->codes[entry - 1] == code)
+			{
+				return entry - 1;
+			}
+		}
+	}
+
+	/**
+	 * @brief Size the hash table and the filter for a number of k-mers.
+	 *
+	 * @param capacity Number of k-mers
+	 */
+	void rehash(const size_t capacity);
+
+	/**
+	 * @brief Put an id in the hash table and the filter.
+	 *
+	 * @param id Id of the k-mer
+	 */
+	void insert(const u_int32_t id);
+};
+
+/**
+ * @brief Ids of the k-mer and its complementary k-mer at each position of a vector.
+ *
+ * The ids are held, or used in place (e.g. in a memory-mapped vector index
+ * file, which keeps them so that a run does not look them up again).
+ */
+class PositionIds
+{
+public:
+	typedef std::pair<u_int32_t, u_int32_t> Pair;
+
+	/**
+	 * @brief Construct a new Position Ids object (no position)
+	 *
+	 */
+	PositionIds()
+	{
+		this->mapped = nullptr;
+		this->number = 0;
+	}
+
+	/**
+	 * @brief Hold ids (swapped in).
+	 *
+	 * @param ids Ids of each position
+	 */
+	void hold(std::vector<Pair> &ids)
+	{
+		this->ids.swap(ids);
+		this->mapped = nullptr;
+		this->number = this->ids.size();
+	}
+
+	/**
+	 * @brief Use ids in place (read only, not copied).
+	 *
+	 * @param ids Ids of each position
+	 * @param number Number of positions
+	 */
+	void attach(const Pair *ids, const size_t number)
+	{
+		this->ids.clear();
+		this->mapped = ids;
+		this->number = number;
+	}
+
+	void swap(PositionIds &other)
+	{
+		this->ids.swap(other.ids);
+		std::swap(this->mapped, other.mapped);
+		std::swap(this->number, other.number);
+	}
+
+	size_t size() const
+	{
+		return this->number;
+	}
+
+	const Pair *begin() const
+	{
+		return this->mapped ? this->mapped : this->ids.data();
+	}
+
+	const Pair *end() const
+	{
+		return this->begin() + this->number;
+	}
+
+	const Pair &operator[](const size_t i) const
+	{
+		return this->begin()[i];
+	}
+
+private:
+	/**
+	 * @brief Ids held (empty while used in place)
+	 *
+	 */
+	std::vector<Pair> ids;
+
+	/**
+	 * @brief Ids used in place and number of positions
+	 *
+	 */
+	const Pair *mapped;
+	size_t number;
+};
+#endif /* MER_INDEX_H_ */
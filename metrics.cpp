@@ -0,0 +1,234 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+#include "metrics.h"
+
+/**
+ * @brief Construct a new Metrics:: Metrics object
+ *
+ */
+Metrics::Metrics()
+{
+	this->start_wall = wall_time();
+}
+
+/**
+ * @brief Destroy the Metrics:: Metrics object
+ *
+ */
+Metrics::~Metrics()
+{
+}
+
+/**
+ * @brief Add the counters of a phase (thread safe).
+ *
+ * @param phase Phase (vector_load, decompress_parse, scan, merge, gtest, fdr, outside, write)
+ * @param file File of the phase (empty: the whole run)
+ * @param counters Counters
+ */
+void Metrics::add(const std::string &phase, const std::string &file, const Counters &counters)
+{
+	const std::lock_guard<std::mutex> lock(this->mutex);
+	const std::pair<std::string, std::string> key(phase, file);
+	auto itr = this->phaseIndex.find(key);
+	if (itr == this->phaseIndex.end())
+	{
+		itr = this->phaseIndex.emplace(key, this->phases.size()).first;
+		this->phases.emplace_back(key, Counters());
+	}
+	Counters &sum = this->phases[itr->second].second;
+	sum.calls += counters.calls;
+	sum.wall_seconds += counters.wall_seconds;
+	sum.cpu_seconds += counters.cpu_seconds;
+	sum.bytes_in += counters.bytes_in;
+	sum.bytes_out += counters.bytes_out;
+	sum.reads += counters.reads;
+	sum.windows += counters.windows;
+	sum.prefilter_pass += counters.prefilter_pass;
+	sum.hits += counters.hits;
+}
+
+/**
+ * @brief Add the writing of a result file (thread safe).
+ *
+ * @param file Result file (closed)
+ * @param stopwatch Time of the writing
+ */
+void Metrics::add_written(const std::string &file, Stopwatch &stopwatch)
+{
+	Counters counters;
+	counters.bytes_out = file_size(file);
+	this->add("write", file, stopwatch.stop(counters));
+}
+
+/**
+ * @brief Quote a string for JSON.
+ *
+ * Quotes, backslashes and control characters (e.g. a line break in a file
+ * name) are escaped.
+ *
+ * @param str String
+ * @return Quoted string
+ */
+std::string Metrics::json_string(const std::string &str)
+{
+	static const char hex[] = "0123456789abcdef";
+	std::string quoted = "\"";
+	for (const char c : str)
+	{
+		switch (c)
+		{
+		case '"':
+			quoted += "\\\"";
+			break;
+		case '\\':
+			quoted += "\\\\";
+			break;
+		case '\b':
+			quoted += "\\b";
+			break;
+		case '\f':
+			quoted += "\\f";
+			break;
+		case '\n':
+			quoted += "\\n";
+			break;
+		case '\r':
+			quoted += "\\r";
+			break;
+		case '\t':
+			quoted += "\\t";
+			break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				quoted += "\\u00";
+				quoted += hex[(unsigned char)c >> 4];
+				quoted += hex[(unsigned char)c & 0xf];
+			}
+			else
+			{
+				quoted += c;
+			}
+		}
+	}
+	return quoted + "\"";
+}
+
+/**
+ * @brief Write the metrics file.
+ *
+ * Each phase is given per file and as a total of the files; rates are
+ * derived from the counters (per second of wall time, per window).
+ *
+ * @param metricsFile Output file (JSON)
+ * @param version Program version
+ * @param calc_mode Command
+ * @param threads Number of threads
+ */
+void Metrics::write(const std::string &metricsFile, const std::string &version,
+					const std::string &calc_mode, const unsigned int threads) const
+{
+	const std::lock_guard<std::mutex> lock(this->mutex);
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	const long peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+	const long peak_rss_kb = usage.ru_maxrss;
+#endif
+	const double cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+							   usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+
+	// Totals of each phase over its files
+	std::vector<std::pair<std::string, Counters>> totals;
+	std::map<std::string, size_t> totalIndex;
+	for (auto itr = this->phases.begin(); itr != this->phases.end(); ++itr)
+	{
+		auto target = totalIndex.find(itr->first.first);
+		if (target == totalIndex.end())
+		{
+			target = totalIndex.emplace(itr->first.first, totals.size()).first;
+			totals.emplace_back(itr->first.first, Counters());
+		}
+		Counters &sum = totals[target->second].second;
+		const Counters &c = itr->second;
+		sum.calls += c.calls;
+		sum.wall_seconds += c.wall_seconds;
+		sum.cpu_seconds += c.cpu_seconds;
+		sum.bytes_in += c.bytes_in;
+		sum.bytes_out += c.bytes_out;
+		sum.reads += c.reads;
+		sum.windows += c.windows;
+		sum.prefilter_pass += c.prefilter_pass;
+		sum.hits += c.hits;
+	}
+
+	auto write_counters = [](std::ofstream &ofs, const Counters &c)
+	{
+		ofs << "\"calls\": " << c.calls << ", \"wall_seconds\": " << c.wall_seconds
+			<< ", \"cpu_seconds\": " << c.cpu_seconds << ", \"bytes_in\": " << c.bytes_in
+			<< ", \"bytes_out\": " << c.bytes_out << ", \"reads\": " << c.reads
+			<< ", \"windows\": " << c.windows << ", \"prefilter_pass\": " << c.prefilter_pass
+			<< ", \"hits\": " << c.hits;
+		if (c.wall_seconds > 0.0 && c.reads > 0)
+		{
+			ofs << ", \"reads_per_second\": " << c.reads / c.wall_seconds;
+		}
+		if (c.wall_seconds > 0.0 && c.bytes_in > 0)
+		{
+			ofs << ", \"bytes_in_per_second\": " << c.bytes_in / c.wall_seconds;
+		}
+		if (c.windows > 0)
+		{
+			ofs << ", \"prefilter_pass_rate\": " << (double)c.prefilter_pass / c.windows
+				<< ", \"hit_rate\": " << (double)c.hits / c.windows;
+		}
+	};
+
+	std::ofstream ofs(metricsFile);
+	ofs << "{\n  \"version\": " << json_string(version) << ",\n  \"command\": " << json_string(calc_mode)
+		<< ",\n  \"threads\": " << threads << ",\n  \"wall_seconds\": " << wall_time() - this->start_wall
+		<< ",\n  \"cpu_seconds\": " << cpu_seconds << ",\n  \"peak_rss_kb\": " << peak_rss_kb
+		<< ",\n  \"phases\": [";
+	for (size_t i = 0; i < this->phases.size(); i++)
+	{
+		ofs << (i > 0 ? "," : "") << "\n    {\"phase\": " << json_string(this->phases[i].first.first)
+			<< ", \"file\": " << json_string(this->phases[i].first.second) << ", ";
+		write_counters(ofs, this->phases[i].second);
+		ofs << "}";
+	}
+	ofs << "\n  ],\n  \"totals\": [";
+	for (size_t i = 0; i < totals.size(); i++)
+	{
+		ofs << (i > 0 ? "," : "") << "\n    {\"phase\": " << json_string(totals[i].first) << ", ";
+		write_counters(ofs, totals[i].second);
+		ofs << "}";
+	}
+	ofs << "\n  ]\n}\n";
+	if (!ofs)
+	{
+		std::cerr << "[Error] Could not write (" << metricsFile << ")." << std::endl;
+		std::exit(1);
+	}
+}
+
+/**
+ * @brief Size of a file.
+ *
+ * @param file File
+ * @return Bytes (0 if the file is missing)
+ */
+u_int64_t Metrics::file_size(const std::string &file)
+{
+	std::error_code ec;
+	const u_int64_t size = std::filesystem::file_size(file, ec);
+	return ec ? 0 : size;
+}
@@ -0,0 +1,215 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Performance metrics of each phase and file (<prefix>.metrics.json).
+ *
+ * The stages add their counters once per block of reads or per file, so the
+ * mutex is not taken on the path of each read.
+ */
+class Metrics
+{
+public:
+	/**
+	 * @brief Counters of a phase
+	 *
+	 */
+	struct Counters
+	{
+		// Number of additions (blocks of reads, files, ...)
+		u_int64_t calls = 0;
+
+		// Wall time and CPU time of all threads
+		double wall_seconds = 0.0;
+		double cpu_seconds = 0.0;
+
+		// Bytes read (compressed) and bytes produced (uncompressed or written)
+		u_int64_t bytes_in = 0;
+		u_int64_t bytes_out = 0;
+
+		// Reads, k-mer windows scanned, windows passing the prefilter and k-mers found
+		u_int64_t reads = 0;
+		u_int64_t windows = 0;
+		u_int64_t prefilter_pass = 0;
+		u_int64_t hits = 0;
+	};
+
+	/**
+	 * @brief Wall time and CPU time of the calling thread, with pauses.
+	 *
+	 */
+	class Stopwatch
+	{
+	public:
+		/**
+		 * @brief Construct a new Stopwatch object
+		 *
+		 * @param running Start at once
+		 */
+		Stopwatch(const bool running = true)
+		{
+			if (running)
+			{
+				this->start();
+			}
+		}
+
+		void start()
+		{
+			this->wall_start = wall_time();
+			this->cpu_start = thread_cpu_time();
+			this->running = true;
+		}
+
+		void stop()
+		{
+			if (this->running)
+			{
+				this->wall_seconds += wall_time() - this->wall_start;
+				this->cpu_seconds += thread_cpu_time() - this->cpu_start;
+				this->running = false;
+			}
+		}
+
+		/**
+		 * @brief Stop and give the times to counters.
+		 *
+		 * @param counters Counters of a phase
+		 * @return Counters with the times (and one call)
+		 */
+		Counters &stop(Counters &counters)
+		{
+			this->stop();
+			counters.calls = std::max(counters.calls, (u_int64_t)1);
+			counters.wall_seconds = this->wall_seconds;
+			counters.cpu_seconds = this->cpu_seconds;
+			return counters;
+		}
+
+		double get_wall() const
+		{
+			return this->wall_seconds;
+		}
+
+		double get_cpu() const
+		{
+			return this->cpu_seconds;
+		}
+
+	private:
+		double wall_start = 0.0;
+		double cpu_start = 0.0;
+		double wall_seconds = 0.0;
+		double cpu_seconds = 0.0;
+		bool running = false;
+	};
+
+	/**
+	 * @brief Construct a new Metrics object
+	 *
+	 */
+	Metrics();
+
+	/**
+	 * @brief Destroy the Metrics object
+	 *
+	 */
+	virtual ~Metrics();
+
+	/**
+	 * @brief Add the counters of a phase (thread safe).
+	 *
+	 * @param phase Phase (vector_load, decompress_parse, scan, merge, gtest, fdr, outside, write)
+	 * @param file File of the phase (empty: the whole run)
+	 * @param counters Counters
+	 */
+	void add(const std::string &phase, const std::string &file, const Counters &counters);
+
+	/**
+	 * @brief Add the writing of a result file (thread safe).
+	 *
+	 * @param file Result file (closed)
+	 * @param stopwatch Time of the writing
+	 */
+	void add_written(const std::string &file, Stopwatch &stopwatch);
+
+	/**
+	 * @brief Write the metrics file.
+	 *
+	 * @param metricsFile Output file (JSON)
+	 * @param version Program version
+	 * @param calc_mode Command
+	 * @param threads Number of threads
+	 */
+	void write(const std::string &metricsFile, const std::string &version,
+			   const std::string &calc_mode, const unsigned int threads) const;
+
+	/**
+	 * @brief Wall time.
+	 *
+	 * @return Seconds of a steady clock
+	 */
+	static double wall_time()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * @brief CPU time of the calling thread.
+	 *
+	 * @return Seconds
+	 */
+	static double thread_cpu_time()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+
+	/**
+	 * @brief Size of a file.
+	 *
+	 * @param file File
+	 * @return Bytes (0 if the file is missing)
+	 */
+	static u_int64_t file_size(const std::string &file);
+
+	/**
+	 * @brief Quote a string for JSON.
+	 *
+	 * @param str String
+	 * @return Quoted string
+	 */
+	static std::string json_string(const std::string &str);
+
+private:
+	/**
+	 * @brief Start of the run
+	 *
+	 */
+	double start_wall;
+
+	/**
+	 * @brief Counters by phase and file, in the order of the first addition
+	 *
+	 */
+	std::vector<std::pair<std::pair<std::string, std::string>, Counters>> phases;
+	std::map<std::pair<std::string, std::string>, size_t> phaseIndex;
+
+	mutable std::mutex mutex;
+};
+#endif /* METRICS_H_ */
@@ -0,0 +1,132 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <sys/types.h>
+#include "numa_placement.h"
+#ifdef HAVE_NUMA
+#include <numa.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef HAVE_NUMA
+namespace
+{
+	// Node the calling thread is bound to (-1: none)
+	thread_local int boundNode = -1;
+}
+#endif
+
+/**
+ * @brief Construct a new Numa Placement:: Numa Placement object
+ *
+ */
+NumaPlacement::NumaPlacement()
+{
+	this->enabled = false;
+}
+
+/**
+ * @brief Destroy the Numa Placement:: Numa Placement object
+ *
+ */
+NumaPlacement::~NumaPlacement()
+{
+}
+
+/**
+ * @brief Use the nodes the process may run on.
+ *
+ * @return false if NUMA is not supported by the build or the system
+ */
+bool NumaPlacement::enable()
+{
+#ifdef HAVE_NUMA
+	if (numa_available() < 0)
+	{
+		return false;
+	}
+	this->nodes.clear();
+	struct bitmask *mask = numa_get_run_node_mask();
+	for (int node = 0; node <= numa_max_node(); node++)
+	{
+		if (numa_bitmask_isbitset(mask, node))
+		{
+			this->nodes.push_back(node);
+		}
+	}
+	numa_bitmask_free(mask);
+	this->enabled = !this->nodes.empty();
+	return this->enabled;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Bind the calling OpenMP thread to its node.
+ *
+ * The thread number counts the threads of all nested levels (outer thread
+ * times the inner threads plus the inner thread); the numbers are split
+ * into one contiguous range per node.
+ *
+ * @return Node of the thread (0 to size() - 1)
+ */
+unsigned int NumaPlacement::place() const
+{
+	if (!this->enabled)
+	{
+		return 0;
+	}
+	u_int64_t thread = 0;
+	u_int64_t threads = 1;
+#ifdef _OPENMP
+	for (int level = 1; level <= omp_get_level(); level++)
+	{
+		thread = thread * omp_get_team_size(level) + omp_get_ancestor_thread_num(level);
+		threads *= omp_get_team_size(level);
+	}
+#endif
+	const unsigned int node = thread * this->nodes.size() / threads;
+	this->bind(node);
+	return node;
+}
+
+/**
+ * @brief Bind the calling thread to a node.
+ *
+ * Later allocations of the thread are taken from the node.
+ *
+ * @param node Node (0 to size() - 1)
+ */
+void NumaPlacement::bind(const unsigned int node) const
+{
+#ifdef HAVE_NUMA
+	if (!this->enabled || node >= this->nodes.size() || boundNode == this->nodes[node])
+	{
+		return;
+	}
+	numa_run_on_node(this->nodes[node]);
+	numa_set_localalloc();
+	boundNode = this->nodes[node];
+#else
+	(void)node;
+#endif
+}
+
+/**
+ * @brief Nodes used (system numbers).
+ *
+ * @return Comma separated nodes
+ */
+std::string NumaPlacement::describe() const
+{
+	std::string list;
+	for (size_t i = 0; i < this->nodes.size(); i++)
+	{
+		list += (i > 0 ? "," : "") + std::to_string(this->nodes[i]);
+	}
+	return list;
+}
@@ -0,0 +1,94 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef NUMA_PLACEMENT_H_
+#define NUMA_PLACEMENT_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Placement of the threads and their memory on the NUMA nodes (--numa).
+ *
+ * A build with make NUMA=1 (HAVE_NUMA, needs libnuma) binds each thread of
+ * the OpenMP outer/inner parallel to a node: the threads are numbered over
+ * both levels and given to the nodes in contiguous ranges, so the threads of
+ * a file share a node when at least as many files as nodes are read at once.
+ * Memory is then taken from the node of the thread that first touches it:
+ * the blocks of reads of a file, the counters of each thread and the copy of
+ * the k-mer index made for each node. Otherwise nothing is bound and there
+ * is one node.
+ */
+class NumaPlacement
+{
+public:
+	/**
+	 * @brief Construct a new Numa Placement object
+	 *
+	 */
+	NumaPlacement();
+
+	/**
+	 * @brief Destroy the Numa Placement object
+	 *
+	 */
+	virtual ~NumaPlacement();
+
+	/**
+	 * @brief Use the nodes the process may run on.
+	 *
+	 * @return false if NUMA is not supported by the build or the system
+	 */
+	bool enable();
+
+	bool is_enabled() const
+	{
+		return this->enabled;
+	}
+
+	/**
+	 * @brief Number of nodes (1 if not enabled).
+	 *
+	 * @return Number of nodes
+	 */
+	unsigned int size() const
+	{
+		return this->enabled ? this->nodes.size() : 1;
+	}
+
+	/**
+	 * @brief Bind the calling OpenMP thread to its node.
+	 *
+	 * @return Node of the thread (0 to size() - 1)
+	 */
+	unsigned int place() const;
+
+	/**
+	 * @brief Bind the calling thread to a node.
+	 *
+	 * @param node Node (0 to size() - 1)
+	 */
+	void bind(const unsigned int node) const;
+
+	/**
+	 * @brief Nodes used (system numbers).
+	 *
+	 * @return Comma separated nodes
+	 */
+	std::string describe() const;
+
+private:
+	/**
+	 * @brief Threads are bound.
+	 *
+	 */
+	bool enabled;
+
+	/**
+	 * @brief System number of each node used
+	 *
+	 */
+	std::vector<int> nodes;
+};
+#endif /* NUMA_PLACEMENT_H_ */
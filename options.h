@@ -11,6 +11,10 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include "metrics.h"
+#include "numa_placement.h"
+#include "progress.h"
+#include "trace.h"
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -37,7 +41,7 @@ public:
 	{
 	}
 
-	// Calculation mode (kmer or oft)
+	// Calculation mode (kmer, count or test)
 	std::string calc_mode;
 
 	// Vector file
@@ -52,6 +56,9 @@ public:
 	// K-mer
 	unsigned int kmer = 20;
 
+	// K-mers of the run (-k 16,20,24,31); kmer is the one being analysed
+	std::vector<unsigned int> kmers = {20};
+
 	// Threshold by FDR
 	double threshold_fdr = 0.01;
 
@@ -70,6 +77,57 @@ public:
 	// Log output interval
 	unsigned int log_output_interval = 1000000;
 
+	// Compression of result files (none, gz or zst)
+	std::string compress = "none";
+
+	// Write result files in the binary columnar format (.gesc)
+	bool binary = false;
+
+	// Directory of the count files (count and test modes)
+	std::string cache_dir = "kmer_cache";
+
+	// Cache the wild type counts in cache_dir (kmer mode with -c)
+	bool cache_wildType = false;
+
+	// Cache the counts of all files in cache_dir and read only new files (kmer mode with -I)
+	bool incremental = false;
+
+	// Directory of the checkpoints of the FASTQ scans (empty: no checkpoints)
+	std::string checkpoint_dir;
+
+	// Byte-range shard of each FASTQ file to count (count mode, 1 to shards)
+	unsigned int shard = 0;
+
+	// Number of shards of each FASTQ file (0: whole files)
+	unsigned int shards = 0;
+
+	// Fraction of the reads to analyse, chosen by the hash of the read name (1: all reads)
+	double fraction = 1.0;
+
+	// Sequential mode: stop reading the mutant files when a vector has this many positions detected (0: off)
+	unsigned int early_positions = 0;
+
+	// Haploid genome size (bases) for the power of the sequential mode (0: stop on a detection only)
+	double genome_size = 0.0;
+
+	// Copies per haploid genome of an insert to be ruled out
+	double copies = 1.0;
+
+	// Power to call an insert absent
+	double power = 0.95;
+
+	// Seconds between the polls of the watch mode
+	unsigned int watch_interval = 60;
+
+	// Choose the OpenMP outer/inner parallel and -r from a probe of the FASTQ files
+	bool auto_tune = false;
+
+	// Memory limit in bytes; -r and the files read at once are fitted to it (0: no limit)
+	u_int64_t max_memory = 0;
+
+	// Timeline of the phases of each thread (Chrome trace-event JSON; empty: none)
+	std::string trace_file = "";
+
 	// Number of threads
 	unsigned int threads = 0;
 
@@ -79,21 +137,27 @@ public:
 	// OpenMP inner parallel
 	unsigned int inner_parallel = 1;
 
-	// int(32 bit) / (2 bit/base) = 16 bases
-	const unsigned int MAX_CHUNKLENGTH = 16;
-
-	// MIN_CHUNKLENGTH > 0
-	const unsigned int MIN_CHUNKLENGTH = 8;
+	// Shortest k-mer
+	const unsigned int MIN_KMER = 8;
 
-	// Chunk length
-	unsigned int chunk_length;
-
-	// Array length required for specified chunk length
-	unsigned int max_chunk_array;
+	// u_int64_t(64 bit) / (2 bit/base) = 32 bases (k-mer index)
+	const unsigned int MAX_KMER = 32;
 
 	// start time
 	std::chrono::system_clock::time_point start_time;
 
+	// Performance metrics of the phases (<out_prefix>.metrics.json)
+	Metrics metrics;
+
+	// Progress log of the FASTQ files being read
+	Progress progress;
+
+	// Timeline of the phases (--trace)
+	Trace trace;
+
+	// Threads and memory on the NUMA nodes (--numa)
+	NumaPlacement numa;
+
 	/**
 	 * @brief Get start time.
 	 *
@@ -192,7 +256,12 @@ public:
 		{
 			std::cout << "              " << *itr << std::endl;
 		}
-		std::cout << "K-mer                         = " << this->kmer << std::endl;
+		std::cout << "K-mer                         = ";
+		for (size_t i = 0; i < this->kmers.size(); i++)
+		{
+			std::cout << (i > 0 ? "," : "") << this->kmers[i];
+		}
+		std::cout << std::endl;
 		std::cout << "Threshold by FDR              = " << this->threshold_fdr << std::endl;
 		std::cout << "Number of bases on each side  = " << this->bases_on_each_side << std::endl;
 		std::cout << "Output prefix                 = " << this->out_prefix << std::endl;
@@ -200,6 +269,44 @@ public:
 		std::cout << "Number of lines of Fastq file" << std::endl;
 		std::cout << "         to be read in memory = " << this->fastq_read_lines << std::endl;
 		std::cout << "Log output interval           = " << this->log_output_interval << std::endl;
+		std::cout << "Compression of result files   = " << this->compress << std::endl;
+		std::cout << "Binary columnar result files  = " << (this->binary ? "yes" : "no") << std::endl;
+		if (this->calc_mode != "kmer" || this->cache_wildType || this->incremental)
+		{
+			std::cout << "Count file directory          = " << this->cache_dir << std::endl;
+		}
+		if (!this->checkpoint_dir.empty())
+		{
+			std::cout << "Checkpoint directory          = " << this->checkpoint_dir << std::endl;
+		}
+		if (this->fraction < 1.0)
+		{
+			std::cout << "Fraction of the reads         = " << this->fraction << std::endl;
+		}
+		if (this->early_positions > 0)
+		{
+			std::cout << "Early stop: positions detected = " << this->early_positions << std::endl;
+			std::cout << "Early stop: genome size       = " << this->genome_size << std::endl;
+			std::cout << "Early stop: copies            = " << this->copies << std::endl;
+			std::cout << "Early stop: power             = " << this->power << std::endl;
+		}
+		if (this->calc_mode == "watch")
+		{
+			std::cout << "Watch interval (seconds)      = " << this->watch_interval << std::endl;
+		}
+		if (this->shards > 0)
+		{
+			std::cout << "Shard of the FASTQ files      = " << this->shard << " of " << this->shards << std::endl;
+		}
+		if (!this->trace_file.empty())
+		{
+			std::cout << "Trace file                    = " << this->trace_file << std::endl;
+		}
+		if (this->numa.is_enabled())
+		{
+			std::cout << "NUMA nodes                    = " << this->numa.describe()
+					  << " (threads bound, k-mer index copied to each node)" << std::endl;
+		}
 		std::cout << std::flush;
 
 #ifdef _OPENMP
@@ -0,0 +1,39 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef PROBES_H_
+#define PROBES_H_
+
+/**
+ * @brief Static tracepoints (USDT) of the scan and I/O paths.
+ *
+ * When <sys/sdt.h> of systemtap-sdt-dev is found, make builds with HAVE_SDT
+ * and places a probe of provider "geneditscan" at each GENEDITSCAN_PROBE: a
+ * nop instruction and a note in the ELF file, which perf, bpftrace or stap
+ * attach to at run time. With make USDT=0 (or without the header) the macros
+ * expand to nothing and their arguments are not evaluated.
+ *
+ * Probes (arguments):
+ *   parse        (file, reads parsed, compressed offset, uncompressed offset)
+ *                every 4096 records; the compressed offset steps with the
+ *                refills of the zlib input buffer
+ *   batch_start  (file, reads of the block)
+ *   batch_end    (file, reads of the block, k-mer windows, hits)
+ *   read_scan    (k-mer windows, windows passing the prefilter, hits) per read
+ *   hit          (mer id, position in the read) per vector k-mer found
+ *
+ * Example: bpftrace -e 'usdt:./geneditscan:geneditscan:read_scan { @pass = hist(arg1); }'
+ */
+#ifdef HAVE_SDT
+#include <sys/sdt.h>
+#define GENEDITSCAN_PROBE2(name, a1, a2) DTRACE_PROBE2(geneditscan, name, a1, a2)
+#define GENEDITSCAN_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(geneditscan, name, a1, a2, a3)
+#define GENEDITSCAN_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(geneditscan, name, a1, a2, a3, a4)
+#else
+#define GENEDITSCAN_PROBE2(name, a1, a2)
+#define GENEDITSCAN_PROBE3(name, a1, a2, a3)
+#define GENEDITSCAN_PROBE4(name, a1, a2, a3, a4)
+#endif
+
+#endif /* PROBES_H_ */
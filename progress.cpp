@@ -0,0 +1,152 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "metrics.h"
+#include "progress.h"
+
+/**
+ * @brief Construct a new Progress:: File:: File object
+ *
+ * @param name FASTQ file
+ * @param analysis Analysis (k-mer match, ...)
+ * @param size End of the bytes to read (0: unknown, no ETA)
+ * @param reads Reads before the start (resumed checkpoint)
+ * @param bytes Offset of the start
+ */
+Progress::File::File(const std::string &name, const std::string &analysis,
+					 const u_int64_t size, const u_int64_t reads, const u_int64_t bytes)
+	: name(name), analysis(analysis), size(size), start_time(Metrics::wall_time()),
+	  start_reads(reads), start_bytes(bytes), reads(reads), bytes(bytes), windows(0), hits(0),
+	  next_report(0)
+{
+}
+
+/**
+ * @brief Construct a new Progress:: Progress object
+ *
+ */
+Progress::Progress()
+{
+	this->interval = 1000000;
+	this->running = false;
+}
+
+/**
+ * @brief Destroy the Progress:: Progress object (stops the reporter thread)
+ *
+ */
+Progress::~Progress()
+{
+	{
+		const std::lock_guard<std::mutex> lock(this->mutex);
+		this->running = false;
+	}
+	this->wakeup.notify_all();
+	if (this->reporter.joinable())
+	{
+		this->reporter.join();
+	}
+}
+
+/**
+ * @brief Start following a file (thread safe).
+ *
+ * The reporter thread is started with the first file.
+ *
+ * @param name FASTQ file
+ * @param analysis Analysis (k-mer match, ...)
+ * @param size End of the bytes to read (0: unknown, no ETA)
+ * @param reads Reads before the start (resumed checkpoint)
+ * @param bytes Offset of the start
+ * @return Counters of the file (valid until close)
+ */
+Progress::File &Progress::open(const std::string &name, const std::string &analysis,
+							   const u_int64_t size, const u_int64_t reads, const u_int64_t bytes)
+{
+	const std::lock_guard<std::mutex> lock(this->mutex);
+	File &file = this->files.emplace_back(name, analysis, size, reads, bytes);
+	if (this->interval > 0)
+	{
+		file.next_report = (reads / this->interval + 1) * this->interval;
+		if (!this->running)
+		{
+			this->running = true;
+			this->reporter = std::thread(&Progress::report, this);
+		}
+	}
+	return file;
+}
+
+/**
+ * @brief Stop following a file (thread safe).
+ *
+ * @param file Counters of the file
+ */
+void Progress::close(File &file)
+{
+	const std::lock_guard<std::mutex> lock(this->mutex);
+	for (auto itr = this->files.begin(); itr != this->files.end(); ++itr)
+	{
+		if (&*itr == &file)
+		{
+			this->files.erase(itr);
+			break;
+		}
+	}
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Print the files passing another log output interval, once a second.
+ *
+ * The rates are averages since the start of the file; the ETA is the
+ * compressed bytes left at the compressed rate.
+ */
+void Progress::report()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (this->running)
+	{
+		this->wakeup.wait_for(lock, std::chrono::seconds(1));
+		const double now = Metrics::wall_time();
+		for (File &file : this->files)
+		{
+			const u_int64_t reads = file.reads.load(std::memory_order_relaxed);
+			if (reads < file.next_report)
+			{
+				continue;
+			}
+			file.next_report = (reads / this->interval + 1) * this->interval;
+
+			const u_int64_t bytes = file.bytes.load(std::memory_order_relaxed);
+			const u_int64_t windows = file.windows.load(std::memory_order_relaxed);
+			const u_int64_t hits = file.hits.load(std::memory_order_relaxed);
+			const double seconds = std::max(now - file.start_time, 1e-3);
+			const double bytes_per_second = (bytes - file.start_bytes) / seconds;
+
+			std::ostringstream line;
+			line << file.name << ": parsing " << reads << " reads (" << file.analysis << "), "
+				 << std::fixed << std::setprecision(0) << (reads - file.start_reads) / seconds << " reads/s, "
+				 << std::setprecision(1) << bytes_per_second / 1e6 << " MB/s";
+			if (windows > 0)
+			{
+				line << ", hits " << std::setprecision(4) << 100.0 * hits / windows << "% of k-mers";
+			}
+			if (file.size > bytes && bytes_per_second > 0)
+			{
+				const u_int64_t eta = (file.size - bytes) / bytes_per_second;
+				line << ", ETA " << eta / 3600 << ":" << std::setfill('0')
+					 << std::setw(2) << eta / 60 % 60 << ":" << std::setw(2) << eta % 60;
+			}
+			std::cerr << line.str() << "." << std::endl;
+		}
+	}
+}
@@ -0,0 +1,159 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef PROGRESS_H_
+#define PROGRESS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+
+/**
+ * @brief Progress log of the FASTQ files being read.
+ *
+ * The thread reading a file stores its counters with relaxed atomics; a
+ * reporter thread reads them once a second and prints a line each time a
+ * file passes another log output interval (-i) of reads, so the threads
+ * scanning the reads are never synchronised for the log.
+ */
+class Progress
+{
+public:
+	/**
+	 * @brief Counters of a file being read (written by its reading thread only)
+	 *
+	 */
+	class File
+	{
+	public:
+		/**
+		 * @brief Construct a new File object
+		 *
+		 * @param name FASTQ file
+		 * @param analysis Analysis (k-mer match, ...)
+		 * @param size End of the bytes to read (0: unknown, no ETA)
+		 * @param reads Reads before the start (resumed checkpoint)
+		 * @param bytes Offset of the start
+		 */
+		File(const std::string &name, const std::string &analysis,
+			 const u_int64_t size, const u_int64_t reads, const u_int64_t bytes);
+
+		/**
+		 * @brief Set the reads parsed and the compressed offset.
+		 *
+		 * @param reads Reads parsed
+		 * @param bytes Compressed offset
+		 */
+		void update(const u_int64_t reads, const u_int64_t bytes)
+		{
+			this->reads.store(reads, std::memory_order_relaxed);
+			this->bytes.store(bytes, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Add the k-mer windows and hits of a block of reads.
+		 *
+		 * @param windows K-mer windows scanned
+		 * @param hits Vector k-mers found
+		 */
+		void add_scan(const u_int64_t windows, const u_int64_t hits)
+		{
+			this->windows.fetch_add(windows, std::memory_order_relaxed);
+			this->hits.fetch_add(hits, std::memory_order_relaxed);
+		}
+
+	private:
+		friend class Progress;
+
+		const std::string name;
+		const std::string analysis;
+		const u_int64_t size;
+
+		// Start of the reading (for the rates)
+		const double start_time;
+		const u_int64_t start_reads;
+		const u_int64_t start_bytes;
+
+		std::atomic<u_int64_t> reads;
+		std::atomic<u_int64_t> bytes;
+		std::atomic<u_int64_t> windows;
+		std::atomic<u_int64_t> hits;
+
+		// Reads of the next log line (reporter thread only)
+		u_int64_t next_report;
+	};
+
+	/**
+	 * @brief Construct a new Progress object
+	 *
+	 */
+	Progress();
+
+	/**
+	 * @brief Destroy the Progress object (stops the reporter thread)
+	 *
+	 */
+	virtual ~Progress();
+
+	/**
+	 * @brief Set the log output interval.
+	 *
+	 * @param interval Reads between two log lines of a file
+	 */
+	void set_interval(const u_int64_t interval)
+	{
+		this->interval = interval;
+	}
+
+	/**
+	 * @brief Start following a file (thread safe).
+	 *
+	 * The reporter thread is started with the first file.
+	 *
+	 * @param name FASTQ file
+	 * @param analysis Analysis (k-mer match, ...)
+	 * @param size End of the bytes to read (0: unknown, no ETA)
+	 * @param reads Reads before the start (resumed checkpoint)
+	 * @param bytes Offset of the start
+	 * @return Counters of the file (valid until close)
+	 */
+	File &open(const std::string &name, const std::string &analysis,
+			   const u_int64_t size, const u_int64_t reads = 0, const u_int64_t bytes = 0);
+
+	/**
+	 * @brief Stop following a file (thread safe).
+	 *
+	 * @param file Counters of the file
+	 */
+	void close(File &file);
+
+private:
+	/**
+	 * @brief Print the files passing another log output interval, once a second.
+	 *
+	 */
+	void report();
+
+	/**
+	 * @brief Reads between two log lines of a file
+	 *
+	 */
+	u_int64_t interval;
+
+	/**
+	 * @brief Files being read
+	 *
+	 */
+	std::list<File> files;
+
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::thread reporter;
+	bool running;
+};
+#endif /* PROGRESS_H_ */
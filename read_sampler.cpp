@@ -0,0 +1,25 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <cmath>
+#include "read_sampler.h"
+
+/**
+ * @brief Construct a new Read Sampler:: Read Sampler object
+ *
+ * @param fraction Fraction of the reads to keep (1: all)
+ */
+ReadSampler::ReadSampler(const double fraction)
+{
+	this->all = fraction >= 1.0;
+	this->threshold = this->all ? 0 : (u_int64_t)std::ldexp(fraction, 64);
+}
+
+/**
+ * @brief Destroy the Read Sampler:: Read Sampler object
+ *
+ */
+ReadSampler::~ReadSampler()
+{
+}
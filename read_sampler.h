@@ -0,0 +1,94 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef READ_SAMPLER_H_
+#define READ_SAMPLER_H_
+
+#include <string>
+#include <sys/types.h>
+
+/**
+ * @brief Deterministic subsample of the reads (--fraction).
+ *
+ * A read is kept when the hash of its name is below fraction x 2^64. The
+ * name is the first word of the header line without the mate suffix /1 or
+ * /2, so that the same pairs are kept in the R1 and R2 files of every run.
+ */
+class ReadSampler
+{
+public:
+	/**
+	 * @brief Construct a new Read Sampler object
+	 *
+	 * @param fraction Fraction of the reads to keep (1: all)
+	 */
+	ReadSampler(const double fraction);
+
+	/**
+	 * @brief Destroy the Read Sampler object
+	 *
+	 */
+	virtual ~ReadSampler();
+
+	/**
+	 * @brief Whether a read is in the subsample.
+	 *
+	 * @param header Header line of the read (starting with '@')
+	 * @return true if the read is kept
+	 */
+	bool keep(const std::string &header) const
+	{
+		if (this->all)
+		{
+			return true;
+		}
+		size_t end = 1;
+		while (end < header.length() && header[end] != ' ' && header[end] != '\t' &&
+			   header[end] != '\n' && header[end] != '\r')
+		{
+			end++;
+		}
+		if (end >= 3 && header[end - 2] == '/' && (header[end - 1] == '1' || header[end - 1] == '2'))
+		{
+			end -= 2;
+		}
+		return hash(header.data() + 1, end - 1) < this->threshold;
+	}
+
+private:
+	/**
+	 * @brief All reads are kept
+	 *
+	 */
+	bool all;
+
+	/**
+	 * @brief Hashes below this are kept
+	 *
+	 */
+	u_int64_t threshold;
+
+	/**
+	 * @brief Hash of a read name (FNV-1a, then mixed).
+	 *
+	 * @param data Read name
+	 * @param length Length of the name
+	 * @return Hash
+	 */
+	static u_int64_t hash(const char *data, const size_t length)
+	{
+		u_int64_t h = 0xcbf29ce484222325ULL;
+		for (size_t i = 0; i < length; i++)
+		{
+			h = (h ^ (unsigned char)data[i]) * 0x100000001b3ULL;
+		}
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+};
+#endif /* READ_SAMPLER_H_ */
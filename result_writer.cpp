@@ -0,0 +1,255 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "result_writer.h"
+
+/**
+ * @brief Whether the string ends with the suffix.
+ *
+ * @param str String
+ * @param suffix Suffix
+ * @return true if the string ends with the suffix
+ */
+static bool ends_with(const std::string &str, const std::string &suffix)
+{
+	return str.length() >= suffix.length() &&
+		   str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+/**
+ * @brief Construct a new Result Writer:: Result Writer object
+ *
+ * @param outfile Output file
+ */
+ResultWriter::ResultWriter(const std::string &outfile)
+{
+	this->outfile = outfile;
+	if (ends_with(outfile, ".gz"))
+	{
+		// Level 1: the result files are highly redundant text.
+		this->gzipFile = gzopen(outfile.c_str(), "wb1");
+		if (this->gzipFile)
+		{
+			gzbuffer(this->gzipFile, BUFFER_SIZE);
+		}
+	}
+	else if (ends_with(outfile, ".zst"))
+	{
+#ifdef HAVE_ZSTD
+		this->plainFile = fopen(outfile.c_str(), "wb");
+		this->zstdContext = ZSTD_createCCtx();
+		ZSTD_CCtx_setParameter(this->zstdContext, ZSTD_c_compressionLevel, 3);
+		this->zstdBuffer.resize(ZSTD_CStreamOutSize());
+#else
+		std::cerr << "[Error] zstd output is not supported in this build (" << outfile << ")." << std::endl;
+		std::exit(1);
+#endif
+	}
+	else
+	{
+		this->plainFile = fopen(outfile.c_str(), "wb");
+	}
+
+	if (!this->plainFile && !this->gzipFile)
+	{
+		std::cerr << "[Error] Could not open (" << outfile << ")." << std::endl;
+		std::exit(1);
+	}
+
+	this->front.resize(BUFFER_SIZE);
+	this->back.resize(BUFFER_SIZE);
+	this->pos = this->front.data();
+	this->last = this->front.data() + this->front.size();
+	this->writer = std::thread(&ResultWriter::write_loop, this);
+}
+
+/**
+ * @brief Destroy the Result Writer:: Result Writer object
+ *
+ */
+ResultWriter::~ResultWriter()
+{
+	this->close();
+}
+
+/**
+ * @brief Flush the buffer and close the file.
+ *
+ */
+void ResultWriter::close()
+{
+	if (!this->writer.joinable())
+	{
+		return;
+	}
+	this->swap_buffer();
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->closing = true;
+	}
+	this->condition.notify_all();
+	this->writer.join();
+
+	if (!this->close_file() || this->failed)
+	{
+		std::cerr << "[Error] Could not write (" << this->outfile << ")." << std::endl;
+		std::exit(1);
+	}
+}
+
+/**
+ * @brief Output file name with the suffix of the compression format.
+ *
+ * @param outfile Output file
+ * @param compress Compression format (none, gz or zst)
+ * @return Output file name
+ */
+std::string ResultWriter::file_name(const std::string &outfile, const std::string &compress)
+{
+	if (compress.empty() || compress == "none")
+	{
+		return outfile;
+	}
+	return outfile + "." + compress;
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Append bytes to the buffer.
+ *
+ * @param str Bytes
+ * @param length Number of bytes
+ * @return This writer
+ */
+ResultWriter &ResultWriter::append(const char *str, const size_t length)
+{
+	size_t done = 0;
+	while (done < length)
+	{
+		if (this->pos == this->last)
+		{
+			this->swap_buffer();
+		}
+		const size_t n = std::min(length - done, (size_t)(this->last - this->pos));
+		std::memcpy(this->pos, str + done, n);
+		this->pos += n;
+		done += n;
+	}
+	return *this;
+}
+
+/**
+ * @brief Pass the front buffer to the background writer.
+ *
+ */
+void ResultWriter::swap_buffer()
+{
+	const size_t length = this->pos - this->front.data();
+	if (length == 0)
+	{
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->condition.wait(lock, [this]
+							 { return this->backLength == 0; });
+		this->front.swap(this->back);
+		this->backLength = length;
+	}
+	this->condition.notify_all();
+	this->pos = this->front.data();
+	this->last = this->front.data() + this->front.size();
+}
+
+/**
+ * @brief Background writer loop.
+ *
+ */
+void ResultWriter::write_loop()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true)
+	{
+		this->condition.wait(lock, [this]
+							 { return this->backLength > 0 || this->closing; });
+		if (this->backLength == 0)
+		{
+			return;
+		}
+		// The front buffer is not touched while the back buffer is busy.
+		lock.unlock();
+		const bool ok = this->write_file(this->back.data(), this->backLength);
+		lock.lock();
+		this->failed = this->failed || !ok;
+		this->backLength = 0;
+		this->condition.notify_all();
+	}
+}
+
+/**
+ * @brief Write bytes to the file.
+ *
+ * @param data Bytes
+ * @param length Number of bytes
+ * @return true on success
+ */
+bool ResultWriter::write_file(const char *data, const size_t length)
+{
+	if (this->gzipFile)
+	{
+		return gzwrite(this->gzipFile, data, length) == (int)length;
+	}
+#ifdef HAVE_ZSTD
+	if (this->zstdContext)
+	{
+		ZSTD_inBuffer input = {data, length, 0};
+		while (input.pos < input.size)
+		{
+			ZSTD_outBuffer output = {this->zstdBuffer.data(), this->zstdBuffer.size(), 0};
+			if (ZSTD_isError(ZSTD_compressStream2(this->zstdContext, &output, &input, ZSTD_e_continue)) ||
+				fwrite(output.dst, 1, output.pos, this->plainFile) != output.pos)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+#endif
+	return fwrite(data, 1, length, this->plainFile) == length;
+}
+
+/**
+ * @brief Finish the compressed stream and close the file.
+ *
+ * @return true on success
+ */
+bool ResultWriter::close_file()
+{
+	if (this->gzipFile)
+	{
+		return gzclose(this->gzipFile) == Z_OK;
+	}
+	bool ok = true;
+#ifdef HAVE_ZSTD
+	if (this->zstdContext)
+	{
+		ZSTD_inBuffer input = {nullptr, 0, 0};
+		size_t remaining;
+		do
+		{
+			ZSTD_outBuffer output = {this->zstdBuffer.data(), this->zstdBuffer.size(), 0};
+			remaining = ZSTD_compressStream2(this->zstdContext, &output, &input, ZSTD_e_end);
+			ok = ok && !ZSTD_isError(remaining) &&
+				 fwrite(output.dst, 1, output.pos, this->plainFile) == output.pos;
+		} while (ok && remaining > 0);
+		ZSTD_freeCCtx(this->zstdContext);
+	}
+#endif
+	return fclose(this->plainFile) == 0 && ok;
+}
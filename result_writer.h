@@ -0,0 +1,221 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef RESULT_WRITER_H_
+#define RESULT_WRITER_H_
+
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/**
+ * @brief Buffered writer of result files.
+ *
+ * Rows are formatted with std::to_chars into a large buffer. Full buffers are
+ * handed to a background thread which writes (and compresses) them, so that
+ * formatting and I/O overlap. The output format follows the file suffix:
+ * '.gz' is written with zlib, '.zst' with zstd (HAVE_ZSTD builds only) and
+ * anything else as plain text.
+ */
+class ResultWriter
+{
+public:
+	/**
+	 * @brief Construct a new Result Writer object
+	 *
+	 * @param outfile Output file
+	 */
+	ResultWriter(const std::string &outfile);
+
+	/**
+	 * @brief Destroy the Result Writer object
+	 *
+	 */
+	virtual ~ResultWriter();
+
+	/**
+	 * @brief Flush the buffer and close the file.
+	 *
+	 */
+	void close();
+
+	/**
+	 * @brief Output file name with the suffix of the compression format.
+	 *
+	 * @param outfile Output file
+	 * @param compress Compression format (none, gz or zst)
+	 * @return Output file name
+	 */
+	static std::string file_name(const std::string &outfile, const std::string &compress);
+
+	ResultWriter &operator<<(const char c)
+	{
+		this->reserve(1);
+		*this->pos++ = c;
+		return *this;
+	}
+
+	ResultWriter &operator<<(const char *str)
+	{
+		return this->append(str, std::char_traits<char>::length(str));
+	}
+
+	ResultWriter &operator<<(const std::string_view str)
+	{
+		return this->append(str.data(), str.length());
+	}
+
+	/**
+	 * @brief Same text as std::ostream << (float)value (%g, 6 digits).
+	 */
+	ResultWriter &operator<<(const float value)
+	{
+		this->reserve(MAX_NUMBER_LENGTH);
+		this->pos = std::to_chars(this->pos, this->last, value, std::chars_format::general, 6).ptr;
+		return *this;
+	}
+
+	/**
+	 * @brief Same text as std::ostream << value (%g, 6 digits).
+	 */
+	ResultWriter &operator<<(const double value)
+	{
+		this->reserve(MAX_NUMBER_LENGTH);
+		this->pos = std::to_chars(this->pos, this->last, value, std::chars_format::general, 6).ptr;
+		return *this;
+	}
+
+	template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+	ResultWriter &operator<<(const T value)
+	{
+		this->reserve(MAX_NUMBER_LENGTH);
+		this->pos = std::to_chars(this->pos, this->last, value).ptr;
+		return *this;
+	}
+
+private:
+	/**
+	 * @brief Size of a buffer
+	 *
+	 */
+	static constexpr size_t BUFFER_SIZE = 1 << 22;
+
+	/**
+	 * @brief Longest text of a number
+	 *
+	 */
+	static constexpr size_t MAX_NUMBER_LENGTH = 32;
+
+	/**
+	 * @brief Output file
+	 *
+	 */
+	std::string outfile;
+
+	/**
+	 * @brief Plain text file
+	 *
+	 */
+	FILE *plainFile = nullptr;
+
+	/**
+	 * @brief gzip file
+	 *
+	 */
+	gzFile gzipFile = nullptr;
+
+#ifdef HAVE_ZSTD
+	/**
+	 * @brief zstd stream and its output buffer
+	 *
+	 */
+	ZSTD_CCtx *zstdContext = nullptr;
+	std::vector<char> zstdBuffer;
+#endif
+
+	/**
+	 * @brief Buffer being formatted and buffer being written
+	 *
+	 */
+	std::vector<char> front;
+	std::vector<char> back;
+
+	/**
+	 * @brief Write position and end of the front buffer
+	 *
+	 */
+	char *pos;
+	char *last;
+
+	/**
+	 * @brief Number of bytes in the back buffer (0: back buffer is free)
+	 *
+	 */
+	size_t backLength = 0;
+
+	/**
+	 * @brief Background writer
+	 *
+	 */
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool closing = false;
+	bool failed = false;
+
+	ResultWriter &append(const char *str, const size_t length);
+
+	/**
+	 * @brief Make room for the specified number of bytes.
+	 *
+	 * @param length Number of bytes
+	 */
+	void reserve(const size_t length)
+	{
+		if ((size_t)(this->last - this->pos) < length)
+		{
+			this->swap_buffer();
+		}
+	}
+
+	/**
+	 * @brief Pass the front buffer to the background writer.
+	 *
+	 */
+	void swap_buffer();
+
+	/**
+	 * @brief Background writer loop.
+	 *
+	 */
+	void write_loop();
+
+	/**
+	 * @brief Write bytes to the file.
+	 *
+	 * @param data Bytes
+	 * @param length Number of bytes
+	 * @return true on success
+	 */
+	bool write_file(const char *data, const size_t length);
+
+	/**
+	 * @brief Finish the compressed stream and close the file.
+	 *
+	 * @return true on success
+	 */
+	bool close_file();
+};
+#endif /* RESULT_WRITER_H_ */
@@ -0,0 +1,760 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "sample_count.h"
+#include "mer_code.h"
+
+/**
+ * @brief Magic number and version of the count file.
+ *
+ */
+static const char COUNT_MAGIC[8] = {'G', 'E', 'S', 'C', 'N', 'T', '0', '1'};
+static const u_int32_t COUNT_VERSION = 6;
+
+/**
+ * @brief Longest string of a count file (bases on each side with a base other than ACGT).
+ *
+ */
+static const u_int32_t MAX_STRING = 1 << 20;
+
+/**
+ * @brief Entries of an array read or written at once.
+ *
+ */
+static const u_int64_t ARRAY_CHUNK = 1 << 20;
+
+/**
+ * @brief Add counts sorted by their key (operator<) to counts sorted the same way.
+ *
+ * @param counts Counts
+ * @param other Counts to add
+ */
+template <typename Count>
+static void merge_counts(std::vector<Count> &counts, const std::vector<Count> &other)
+{
+	if (counts.empty())
+	{
+		counts = other;
+		return;
+	}
+	std::vector<Count> merged;
+	merged.reserve(counts.size() + other.size());
+	auto itr = counts.begin();
+	auto itr_other = other.begin();
+	while (itr != counts.end() || itr_other != other.end())
+	{
+		if (itr_other == other.end() || (itr != counts.end() && *itr < *itr_other))
+		{
+			merged.push_back(*itr++);
+		}
+		else if (itr == counts.end() || *itr_other < *itr)
+		{
+			merged.push_back(*itr_other++);
+		}
+		else
+		{
+			merged.push_back(*itr++);
+			merged.back().count += (itr_other++)->count;
+		}
+	}
+	counts.swap(merged);
+}
+
+/**
+ * @brief Bases of a side from its 2-bit code.
+ *
+ * @param code Code of the bases
+ * @param length Number of bases
+ * @return Bases
+ */
+static std::string decode_side(const u_int64_t code, const unsigned int length)
+{
+	std::string side(length, 'A');
+	MerCode::decode(code, length, &side[0]);
+	return side;
+}
+
+/**
+ * @brief Size, modification time (ns) and inode of a file.
+ *
+ * @param file File
+ * @param size Size
+ * @param mtime Modification time
+ * @param inode Inode
+ */
+static void file_stat(const std::string &file, u_int64_t &size, u_int64_t &mtime, u_int64_t &inode)
+{
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0)
+	{
+		std::cerr << "[Error] Could not open (" << file << ")." << std::endl;
+		std::exit(1);
+	}
+#ifdef __APPLE__
+	const struct timespec &time = st.st_mtimespec;
+#else
+	const struct timespec &time = st.st_mtim;
+#endif
+	size = st.st_size;
+	mtime = (u_int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+	inode = st.st_ino;
+}
+
+/**
+ * @brief Construct a new Sample Count:: Sample Count object
+ *
+ */
+SampleCount::SampleCount()
+{
+}
+
+/**
+ * @brief Destroy the Sample Count:: Sample Count object
+ *
+ */
+SampleCount::~SampleCount()
+{
+}
+
+/**
+ * @brief Add the counts of another sample.
+ *
+ * @param sampleCount Counts of another sample
+ */
+void SampleCount::merge(const SampleCount &sampleCount)
+{
+	for (auto itr = sampleCount.readLength.begin(); itr != sampleCount.readLength.end(); ++itr)
+	{
+		this->readLength[itr->first] += itr->second;
+	}
+	merge_counts(this->merCounts, sampleCount.merCounts);
+	merge_counts(this->flankCounts, sampleCount.flankCounts);
+	for (auto itr = sampleCount.otherFlankCounts.begin(); itr != sampleCount.otherFlankCounts.end(); ++itr)
+	{
+		this->otherFlankCounts[itr->first] += itr->second;
+	}
+}
+
+/**
+ * @brief Set the counts of a scan.
+ *
+ * @param merIndex Index of the vector mers
+ * @param merCounter Counter of each mer id
+ * @param flankCounter Counter of the bases on each side of each mer id
+ */
+void SampleCount::set_counts(
+	const MerIndex &merIndex, const std::vector<unsigned int> &merCounter,
+	const std::unordered_map<u_int32_t, std::map<std::pair<std::string, std::string>, unsigned int>> &flankCounter)
+{
+	this->merCounts.clear();
+	for (u_int32_t id = 0; id < merCounter.size(); id++)
+	{
+		if (merCounter[id] > 0)
+		{
+			this->merCounts.push_back(MerCount{merIndex.get_codes()[id], id, merCounter[id]});
+		}
+	}
+
+	this->flankCounts.clear();
+	this->otherFlankCounts.clear();
+	for (auto itr = flankCounter.begin(); itr != flankCounter.end(); ++itr)
+	{
+		for (auto itr_flank = itr->second.begin(); itr_flank != itr->second.end(); ++itr_flank)
+		{
+			const std::string &p5 = itr_flank->first.first;
+			const std::string &p3 = itr_flank->first.second;
+			FlankCount flank;
+			if (MerCode::encode(p5, flank.p5) && MerCode::encode(p3, flank.p3))
+			{
+				flank.id = itr->first;
+				flank.count = itr_flank->second;
+				flank.p5_length = p5.length();
+				flank.p3_length = p3.length();
+				this->flankCounts.push_back(flank);
+			}
+			else
+			{
+				this->otherFlankCounts[std::make_pair(itr->first, itr_flank->first)] = itr_flank->second;
+			}
+		}
+	}
+	std::sort(this->flankCounts.begin(), this->flankCounts.end());
+}
+
+/**
+ * @brief Number of reads.
+ *
+ * @return Number of reads of k bases or longer
+ */
+u_int64_t SampleCount::reads() const
+{
+	u_int64_t reads = 0;
+	for (auto itr = this->readLength.begin(); itr != this->readLength.end(); ++itr)
+	{
+		reads += itr->second;
+	}
+	return reads;
+}
+
+/**
+ * @brief Mer total count.
+ *
+ * @param nbase Number of bases on each side (0 for the match analysis)
+ * @return Number of k-mers with nbase bases on both sides in the reads
+ */
+u_int64_t SampleCount::mer_total(const unsigned int nbase) const
+{
+	const unsigned int span = this->kmer + nbase * 2;
+	u_int64_t merTotalCounter = 0;
+	for (auto itr = this->readLength.lower_bound(span); itr != this->readLength.end(); ++itr)
+	{
+		merTotalCounter += (u_int64_t)(itr->first - span + 1) * itr->second;
+	}
+	return merTotalCounter;
+}
+
+/**
+ * @brief Add the mer counts to a counter of the vector mers.
+ *
+ * @param merIndex Index of the vector mers
+ * @param merCounter Counter of each mer id
+ */
+void SampleCount::add_merCounter(const MerIndex &merIndex, std::vector<unsigned int> &merCounter) const
+{
+	for (auto itr = this->merCounts.begin(); itr != this->merCounts.end(); ++itr)
+	{
+		const u_int32_t id = itr->id < merIndex.size() && merIndex.get_codes()[itr->id] == itr->code
+								 ? itr->id
+								 : merIndex.find(itr->code);
+		if (id != MerIndex::NOT_FOUND)
+		{
+			merCounter[id] += itr->count;
+		}
+	}
+}
+
+/**
+ * @brief Add the mer pairs at each end of the target mers.
+ *
+ * @param nbase Number of bases on each side
+ * @param merPair Mer pairs at each end (keys are the target mers)
+ */
+void SampleCount::add_merPair(
+	const unsigned int nbase,
+	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merPair) const
+{
+	// Id of each mer code counted
+	std::unordered_map<u_int64_t, u_int32_t> merIds;
+	for (auto itr = this->merCounts.begin(); itr != this->merCounts.end(); ++itr)
+	{
+		merIds[itr->code] = itr->id;
+	}
+
+	for (auto itr = merPair.begin(); itr != merPair.end(); ++itr)
+	{
+		u_int64_t code;
+		if (!MerCode::encode(itr->first, code) || merIds.count(code) == 0)
+		{
+			continue;
+		}
+		const u_int32_t id = merIds.at(code);
+		auto add = [&](const std::string &p5, const std::string &p3, const unsigned int count)
+		{
+			if (p5.length() >= nbase && p3.length() >= nbase)
+			{
+				const std::pair<std::string, std::string> pair =
+					std::make_pair(p5.substr(p5.length() - nbase), p3.substr(0, nbase));
+				itr->second.insert(itr->second.end(), count, pair);
+			}
+		};
+
+		FlankCount first;
+		first.id = id;
+		first.p5_length = 0;
+		first.p5 = 0;
+		first.p3_length = 0;
+		first.p3 = 0;
+		for (auto itr_flank = std::lower_bound(this->flankCounts.begin(), this->flankCounts.end(), first);
+			 itr_flank != this->flankCounts.end() && itr_flank->id == id; ++itr_flank)
+		{
+			add(decode_side(itr_flank->p5, itr_flank->p5_length), decode_side(itr_flank->p3, itr_flank->p3_length),
+				itr_flank->count);
+		}
+		for (auto itr_flank = this->otherFlankCounts.lower_bound(std::make_pair(id, std::make_pair(std::string(), std::string())));
+			 itr_flank != this->otherFlankCounts.end() && itr_flank->first.first == id; ++itr_flank)
+		{
+			add(itr_flank->first.second.first, itr_flank->first.second.second, itr_flank->second);
+		}
+	}
+}
+
+/**
+ * @brief Save the counts (gzip compressed).
+ *
+ * @param countFile Count file
+ */
+void SampleCount::save(const std::string &countFile) const
+{
+	// Written to a temporary file of this process and renamed, so that a broken
+	// file is never found, even when several runs share the cache directory.
+	static std::atomic<unsigned int> tmpCounter(0);
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	const std::string tmpFile = countFile + ".tmp." + host + "." + std::to_string(getpid()) + "." +
+								std::to_string(tmpCounter++);
+	const int fd = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+	const gzFile file = fd < 0 ? nullptr : gzdopen(fd, "wb1");
+	if (!file)
+	{
+		std::cerr << "[Error] Could not open (" << tmpFile << ")." << std::endl;
+		std::exit(1);
+	}
+	bool ok = true;
+	auto write = [&](const void *data, const size_t length)
+	{
+		ok = ok && (length == 0 || gzwrite(file, data, length) == (int)length);
+	};
+	auto write_u32 = [&](const u_int32_t value)
+	{ write(&value, sizeof(value)); };
+	auto write_u64 = [&](const u_int64_t value)
+	{ write(&value, sizeof(value)); };
+	auto write_str = [&](const std::string &str)
+	{
+		write_u32(str.length());
+		write(str.data(), str.length());
+	};
+	// A field of each count, written in chunks
+	auto write_array = [&](const auto &counts, const auto field)
+	{
+		typedef typename std::decay<decltype(counts.front().*field)>::type Field;
+		std::vector<Field> values;
+		for (size_t i = 0; i < counts.size(); i += ARRAY_CHUNK)
+		{
+			values.clear();
+			for (size_t j = i; j < counts.size() && j < i + ARRAY_CHUNK; j++)
+			{
+				values.push_back(counts[j].*field);
+			}
+			write(values.data(), values.size() * sizeof(Field));
+		}
+	};
+
+	write(COUNT_MAGIC, sizeof(COUNT_MAGIC));
+	write_u32(COUNT_VERSION);
+	write_u32(this->kmer);
+	write_u32(this->bases);
+	write_u32(this->max_read_length);
+	write_u64(this->fingerprint);
+	write_u64(this->vector_hash);
+	write_u32(this->shards);
+	write_u32(this->shardSet.size());
+	for (auto itr = this->shardSet.begin(); itr != this->shardSet.end(); ++itr)
+	{
+		write_u32(*itr);
+	}
+	write_u64(this->offset);
+	write(&this->fraction, sizeof(this->fraction));
+	write_u64(this->file_size);
+	write_u64(this->file_mtime);
+	write_u64(this->file_inode);
+	write_u64(this->content_hash);
+
+	write_u64(this->readLength.size());
+	for (auto itr = this->readLength.begin(); itr != this->readLength.end(); ++itr)
+	{
+		write_u32(itr->first);
+		write_u64(itr->second);
+	}
+
+	// Mers and the bases on each side: one array per field, 2-bit codes (MerCode)
+	write_u64(this->merCounts.size());
+	write_array(this->merCounts, &MerCount::id);
+	write_array(this->merCounts, &MerCount::code);
+	write_array(this->merCounts, &MerCount::count);
+
+	write_u64(this->flankCounts.size());
+	write_array(this->flankCounts, &FlankCount::id);
+	write_array(this->flankCounts, &FlankCount::p5_length);
+	write_array(this->flankCounts, &FlankCount::p3_length);
+	write_array(this->flankCounts, &FlankCount::p5);
+	write_array(this->flankCounts, &FlankCount::p3);
+	write_array(this->flankCounts, &FlankCount::count);
+
+	write_u64(this->otherFlankCounts.size());
+	for (auto itr = this->otherFlankCounts.begin(); itr != this->otherFlankCounts.end(); ++itr)
+	{
+		write_u32(itr->first.first);
+		write_str(itr->first.second.first);
+		write_str(itr->first.second.second);
+		write_u32(itr->second);
+	}
+
+	if (gzclose(file) != Z_OK || !ok || std::rename(tmpFile.c_str(), countFile.c_str()) != 0)
+	{
+		std::remove(tmpFile.c_str());
+		std::cerr << "[Error] Could not write (" << countFile << ")." << std::endl;
+		std::exit(1);
+	}
+}
+
+/**
+ * @brief Load the counts.
+ *
+ * A truncated or broken file is not loaded, so that its counts are made again.
+ *
+ * @param countFile Count file
+ * @return false if the file does not exist, is not a count file or is broken
+ */
+bool SampleCount::load(const std::string &countFile)
+{
+	const gzFile file = gzopen(countFile.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+	gzbuffer(file, 1 << 20);
+	bool ok = true;
+	auto read = [&](void *data, const size_t length)
+	{
+		ok = ok && (length == 0 || gzread(file, data, length) == (int)length);
+	};
+	auto read_u32 = [&]()
+	{
+		u_int32_t value = 0;
+		read(&value, sizeof(value));
+		return value;
+	};
+	auto read_u64 = [&]()
+	{
+		u_int64_t value = 0;
+		read(&value, sizeof(value));
+		return value;
+	};
+	auto read_str = [&]()
+	{
+		// A broken length is not allocated.
+		const u_int32_t length = read_u32();
+		ok = ok && length <= MAX_STRING;
+		std::string str(ok ? length : 0, '\0');
+		read(&str[0], str.length());
+		return str;
+	};
+
+	char magic[sizeof(COUNT_MAGIC)];
+	read(magic, sizeof(magic));
+	const u_int32_t version = ok && memcmp(magic, COUNT_MAGIC, sizeof(COUNT_MAGIC)) == 0 ? read_u32() : 0;
+	// Older versions keep the counts by string: they are counted again.
+	if (!ok || version != COUNT_VERSION)
+	{
+		gzclose(file);
+		return false;
+	}
+	this->kmer = read_u32();
+	this->bases = read_u32();
+	this->max_read_length = read_u32();
+	this->fingerprint = read_u64();
+	this->vector_hash = read_u64();
+	this->shards = read_u32();
+	this->shardSet.clear();
+	for (u_int32_t n = read_u32(); ok && n > 0; n--)
+	{
+		this->shardSet.insert(read_u32());
+	}
+	this->offset = read_u64();
+	read(&this->fraction, sizeof(this->fraction));
+	this->file_size = read_u64();
+	this->file_mtime = read_u64();
+	this->file_inode = read_u64();
+	this->content_hash = read_u64();
+
+	this->readLength.clear();
+	for (u_int64_t n = read_u64(); ok && n > 0; n--)
+	{
+		const unsigned int length = read_u32();
+		this->readLength[length] = read_u64();
+	}
+
+	// A field of each count, read in chunks (a broken number is not allocated at once)
+	auto read_array = [&](auto &counts, const u_int64_t number, const auto field)
+	{
+		typedef typename std::decay<decltype(counts.front().*field)>::type Field;
+		std::vector<Field> values;
+		for (u_int64_t i = 0; ok && i < number; i += ARRAY_CHUNK)
+		{
+			values.resize(std::min(number - i, ARRAY_CHUNK));
+			read(values.data(), values.size() * sizeof(Field));
+			if (ok && counts.size() < i + values.size())
+			{
+				counts.resize(i + values.size());
+			}
+			for (size_t j = 0; ok && j < values.size(); j++)
+			{
+				counts[i + j].*field = values[j];
+			}
+		}
+	};
+
+	this->merCounts.clear();
+	const u_int64_t mers = read_u64();
+	read_array(this->merCounts, mers, &MerCount::id);
+	read_array(this->merCounts, mers, &MerCount::code);
+	read_array(this->merCounts, mers, &MerCount::count);
+
+	this->flankCounts.clear();
+	const u_int64_t flanks = read_u64();
+	read_array(this->flankCounts, flanks, &FlankCount::id);
+	read_array(this->flankCounts, flanks, &FlankCount::p5_length);
+	read_array(this->flankCounts, flanks, &FlankCount::p3_length);
+	read_array(this->flankCounts, flanks, &FlankCount::p5);
+	read_array(this->flankCounts, flanks, &FlankCount::p3);
+	read_array(this->flankCounts, flanks, &FlankCount::count);
+
+	this->otherFlankCounts.clear();
+	for (u_int64_t n = read_u64(); ok && n > 0; n--)
+	{
+		const u_int32_t id = read_u32();
+		const std::string p5 = read_str();
+		const std::string p3 = read_str();
+		this->otherFlankCounts[std::make_pair(id, std::make_pair(p5, p3))] = read_u32();
+	}
+
+	// The counts are sorted, and a side has at most MAX_KMER bases.
+	for (size_t i = 0; ok && i < this->merCounts.size(); i++)
+	{
+		ok = i == 0 || this->merCounts[i - 1] < this->merCounts[i];
+	}
+	for (size_t i = 0; ok && i < this->flankCounts.size(); i++)
+	{
+		const FlankCount &flank = this->flankCounts[i];
+		ok = (i == 0 || this->flankCounts[i - 1] < flank) &&
+			 flank.p5_length <= MerCode::MAX_KMER && flank.p3_length <= MerCode::MAX_KMER;
+	}
+	// The stream ends after the counts (gzread also checks the gzip trailer).
+	char end;
+	ok = ok && gzread(file, &end, 1) == 0;
+	gzclose(file);
+	return ok;
+}
+
+/**
+ * @brief 64-bit hash of bytes.
+ *
+ * @param data Bytes
+ * @param length Number of bytes
+ * @param seed Seed (hash of the preceding bytes)
+ * @return Hash
+ */
+u_int64_t SampleCount::hash(const void *data, const size_t length, u_int64_t seed)
+{
+	const u_int64_t multiplier = 0x9e3779b97f4a7c15ULL;
+	auto mix = [](u_int64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+		return x;
+	};
+
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	u_int64_t h = seed ^ (length * multiplier);
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		u_int64_t word;
+		memcpy(&word, bytes + i, 8);
+		h = (h ^ mix(word)) * multiplier;
+	}
+	u_int64_t tail = 0;
+	for (; i < length; i++)
+	{
+		tail = (tail << 8) | bytes[i];
+	}
+	return mix(h ^ mix(tail));
+}
+
+/**
+ * @brief Set the fingerprint, size, modification time and inode of the FASTQ file.
+ *
+ * @param file FASTQ file
+ */
+void SampleCount::set_file(const std::string &file)
+{
+	file_stat(file, this->file_size, this->file_mtime, this->file_inode);
+	this->fingerprint = file_fingerprint(file);
+}
+
+/**
+ * @brief Whether the counts were made from the same FASTQ file, unchanged.
+ *
+ * @param sampleCount Counts with the file set by set_file
+ * @return true if the size, modification time and inode match
+ */
+bool SampleCount::same_file(const SampleCount &sampleCount) const
+{
+	return this->file_size == sampleCount.file_size && this->file_mtime == sampleCount.file_mtime &&
+		   this->file_inode == sampleCount.file_inode;
+}
+
+/**
+ * @brief Fingerprint of a file: hash of its size, modification time and inode.
+ *
+ * The file is not read: a count file is found without reading the FASTQ
+ * file, and any change of the file (even of the same size) gives another
+ * fingerprint. The hash of the content is kept in the count file.
+ *
+ * @param file File
+ * @return Fingerprint
+ */
+u_int64_t SampleCount::file_fingerprint(const std::string &file)
+{
+	u_int64_t stat[3];
+	file_stat(file, stat[0], stat[1], stat[2]);
+	return hash(stat, sizeof(stat));
+}
+
+/**
+ * @brief Count file of a FASTQ file in the cache directory.
+ *
+ * @param options Execution options.
+ * @param fastqFile FASTQ file
+ * @param vector_hash Hash of the vector sequence
+ * @param kmer K-mer
+ * @return Count file
+ */
+std::string SampleCount::cache_file(const Options *options, const std::string &fastqFile,
+									const u_int64_t vector_hash, const unsigned int kmer)
+{
+	return cache_file(options, file_fingerprint(fastqFile), vector_hash, kmer);
+}
+
+/**
+ * @brief Count file of a FASTQ file fingerprint in the cache directory.
+ *
+ * @param options Execution options.
+ * @param fingerprint Fingerprint of the FASTQ file
+ * @param vector_hash Hash of the vector sequence
+ * @param kmer K-mer
+ * @param shard Shard of the FASTQ file (0: whole file)
+ * @param shards Number of shards
+ * @return Count file
+ */
+std::string SampleCount::cache_file(const Options *options, const u_int64_t fingerprint,
+									const u_int64_t vector_hash, const unsigned int kmer,
+									const unsigned int shard, const unsigned int shards)
+{
+	return options->cache_dir + "/" + count_name(fingerprint, vector_hash, kmer, shard, shards, options->fraction);
+}
+
+/**
+ * @brief Name of a count file.
+ *
+ * @param fingerprint Fingerprint of the FASTQ file
+ * @param vector_hash Hash of the vector sequence
+ * @param kmer K-mer
+ * @param shard Shard of the FASTQ file (0: whole file)
+ * @param shards Number of shards
+ * @param fraction Fraction of the reads counted
+ * @return Count file name (without directory)
+ */
+std::string SampleCount::count_name(const u_int64_t fingerprint, const u_int64_t vector_hash,
+									const unsigned int kmer, const unsigned int shard,
+									const unsigned int shards, const double fraction)
+{
+	std::ostringstream ostr;
+	ostr << std::hex << std::setfill('0')
+		 << std::setw(16) << fingerprint << "-"
+		 << std::setw(16) << vector_hash << std::dec
+		 << "-k" << kmer;
+	if (fraction < 1.0)
+	{
+		ostr << ".f" << fraction;
+	}
+	if (shards > 0)
+	{
+		ostr << ".shard" << shard << "of" << shards;
+	}
+	ostr << ".cnt";
+	return ostr.str();
+}
+
+/**
+ * @brief Add the counts of a partial count file (merge command).
+ *
+ * Shards of the same FASTQ file are joined into the counts of the file once
+ * all of them are added; counts of different files become a merged sample.
+ *
+ * @param sampleCount Counts of a count file
+ * @return Reason why the counts can not be added (empty if they were added)
+ */
+std::string SampleCount::add_partial(const SampleCount &sampleCount)
+{
+	std::ostringstream ostr;
+	if (sampleCount.offset > 0)
+	{
+		ostr << "is the checkpoint of an unfinished scan.";
+		return ostr.str();
+	}
+	if (this->kmer == 0)
+	{
+		*this = sampleCount;
+		return "";
+	}
+	if (sampleCount.kmer != this->kmer || sampleCount.vector_hash != this->vector_hash ||
+		sampleCount.max_read_length != this->max_read_length || sampleCount.fraction != this->fraction)
+	{
+		ostr << "was made with another vector, k-mer, maximum read length or fraction of the reads.";
+		return ostr.str();
+	}
+
+	if (sampleCount.fingerprint == this->fingerprint && this->fingerprint != 0)
+	{
+		// Shards of one FASTQ file
+		if (sampleCount.shards == 0 || sampleCount.shards != this->shards)
+		{
+			ostr << "is another count of the same FASTQ file.";
+			return ostr.str();
+		}
+		for (auto itr = sampleCount.shardSet.begin(); itr != sampleCount.shardSet.end(); ++itr)
+		{
+			if (!this->shardSet.insert(*itr).second)
+			{
+				ostr << "has shard " << *itr << " of " << this->shards << " again.";
+				return ostr.str();
+			}
+		}
+		this->content_hash ^= sampleCount.content_hash;
+		if (this->shardSet.size() == this->shards)
+		{
+			this->shards = 0;
+			this->shardSet.clear();
+		}
+	}
+	else
+	{
+		// Different samples
+		if (this->shards > 0 || sampleCount.shards > 0)
+		{
+			ostr << "has shards of another FASTQ file; merge the shards of each file first.";
+			return ostr.str();
+		}
+		this->fingerprint = 0;
+		this->file_size = 0;
+		this->file_mtime = 0;
+		this->file_inode = 0;
+		this->content_hash = 0;
+	}
+	this->bases = std::min(this->bases, sampleCount.bases);
+	this->merge(sampleCount);
+	return "";
+}
@@ -0,0 +1,284 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef SAMPLE_COUNT_H_
+#define SAMPLE_COUNT_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "options.h"
+#include "mer_index.h"
+
+/**
+ * @brief Vector k-mer counts of a sample (one FASTQ file or a merge of files).
+ *
+ * Holds everything the match and extension analyses need, so that they can be
+ * repeated with other FDR thresholds, fewer bases on each side or another
+ * grouping of the samples without reading the FASTQ files again.
+ */
+class SampleCount
+{
+public:
+	/**
+	 * @brief Construct a new Sample Count object
+	 *
+	 */
+	SampleCount();
+
+	/**
+	 * @brief Destroy the Sample Count object
+	 *
+	 */
+	virtual ~SampleCount();
+
+	// K-mer
+	unsigned int kmer = 0;
+
+	// Number of bases on each side captured in flankCounter
+	unsigned int bases = 0;
+
+	// Maximum read length used for reading the FASTQ file
+	unsigned int max_read_length = 0;
+
+	// Fingerprint of the FASTQ file: hash of its size, modification time and inode (0 for merged counts)
+	u_int64_t fingerprint = 0;
+
+	// Size, modification time (ns) and inode of the FASTQ file; counts are reused only when all match
+	u_int64_t file_size = 0;
+	u_int64_t file_mtime = 0;
+	u_int64_t file_inode = 0;
+
+	// Hash of the FASTQ lines counted (seeded with the shard number; joined shards: XOR of the shards)
+	u_int64_t content_hash = 0;
+
+	// Hash of the vector sequence
+	u_int64_t vector_hash = 0;
+
+	// Number of byte-range shards the FASTQ file was split into (0: whole file)
+	unsigned int shards = 0;
+
+	// Shards in these counts (1 to shards)
+	std::set<unsigned int> shardSet;
+
+	// Fraction of the reads counted (--fraction, 1: all reads)
+	double fraction = 1.0;
+
+	// Bytes of the FASTQ file counted so far (checkpoint of an unfinished scan, 0: finished)
+	u_int64_t offset = 0;
+
+	// Histogram of read lengths (reads of k bases or longer)
+	std::map<unsigned int, u_int64_t> readLength;
+
+	/**
+	 * @brief Count of a vector mer
+	 *
+	 */
+	struct MerCount
+	{
+		// 2-bit code of the mer (MerCode), checks the id
+		u_int64_t code;
+		// Id of the mer in the k-mer index of the vector (vector_hash)
+		u_int32_t id;
+		unsigned int count;
+
+		bool operator<(const MerCount &other) const
+		{
+			return this->id < other.id;
+		}
+	};
+
+	/**
+	 * @brief Count of the bases on each side of a vector mer, 2-bit packed (MerCode)
+	 *
+	 */
+	struct FlankCount
+	{
+		u_int64_t p5;
+		u_int64_t p3;
+		u_int32_t id;
+		unsigned int count;
+		unsigned char p5_length;
+		unsigned char p3_length;
+
+		bool operator<(const FlankCount &other) const
+		{
+			return std::tie(this->id, this->p5_length, this->p5, this->p3_length, this->p3) <
+				   std::tie(other.id, other.p5_length, other.p5, other.p3_length, other.p3);
+		}
+	};
+
+	// Count of each vector mer (non-zero counts only, by id)
+	std::vector<MerCount> merCounts;
+
+	// Counts of the bases on each side of each vector mer (by id and bases). The
+	// sides are clipped at the ends of the read, so they may be shorter than bases.
+	std::vector<FlankCount> flankCounts;
+
+	// Counts of the sides with a base other than ACGT (or longer than a code), by id
+	std::map<std::pair<u_int32_t, std::pair<std::string, std::string>>, unsigned int> otherFlankCounts;
+
+	/**
+	 * @brief Set the counts of a scan.
+	 *
+	 * @param merIndex Index of the vector mers
+	 * @param merCounter Counter of each mer id
+	 * @param flankCounter Counter of the bases on each side of each mer id
+	 */
+	void set_counts(const MerIndex &merIndex, const std::vector<unsigned int> &merCounter,
+					const std::unordered_map<u_int32_t, std::map<std::pair<std::string, std::string>, unsigned int>> &flankCounter);
+
+	/**
+	 * @brief Add the counts of another sample.
+	 *
+	 * @param sampleCount Counts of another sample
+	 */
+	void merge(const SampleCount &sampleCount);
+
+	/**
+	 * @brief Add the counts of a partial count file (merge command).
+	 *
+	 * Shards of the same FASTQ file are joined into the counts of the file once
+	 * all of them are added; counts of different files become a merged sample.
+	 *
+	 * @param sampleCount Counts of a count file
+	 * @return Reason why the counts can not be added (empty if they were added)
+	 */
+	std::string add_partial(const SampleCount &sampleCount);
+
+	/**
+	 * @brief Number of reads.
+	 *
+	 * @return Number of reads of k bases or longer
+	 */
+	u_int64_t reads() const;
+
+	/**
+	 * @brief Mer total count.
+	 *
+	 * @param nbase Number of bases on each side (0 for the match analysis)
+	 * @return Number of k-mers with nbase bases on both sides in the reads
+	 */
+	u_int64_t mer_total(const unsigned int nbase) const;
+
+	/**
+	 * @brief Add the mer counts to a counter of the vector mers.
+	 *
+	 * The ids are used when the code of the id in the index matches (the
+	 * same vector gives the same ids); otherwise the code is looked up.
+	 *
+	 * @param merIndex Index of the vector mers
+	 * @param merCounter Counter of each mer id
+	 */
+	void add_merCounter(const MerIndex &merIndex, std::vector<unsigned int> &merCounter) const;
+
+	/**
+	 * @brief Add the mer pairs at each end of the target mers.
+	 *
+	 * @param nbase Number of bases on each side
+	 * @param merPair Mer pairs at each end (keys are the target mers)
+	 */
+	void add_merPair(const unsigned int nbase,
+					 std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &merPair) const;
+
+	/**
+	 * @brief Save the counts (gzip compressed).
+	 *
+	 * @param countFile Count file
+	 */
+	void save(const std::string &countFile) const;
+
+	/**
+	 * @brief Load the counts.
+	 *
+	 * A truncated or broken file is not loaded, so that its counts are made again.
+	 *
+	 * @param countFile Count file
+	 * @return false if the file does not exist, is not a count file or is broken
+	 */
+	bool load(const std::string &countFile);
+
+	/**
+	 * @brief 64-bit hash of bytes.
+	 *
+	 * @param data Bytes
+	 * @param length Number of bytes
+	 * @param seed Seed (hash of the preceding bytes)
+	 * @return Hash
+	 */
+	static u_int64_t hash(const void *data, const size_t length, u_int64_t seed = 0);
+
+	/**
+	 * @brief Set the fingerprint, size, modification time and inode of the FASTQ file.
+	 *
+	 * @param file FASTQ file
+	 */
+	void set_file(const std::string &file);
+
+	/**
+	 * @brief Whether the counts were made from the same FASTQ file, unchanged.
+	 *
+	 * @param sampleCount Counts with the file set by set_file
+	 * @return true if the size, modification time and inode match
+	 */
+	bool same_file(const SampleCount &sampleCount) const;
+
+	/**
+	 * @brief Fingerprint of a file: hash of its size, modification time and inode.
+	 *
+	 * @param file File
+	 * @return Fingerprint
+	 */
+	static u_int64_t file_fingerprint(const std::string &file);
+
+	/**
+	 * @brief Count file of a FASTQ file in the cache directory.
+	 *
+	 * The name is made of the file fingerprint, the vector hash and k.
+	 *
+	 * @param options Execution options.
+	 * @param fastqFile FASTQ file
+	 * @param vector_hash Hash of the vector sequence
+	 * @param kmer K-mer
+	 * @return Count file
+	 */
+	static std::string cache_file(const Options *options, const std::string &fastqFile,
+								  const u_int64_t vector_hash, const unsigned int kmer);
+
+	/**
+	 * @brief Count file of a FASTQ file fingerprint in the cache directory.
+	 *
+	 * Counts of a subsample (--fraction) are kept apart from the counts of all reads.
+	 *
+	 * @param options Execution options.
+	 * @param fingerprint Fingerprint of the FASTQ file
+	 * @param vector_hash Hash of the vector sequence
+	 * @param kmer K-mer
+	 * @param shard Shard of the FASTQ file (0: whole file)
+	 * @param shards Number of shards
+	 * @return Count file
+	 */
+	static std::string cache_file(const Options *options, const u_int64_t fingerprint,
+								  const u_int64_t vector_hash, const unsigned int kmer,
+								  const unsigned int shard = 0, const unsigned int shards = 0);
+
+	/**
+	 * @brief Name of a count file.
+	 *
+	 * @param fingerprint Fingerprint of the FASTQ file
+	 * @param vector_hash Hash of the vector sequence
+	 * @param kmer K-mer
+	 * @param shard Shard of the FASTQ file (0: whole file)
+	 * @param shards Number of shards
+	 * @param fraction Fraction of the reads counted
+	 * @return Count file name (without directory)
+	 */
+	static std::string count_name(const u_int64_t fingerprint, const u_int64_t vector_hash,
+								  const unsigned int kmer, const unsigned int shard = 0,
+								  const unsigned int shards = 0, const double fraction = 1.0);
+};
+#endif /* SAMPLE_COUNT_H_ */
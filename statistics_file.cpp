@@ -2,7 +2,6 @@
  * GenEditScan
  * Copyright 2018 National Agriculture and Food Research Organization (NARO)
  */
-#include <fstream>
 #include <algorithm>
 #include "statistics_file.h"
 #include "complementary.h"
@@ -11,10 +10,14 @@
  * @brief Construct a new StatisticsFile:: StatisticsFile object
  *
  * @param options Execution options.
+ * @param vector_name Name of the vector
+ * @param out_prefix Output prefix of this vector
  */
-StatisticsFile::StatisticsFile(Options *options)
+StatisticsFile::StatisticsFile(Options *options, const std::string &vector_name, const std::string &out_prefix)
 {
 	this->options = options;
+	this->vector_name = vector_name;
+	this->out_prefix = out_prefix;
 	this->gtest = new Gtest(this->options);
 }
 
@@ -32,18 +35,23 @@ StatisticsFile::~StatisticsFile()
  */
 void StatisticsFile::create_statisticsFile() const
 {
-	const std::string statisticsTxt = this->options->out_prefix + ".statistics.txt";
-	std::ofstream ofs(statisticsTxt.c_str());
-	if (!ofs)
+	// Calculate G-value for k-mer match analysis.
+	this->gtest->kmer_match(this->mutantPosFreq, this->wildTypePosFreq);
+
+	Metrics::Stopwatch write;
+	Trace::Span writeSpan(this->options->trace, "write", this->out_prefix + ".statistics");
+	if (this->options->binary)
 	{
-		std::cerr << "[Error] Could not open (" << statisticsTxt << ")." << std::endl;
-		std::exit(1);
+		this->create_statisticsBinary();
+		this->options->metrics.add_written(this->out_prefix + ".statistics.gesc", write);
+		return;
 	}
-	ofs << "#K-mer\t" << this->options->kmer << std::endl;
-	ofs << "#Pos\tSeq\tMutant\tWildType\tGval\tPval\tFDR\tBonferroni\n";
 
-	// Calculate G-value for k-mer match analysis.
-	this->gtest->kmer_match(this->mutantPosFreq, this->wildTypePosFreq);
+	const std::string statisticsTxt = ResultWriter::file_name(
+		this->out_prefix + ".statistics.txt", this->options->compress);
+	ResultWriter ofs(statisticsTxt);
+	ofs << "#K-mer\t" << this->options->kmer << '\n';
+	ofs << "#Pos\tSeq\tMutant\tWildType\tGval\tPval\tFDR\tBonferroni\n";
 
 	//========== Output ==========//
 	for (size_t i = 0; i < this->mutantPosFreq.size(); i++)
@@ -52,12 +60,13 @@ void StatisticsFile::create_statisticsFile() const
 			<< this->vectorArray[i] << "\t"
 			<< this->mutantPosFreq[i] << "\t"
 			<< this->wildTypePosFreq[i] << "\t"
-			<< (float)this->gtest->get_gval()[i] << "\t"
-			<< (float)this->gtest->get_pval()[i] << "\t"
-			<< (float)this->gtest->get_fdr()[i] << "\t"
-			<< (float)this->gtest->get_bon()[i] << std::endl;
+			<< (float)this->gtest->get_gval().at(i) << "\t"
+			<< (float)this->gtest->get_pval().at(i) << "\t"
+			<< (float)this->gtest->get_fdr().at(i) << "\t"
+			<< (float)this->gtest->get_bon().at(i) << '\n';
 	}
 	ofs.close();
+	this->options->metrics.add_written(statisticsTxt, write);
 }
 
 /**
@@ -77,19 +86,34 @@ void StatisticsFile::create_outsideFile(
 		fdr_str.pop_back();
 	}
 
-	const std::string outsideFile = this->options->out_prefix + ".outside.txt";
-	std::ofstream ofs(outsideFile.c_str());
-	if (!ofs)
-	{
-		std::cerr << "[Error] Could not open (" << outsideFile << ")." << std::endl;
-		std::exit(1);
-	}
-
+	Metrics::Stopwatch outside;
+	Trace::Span outsideSpan(this->options->trace, "outside");
 	auto [number_of_extensions, table_size, outsideData] = this->create_outsideData(mutantMerPair, wildTypeMerPair);
+	Metrics::Counters counters;
+	this->options->metrics.add("outside", "", outside.stop(counters));
+	outsideSpan.stop();
 
 	// Calculate FDR using the Benjamini-Hochberg method.
+	Metrics::Stopwatch fdr;
+	Trace::Span fdrSpan(this->options->trace, "fdr");
 	std::unordered_map<unsigned int, std::unordered_map<unsigned int, double>>
 		fdr_extension = this->gtest->fdr_extension(outsideData.pval);
+	Metrics::Counters fdrCounters;
+	this->options->metrics.add("fdr", "", fdr.stop(fdrCounters));
+	fdrSpan.stop();
+
+	Metrics::Stopwatch write;
+	Trace::Span writeSpan(this->options->trace, "write", this->out_prefix + ".outside");
+	if (this->options->binary)
+	{
+		this->create_outsideBinary(number_of_extensions, table_size, outsideData, fdr_extension);
+		this->options->metrics.add_written(this->out_prefix + ".outside.gesc", write);
+		return;
+	}
+
+	const std::string outsideFile = ResultWriter::file_name(
+		this->out_prefix + ".outside.txt", this->options->compress);
+	ResultWriter ofs(outsideFile);
 
 	ofs << "#K-mer\t"
 		<< this->options->kmer
@@ -97,23 +121,23 @@ void StatisticsFile::create_outsideFile(
 		<< this->options->threshold_fdr
 		<< "\tBases\t"
 		<< this->options->bases_on_each_side
-		<< std::endl;
+		<< '\n';
 
 	for (unsigned i = 0; i < this->vectorArray.length() - this->options->kmer; i++)
 	{
 		std::string kmer = this->vectorArray.substr(i, this->options->kmer);
-		if (this->gtest->get_fdr()[i] <= this->options->threshold_fdr)
+		if (this->gtest->get_fdr().at(i) <= this->options->threshold_fdr)
 		{
 			ofs << i + 1 << "\t"
 				<< table_size[i] << "\t"
 				<< kmer << "\t"
 				<< this->mutantPosFreq[i] << "\t"
 				<< this->wildTypePosFreq[i] << "\t"
-				<< (float)this->gtest->get_gval()[i] << "\t"
-				<< (float)this->gtest->get_pval()[i] << "\t"
-				<< (float)this->gtest->get_fdr()[i] << "\t"
-				<< (float)this->gtest->get_bon()[i]
-				<< std::endl;
+				<< (float)this->gtest->get_gval().at(i) << "\t"
+				<< (float)this->gtest->get_pval().at(i) << "\t"
+				<< (float)this->gtest->get_fdr().at(i) << "\t"
+				<< (float)this->gtest->get_bon().at(i)
+				<< '\n';
 
 			for (size_t j = 0; j < outsideData.left_chain[i].size(); j++)
 			{
@@ -128,16 +152,193 @@ void StatisticsFile::create_outsideFile(
 					<< (float)outsideData.pval[i][j] << "\t"
 					<< (float)fdr_extension[i][j] << "\t"
 					<< (float)std::min(outsideData.pval[i][j] * number_of_extensions, 1.0)
-					<< std::endl;
+					<< '\n';
 			}
 		}
 	}
 	ofs.close();
+	this->options->metrics.add_written(outsideFile, write);
+}
+
+/**
+ * @brief Write the summary line of this vector to the elements.txt file.
+ *
+ * @param ofs elements.txt file
+ * @param shared Number of positions whose k-mer is also in another vector
+ */
+void StatisticsFile::write_element(ResultWriter &ofs, const unsigned int shared) const
+{
+	const std::vector<double> &gval = this->gtest->get_gval();
+	const std::vector<double> &fdr = this->gtest->get_fdr();
+	unsigned int detected = 0;
+	unsigned int mutant_max = 0;
+	unsigned int wildType_max = 0;
+	double gval_max = 0.0;
+	double fdr_min = 1.0;
+	for (size_t i = 0; i < this->mutantPosFreq.size(); i++)
+	{
+		if (fdr.at(i) <= this->options->threshold_fdr)
+		{
+			detected++;
+		}
+		mutant_max = std::max(mutant_max, this->mutantPosFreq[i]);
+		wildType_max = std::max(wildType_max, this->wildTypePosFreq[i]);
+		gval_max = std::max(gval_max, gval.at(i));
+		fdr_min = std::min(fdr_min, fdr.at(i));
+	}
+
+	ofs << this->vector_name << "\t"
+		<< this->mutantPosFreq.size() << "\t"
+		<< shared << "\t"
+		<< detected << "\t"
+		<< mutant_max << "\t"
+		<< wildType_max << "\t"
+		<< (float)gval_max << "\t"
+		<< (float)fdr_min << '\n';
+}
+
+/**
+ * @brief Add the "meta" table (settings as text) to a columnar file.
+ *
+ * @param writer Columnar file
+ * @param type File type (statistics, outside or merFreq)
+ */
+void StatisticsFile::add_metaTable(ColumnarWriter &writer, const std::string &type) const
+{
+	std::ostringstream fdr;
+	fdr << this->options->threshold_fdr;
+	writer.add_table("meta", 4);
+	writer.add_column("key", std::vector<std::string>{"type", "kmer", "fdr", "bases"});
+	writer.add_column("value", std::vector<std::string>{
+								   type, std::to_string(this->options->kmer), fdr.str(),
+								   std::to_string(this->options->bases_on_each_side)});
 }
 
 //============================================================================//
 // Private function
 //============================================================================//
+/**
+ * @brief Create the statistics.gesc file (binary columnar format).
+ *
+ */
+void StatisticsFile::create_statisticsBinary() const
+{
+	const std::vector<double> &gval = this->gtest->get_gval();
+	const std::vector<double> &pval = this->gtest->get_pval();
+	const std::vector<double> &fdr = this->gtest->get_fdr();
+	const std::vector<double> &bon = this->gtest->get_bon();
+	const size_t rows = this->mutantPosFreq.size();
+
+	std::vector<u_int32_t> pos_column(rows);
+	std::vector<std::string> seq_column(rows);
+	std::vector<double> gval_column(rows), pval_column(rows), fdr_column(rows), bon_column(rows);
+	for (size_t i = 0; i < rows; i++)
+	{
+		pos_column[i] = i + 1;
+		seq_column[i] = this->vectorArray[i];
+		gval_column[i] = gval.at(i);
+		pval_column[i] = pval.at(i);
+		fdr_column[i] = fdr.at(i);
+		bon_column[i] = bon.at(i);
+	}
+
+	ColumnarWriter writer(this->out_prefix + ".statistics.gesc");
+	this->add_metaTable(writer, "statistics");
+	writer.add_table("statistics", rows);
+	writer.add_column("pos", pos_column);
+	writer.add_column("seq", seq_column);
+	writer.add_column("mutant", this->mutantPosFreq);
+	writer.add_column("wildtype", this->wildTypePosFreq);
+	writer.add_column("gval", gval_column);
+	writer.add_column("pval", pval_column);
+	writer.add_column("fdr", fdr_column);
+	writer.add_column("bonferroni", bon_column);
+	writer.close();
+}
+
+/**
+ * @brief Create the outside.gesc file (binary columnar format).
+ *
+ * @param number_of_extensions Number of outside data
+ * @param table_size Number of outside data per k-mer
+ * @param outsideData Outside data
+ * @param fdr_extension FDR of outside data
+ */
+void StatisticsFile::create_outsideBinary(
+	const unsigned int number_of_extensions,
+	std::unordered_map<unsigned int, size_t> &table_size, OutsideData &outsideData,
+	std::unordered_map<unsigned int, std::unordered_map<unsigned int, double>> &fdr_extension) const
+{
+	const std::vector<double> &gval = this->gtest->get_gval();
+	const std::vector<double> &pval = this->gtest->get_pval();
+	const std::vector<double> &fdr = this->gtest->get_fdr();
+	const std::vector<double> &bon = this->gtest->get_bon();
+
+	// K-mer table
+	std::vector<u_int32_t> pos_column, mutant_column, wildType_column;
+	std::vector<u_int64_t> size_column;
+	std::vector<std::string> mer_column;
+	std::vector<double> gval_column, pval_column, fdr_column, bon_column;
+
+	// Flank table
+	std::vector<u_int32_t> flank_pos_column, flank_mutant_column, flank_wildType_column;
+	std::vector<std::string> left_column, right_column;
+	std::vector<double> flank_gval_column, flank_pval_column, flank_fdr_column, flank_bon_column;
+
+	for (unsigned i = 0; i < this->vectorArray.length() - this->options->kmer; i++)
+	{
+		if (fdr.at(i) <= this->options->threshold_fdr)
+		{
+			pos_column.push_back(i + 1);
+			size_column.push_back(table_size[i]);
+			mer_column.push_back(this->vectorArray.substr(i, this->options->kmer));
+			mutant_column.push_back(this->mutantPosFreq[i]);
+			wildType_column.push_back(this->wildTypePosFreq[i]);
+			gval_column.push_back(gval.at(i));
+			pval_column.push_back(pval.at(i));
+			fdr_column.push_back(fdr.at(i));
+			bon_column.push_back(bon.at(i));
+
+			for (size_t j = 0; j < outsideData.left_chain[i].size(); j++)
+			{
+				flank_pos_column.push_back(i + 1);
+				left_column.push_back(outsideData.left_chain[i][j]);
+				right_column.push_back(outsideData.right_chain[i][j]);
+				flank_mutant_column.push_back(outsideData.mutant_count[i][j]);
+				flank_wildType_column.push_back(outsideData.wildType_count[i][j]);
+				flank_gval_column.push_back(outsideData.gval[i][j]);
+				flank_pval_column.push_back(outsideData.pval[i][j]);
+				flank_fdr_column.push_back(fdr_extension[i][j]);
+				flank_bon_column.push_back(std::min(outsideData.pval[i][j] * number_of_extensions, 1.0));
+			}
+		}
+	}
+
+	ColumnarWriter writer(this->out_prefix + ".outside.gesc");
+	this->add_metaTable(writer, "outside");
+	writer.add_table("kmer", pos_column.size());
+	writer.add_column("pos", pos_column);
+	writer.add_column("table_size", size_column);
+	writer.add_column("mer", mer_column);
+	writer.add_column("mutant", mutant_column);
+	writer.add_column("wildtype", wildType_column);
+	writer.add_column("gval", gval_column);
+	writer.add_column("pval", pval_column);
+	writer.add_column("fdr", fdr_column);
+	writer.add_column("bonferroni", bon_column);
+	writer.add_table("flank", flank_pos_column.size());
+	writer.add_column("pos", flank_pos_column);
+	writer.add_column("left", left_column);
+	writer.add_column("right", right_column);
+	writer.add_column("mutant", flank_mutant_column);
+	writer.add_column("wildtype", flank_wildType_column);
+	writer.add_column("gval", flank_gval_column);
+	writer.add_column("pval", flank_pval_column);
+	writer.add_column("fdr", flank_fdr_column);
+	writer.add_column("bonferroni", flank_bon_column);
+	writer.close();
+}
+
 /**
  * @brief Create outside data.
  *
@@ -162,10 +363,10 @@ std::tuple<unsigned int, std::unordered_map<unsigned int, size_t>, OutsideData>
 
 	for (size_t i = 0; i < this->vectorArray.length() - this->options->kmer; i++)
 	{
-		if (this->gtest->get_fdr()[i] <= this->options->threshold_fdr)
+		if (this->gtest->get_fdr().at(i) <= this->options->threshold_fdr)
 		{
-			const std::string mer_plus = this->vectorPosPair.at(i).first;
-			const std::string mer_minus = this->vectorPosPair.at(i).second;
+			const std::string mer_plus = this->vectorArray.substr(i, this->options->kmer);
+			const std::string mer_minus = complementary.mer(mer_plus);
 
 			std::map<std::pair<std::string, std::string>, unsigned int> mutant_side_pair_count;
 			std::map<std::pair<std::string, std::string>, unsigned int> wildType_side_pair_count;
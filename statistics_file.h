@@ -8,7 +8,10 @@
 #include <map>
 #include <tuple>
 #include "gtest.h"
+#include "mer_index.h"
 #include "outside_data.h"
+#include "columnar_file.h"
+#include "result_writer.h"
 
 /**
  * @brief Create statistics files.
@@ -21,8 +24,10 @@ public:
 	 * @brief Construct a new StatisticsFile object
 	 *
 	 * @param optios Execution options.
+	 * @param vector_name Name of the vector
+	 * @param out_prefix Output prefix of this vector
 	 */
-	StatisticsFile(Options *optios);
+	StatisticsFile(Options *optios, const std::string &vector_name, const std::string &out_prefix);
 
 	/**
 	 * @brief Destroy the StatisticsFile object
@@ -58,6 +63,14 @@ public:
 		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &mutantMerPair,
 		const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &wildTypeMerPair) const;
 
+	/**
+	 * @brief Write the summary line of this vector to the elements.txt file.
+	 *
+	 * @param ofs elements.txt file
+	 * @param shared Number of positions whose k-mer is also in another vector
+	 */
+	void write_element(ResultWriter &ofs, const unsigned int shared) const;
+
 	// Setter / Getter
 
 	void set_vectorArray(const std::string &vectorArray)
@@ -70,15 +83,14 @@ public:
 		return this->vectorArray;
 	}
 
-	void set_vectorPosPair(
-		const std::unordered_map<unsigned int, std::pair<std::string, std::string>> &vectorPosPair)
+	void set_vectorPosIds(PositionIds &vectorPosIds)
 	{
-		this->vectorPosPair = vectorPosPair;
+		this->vectorPosIds.swap(vectorPosIds);
 	}
 
-	std::unordered_map<unsigned int, std::pair<std::string, std::string>> get_vectorPosPair() const
+	const PositionIds &get_vectorPosIds() const
 	{
-		return this->vectorPosPair;
+		return this->vectorPosIds;
 	}
 
 	void set_mutantPosFreq(const std::vector<unsigned int> &mutantPosFreq)
@@ -91,11 +103,19 @@ public:
 		this->wildTypePosFreq = posFreq;
 	}
 
-	std::unordered_map<unsigned int, double> get_fdr() const
+	const std::vector<double> &get_fdr() const
 	{
 		return this->gtest->get_fdr();
 	};
 
+	/**
+	 * @brief Add the "meta" table (settings as text) to a columnar file.
+	 *
+	 * @param writer Columnar file
+	 * @param type File type (statistics, outside or merFreq)
+	 */
+	void add_metaTable(ColumnarWriter &writer, const std::string &type) const;
+
 private:
 	/**
 	 * @brief Execution options.
@@ -103,6 +123,18 @@ private:
 	 */
 	Options *options;
 
+	/**
+	 * @brief Name of the vector
+	 *
+	 */
+	std::string vector_name;
+
+	/**
+	 * @brief Output prefix of this vector
+	 *
+	 */
+	std::string out_prefix;
+
 	/**
 	 * @brief Run the G-test.
 	 *
@@ -116,10 +148,10 @@ private:
 	std::string vectorArray;
 
 	/**
-	 * @brief Position and k-mer complementary pair on vector
+	 * @brief Ids of the k-mer and its complementary k-mer at each position on vector
 	 *
 	 */
-	std::unordered_map<unsigned int, std::pair<std::string, std::string>> vectorPosPair;
+	PositionIds vectorPosIds;
 
 	/**
 	 * @brief Position frequency of mutant
@@ -133,6 +165,25 @@ private:
 	 */
 	std::vector<unsigned int> wildTypePosFreq;
 
+	/**
+	 * @brief Create the statistics.gesc file (binary columnar format).
+	 *
+	 */
+	void create_statisticsBinary() const;
+
+	/**
+	 * @brief Create the outside.gesc file (binary columnar format).
+	 *
+	 * @param number_of_extensions Number of outside data
+	 * @param table_size Number of outside data per k-mer
+	 * @param outsideData Outside data
+	 * @param fdr_extension FDR of outside data
+	 */
+	void create_outsideBinary(
+		const unsigned int number_of_extensions,
+		std::unordered_map<unsigned int, size_t> &table_size, OutsideData &outsideData,
+		std::unordered_map<unsigned int, std::unordered_map<unsigned int, double>> &fdr_extension) const;
+
 	/**
 	 * @brief Create outside data.
 	 *
@@ -0,0 +1,111 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <unistd.h>
+#include "metrics.h"
+#include "trace.h"
+
+/**
+ * @brief Construct a new Trace:: Trace object
+ *
+ */
+Trace::Trace()
+{
+	this->enabled = false;
+	this->start_time = Metrics::wall_time();
+}
+
+/**
+ * @brief Destroy the Trace:: Trace object
+ *
+ */
+Trace::~Trace()
+{
+}
+
+/**
+ * @brief Add an event of the calling thread (thread safe).
+ *
+ * @param name Event name
+ * @param file File of the event (empty: none)
+ * @param begin Start (microseconds)
+ * @param end End (microseconds)
+ */
+void Trace::add(const char *name, const std::string &file, const double begin, const double end)
+{
+	const unsigned int thread = thread_number();
+	const std::lock_guard<std::mutex> lock(this->mutex);
+	this->events.push_back(Event{name, file, begin, end, thread});
+}
+
+/**
+ * @brief Write the trace file.
+ *
+ * Each event is a complete event ("ph": "X") of its thread; the threads
+ * are named by their number.
+ *
+ * @param traceFile Output file (JSON)
+ */
+void Trace::write(const std::string &traceFile) const
+{
+	const std::lock_guard<std::mutex> lock(this->mutex);
+	std::ofstream ofs(traceFile);
+	if (!ofs)
+	{
+		std::cerr << "[Error] Could not open (" << traceFile << ")." << std::endl;
+		std::exit(1);
+	}
+
+	const pid_t pid = getpid();
+	std::set<unsigned int> threads;
+	ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	ofs << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+		<< ", \"tid\": 0, \"args\": {\"name\": \"geneditscan\"}}";
+	for (const Event &event : this->events)
+	{
+		if (threads.insert(event.thread).second)
+		{
+			ofs << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << event.thread
+				<< ", \"args\": {\"name\": \"thread " << event.thread << "\"}}";
+		}
+		ofs << ",\n{\"name\": " << Metrics::json_string(event.name) << ", \"ph\": \"X\", \"pid\": " << pid
+			<< ", \"tid\": " << event.thread << ", \"ts\": " << (u_int64_t)event.begin
+			<< ", \"dur\": " << (u_int64_t)(event.end - event.begin);
+		if (!event.file.empty())
+		{
+			ofs << ", \"args\": {\"file\": " << Metrics::json_string(event.file) << "}";
+		}
+		ofs << "}";
+	}
+	ofs << "\n]}\n";
+}
+
+//============================================================================//
+// Private function
+//============================================================================//
+/**
+ * @brief Microseconds since the construction.
+ *
+ * @return Microseconds
+ */
+double Trace::now() const
+{
+	return (Metrics::wall_time() - this->start_time) * 1e6;
+}
+
+/**
+ * @brief Number of the calling thread (1, 2, ... in the order of the first event).
+ *
+ * @return Thread number
+ */
+unsigned int Trace::thread_number()
+{
+	static std::atomic<unsigned int> threads(0);
+	thread_local const unsigned int number = ++threads;
+	return number;
+}
@@ -0,0 +1,155 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timeline of the phases of each thread (--trace, Chrome trace-event format).
+ *
+ * The file opens in chrome://tracing or https://ui.perfetto.dev. Nothing is
+ * recorded unless the trace is enabled.
+ */
+class Trace
+{
+public:
+	/**
+	 * @brief Event of the calling thread from start to stop (or destruction).
+	 *
+	 */
+	class Span
+	{
+	public:
+		/**
+		 * @brief Construct a new Span object
+		 *
+		 * @param trace Trace
+		 * @param name Event name (read, scan, wait <critical>, merge, gtest, ...)
+		 * @param file File of the event (empty: none)
+		 * @param running Start at once
+		 */
+		Span(Trace &trace, const char *name, const std::string &file = "", const bool running = true)
+			: trace(trace), name(name)
+		{
+			if (trace.enabled)
+			{
+				this->file = file;
+				if (running)
+				{
+					this->start();
+				}
+			}
+		}
+
+		/**
+		 * @brief Destroy the Span object (stops it)
+		 *
+		 */
+		~Span()
+		{
+			this->stop();
+		}
+
+		void start()
+		{
+			if (this->trace.enabled)
+			{
+				this->begin = this->trace.now();
+				this->running = true;
+			}
+		}
+
+		void stop()
+		{
+			if (this->running)
+			{
+				this->trace.add(this->name, this->file, this->begin, this->trace.now());
+				this->running = false;
+			}
+		}
+
+	private:
+		Trace &trace;
+		const char *name;
+		std::string file;
+		double begin = 0.0;
+		bool running = false;
+	};
+
+	/**
+	 * @brief Construct a new Trace object
+	 *
+	 */
+	Trace();
+
+	/**
+	 * @brief Destroy the Trace object
+	 *
+	 */
+	virtual ~Trace();
+
+	/**
+	 * @brief Start recording the events.
+	 *
+	 */
+	void enable()
+	{
+		this->enabled = true;
+	}
+
+	/**
+	 * @brief Add an event of the calling thread (thread safe).
+	 *
+	 * @param name Event name
+	 * @param file File of the event (empty: none)
+	 * @param begin Start (microseconds)
+	 * @param end End (microseconds)
+	 */
+	void add(const char *name, const std::string &file, const double begin, const double end);
+
+	/**
+	 * @brief Write the trace file.
+	 *
+	 * @param traceFile Output file (JSON)
+	 */
+	void write(const std::string &traceFile) const;
+
+private:
+	/**
+	 * @brief Event of a thread
+	 *
+	 */
+	struct Event
+	{
+		const char *name;
+		std::string file;
+		double begin;
+		double end;
+		unsigned int thread;
+	};
+
+	/**
+	 * @brief Microseconds since the construction.
+	 *
+	 * @return Microseconds
+	 */
+	double now() const;
+
+	/**
+	 * @brief Number of the calling thread (1, 2, ... in the order of the first event).
+	 *
+	 * @return Thread number
+	 */
+	static unsigned int thread_number();
+
+	bool enabled;
+	double start_time;
+	std::vector<Event> events;
+	mutable std::mutex mutex;
+};
+#endif /* TRACE_H_ */
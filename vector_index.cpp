@@ -0,0 +1,297 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "vector_index.h"
+#include "mer_code.h"
+
+/**
+ * @brief Magic number and version of the index file.
+ *
+ */
+static const char INDEX_MAGIC[8] = {'G', 'E', 'S', 'I', 'D', 'X', '0', '2'};
+
+/**
+ * @brief Bytes of the magic number shared by all versions of the index file.
+ *
+ */
+static const size_t INDEX_PREFIX = 6;
+
+/**
+ * @brief Largest number of slot bits of an index file.
+ *
+ */
+static const u_int32_t MAX_SLOT_BITS = 40;
+static const u_int32_t INDEX_VERSION = 2;
+
+/**
+ * @brief Header of the index file.
+ *
+ */
+struct IndexHeader
+{
+	char magic[8];
+	u_int32_t version;
+	u_int32_t kmer;
+	u_int32_t layout;
+	u_int32_t slotBits;
+	u_int64_t number;
+	u_int64_t records;
+	u_int64_t recordOffset;
+	u_int64_t codeOffset;
+	u_int64_t slotOffset;
+	u_int64_t filterOffset;
+	u_int64_t positionOffset;
+};
+
+/**
+ * @brief Construct a new Vector Index:: Vector Index object (map an index file)
+ *
+ * @param indexFile Index file
+ */
+VectorIndex::VectorIndex(const std::string &indexFile)
+{
+	this->indexFile = indexFile;
+	const int fd = open(indexFile.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		std::cerr << "[Error] Could not open (" << indexFile << ")." << std::endl;
+		std::exit(1);
+	}
+	this->length = st.st_size;
+	void *addr = this->length > 0 ? mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	::close(fd);
+	this->map = static_cast<const char *>(addr);
+
+	IndexHeader header;
+	if (addr == MAP_FAILED || this->length < sizeof(header))
+	{
+		std::cerr << "[Error] Not a GenEditScan vector index (" << indexFile << ")." << std::endl;
+		std::exit(1);
+	}
+	memcpy(&header, this->map, sizeof(header));
+	if (memcmp(header.magic, INDEX_MAGIC, INDEX_PREFIX) != 0)
+	{
+		std::cerr << "[Error] Not a GenEditScan vector index (" << indexFile << ")." << std::endl;
+		std::exit(1);
+	}
+	if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+		header.layout != MerIndex::LAYOUT)
+	{
+		std::cerr << "[Error] Unsupported vector index version " << std::string(header.magic, sizeof(header.magic))
+				  << " " << header.version << "." << header.layout << " (" << indexFile
+				  << "). Rebuild it with the index command." << std::endl;
+		std::exit(1);
+	}
+
+	auto broken = [&]()
+	{
+		std::cerr << "[Error] Broken vector index (" << indexFile << ")." << std::endl;
+		std::exit(1);
+	};
+	// A section of count items of size bytes, 8-byte aligned, inside the file
+	auto in_file = [&](const u_int64_t offset, const u_int64_t count, const u_int64_t size)
+	{
+		return offset % 8 == 0 && offset <= this->length && count <= (this->length - offset) / size;
+	};
+
+	// Sizes before the shifts, then the sections (ids are u32, NOT_FOUND is not an id)
+	if (header.kmer == 0 || header.kmer > MerCode::MAX_KMER || header.slotBits < 4 ||
+		header.slotBits > MAX_SLOT_BITS || header.number >= MerIndex::NOT_FOUND ||
+		header.number >= ((u_int64_t)1 << header.slotBits))
+	{
+		broken();
+	}
+	const u_int64_t slotCount = (u_int64_t)1 << header.slotBits;
+	const u_int64_t filterBytes = ((u_int64_t)1 << (header.slotBits + 2)) / 8;
+	if (header.recordOffset > header.codeOffset || !in_file(header.recordOffset, 0, 1) ||
+		!in_file(header.codeOffset, header.number, sizeof(u_int64_t)) ||
+		!in_file(header.slotOffset, slotCount, sizeof(u_int32_t)) ||
+		!in_file(header.filterOffset, filterBytes, 1) || !in_file(header.positionOffset, 0, 1))
+	{
+		broken();
+	}
+	this->kmer = header.kmer;
+	this->number = header.number;
+	this->slotBits = header.slotBits;
+	this->codes = reinterpret_cast<const u_int64_t *>(this->map + header.codeOffset);
+	this->slots = reinterpret_cast<const u_int32_t *>(this->map + header.slotOffset);
+	this->filter = reinterpret_cast<const u_int64_t *>(this->map + header.filterOffset);
+	this->positions = reinterpret_cast<const PositionIds::Pair *>(this->map + header.positionOffset);
+
+	// Records
+	const char *p = this->map + header.recordOffset;
+	const char *recordEnd = this->map + header.codeOffset;
+	for (u_int64_t i = 0; i < header.records; i++)
+	{
+		u_int64_t lengths[2];
+		if ((u_int64_t)(recordEnd - p) < sizeof(lengths))
+		{
+			broken();
+		}
+		memcpy(lengths, p, sizeof(lengths));
+		p += sizeof(lengths);
+		if (lengths[0] > (u_int64_t)(recordEnd - p) || lengths[1] > (u_int64_t)(recordEnd - p) - lengths[0])
+		{
+			broken();
+		}
+		this->records.push_back(std::make_pair(std::string(p, lengths[0]),
+											   std::string(p + lengths[0], lengths[1])));
+		p += std::min((lengths[0] + lengths[1] + 7) / 8 * 8, (u_int64_t)(recordEnd - p));
+	}
+
+	// Slots hold an id + 1 (0: empty); a lookup stops at an empty slot.
+	u_int64_t emptySlots = 0;
+	for (u_int64_t slot = 0; slot < slotCount; slot++)
+	{
+		if (this->slots[slot] > this->number)
+		{
+			broken();
+		}
+		emptySlots += this->slots[slot] == 0;
+	}
+	if (emptySlots == 0)
+	{
+		broken();
+	}
+
+	// Positions of the records of at least k bases: ids of the index or NOT_FOUND
+	u_int64_t positionCount = 0;
+	for (auto itr = this->records.begin(); itr != this->records.end(); ++itr)
+	{
+		positionCount += itr->second.length() >= this->kmer ? itr->second.length() : 0;
+	}
+	if (!in_file(header.positionOffset, positionCount, sizeof(PositionIds::Pair)))
+	{
+		broken();
+	}
+	for (u_int64_t i = 0; i < positionCount; i++)
+	{
+		const PositionIds::Pair &pair = this->positions[i];
+		if ((pair.first >= this->number && pair.first != MerIndex::NOT_FOUND) ||
+			(pair.second >= this->number && pair.second != MerIndex::NOT_FOUND))
+		{
+			broken();
+		}
+	}
+}
+
+/**
+ * @brief Destroy the Vector Index:: Vector Index object
+ *
+ */
+VectorIndex::~VectorIndex()
+{
+	munmap(const_cast<char *>(this->map), this->length);
+}
+
+/**
+ * @brief Whether a file is a vector index file.
+ *
+ * @param file File
+ * @return true if the file starts with the magic number (of any version)
+ */
+bool VectorIndex::is_index(const std::string &file)
+{
+	char magic[sizeof(INDEX_MAGIC)];
+	std::ifstream ifs(file.c_str(), std::ios::binary);
+	return ifs.read(magic, sizeof(magic)) && memcmp(magic, INDEX_MAGIC, INDEX_PREFIX) == 0;
+}
+
+/**
+ * @brief Write an index file.
+ *
+ * @param indexFile Index file
+ * @param records Name and sequence of each vector
+ * @param merIndex K-mer index of the vectors
+ * @param kmer K-mer
+ * @param posIds Ids of the k-mers at each position of the records of at least k bases
+ */
+void VectorIndex::write(const std::string &indexFile,
+						const std::vector<std::pair<std::string, std::string>> &records,
+						const MerIndex &merIndex, const unsigned int kmer,
+						const std::vector<PositionIds> &posIds)
+{
+	const std::string tmpFile = indexFile + ".tmp";
+	FILE *file = fopen(tmpFile.c_str(), "wb");
+	if (!file)
+	{
+		std::cerr << "[Error] Could not open (" << tmpFile << ")." << std::endl;
+		std::exit(1);
+	}
+	bool ok = true;
+	u_int64_t offset = 0;
+	auto write = [&](const void *data, const u_int64_t bytes)
+	{
+		ok = ok && (bytes == 0 || fwrite(data, 1, bytes, file) == bytes);
+		offset += bytes;
+	};
+	auto align = [&]()
+	{
+		static const char zero[8] = {0};
+		write(zero, (8 - offset % 8) % 8);
+	};
+
+	IndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = INDEX_VERSION;
+	header.kmer = kmer;
+	header.layout = MerIndex::LAYOUT;
+	header.slotBits = merIndex.get_slotBits();
+	header.number = merIndex.size();
+	header.records = records.size();
+	write(&header, sizeof(header));
+
+	header.recordOffset = offset;
+	for (auto itr = records.begin(); itr != records.end(); ++itr)
+	{
+		const u_int64_t lengths[2] = {itr->first.length(), itr->second.length()};
+		write(lengths, sizeof(lengths));
+		write(itr->first.data(), itr->first.length());
+		write(itr->second.data(), itr->second.length());
+		align();
+	}
+
+	header.codeOffset = offset;
+	write(merIndex.get_codes(), merIndex.size() * sizeof(u_int64_t));
+	align();
+	header.slotOffset = offset;
+	write(merIndex.get_slots(), ((u_int64_t)1 << header.slotBits) * sizeof(u_int32_t));
+	align();
+	header.filterOffset = offset;
+	write(merIndex.get_filter(), ((u_int64_t)1 << (header.slotBits + 2)) / 8);
+	align();
+	header.positionOffset = offset;
+	for (auto itr = posIds.begin(); itr != posIds.end(); ++itr)
+	{
+		write(itr->begin(), itr->size() * sizeof(PositionIds::Pair));
+	}
+
+	// Offsets in the header
+	ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	if (fclose(file) != 0 || !ok || std::rename(tmpFile.c_str(), indexFile.c_str()) != 0)
+	{
+		std::cerr << "[Error] Could not write (" << indexFile << ")." << std::endl;
+		std::exit(1);
+	}
+}
+
+/**
+ * @brief Use the mapped arrays in a k-mer index.
+ *
+ * @param merIndex K-mer index
+ */
+void VectorIndex::attach(MerIndex &merIndex) const
+{
+	merIndex.attach(this->kmer, this->number, this->codes, this->slotBits, this->slots, this->filter);
+}
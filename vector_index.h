@@ -0,0 +1,136 @@
+/*
+ * GenEditScan
+ * Copyright 2018 National Agriculture and Food Research Organization (NARO)
+ */
+#ifndef VECTOR_INDEX_H_
+#define VECTOR_INDEX_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "mer_index.h"
+
+/**
+ * @brief Prebuilt vector index file (.gidx), memory mapped read only.
+ *
+ * Holds the vector records, the arrays of the k-mer index and the ids of
+ * the k-mers at each vector position, so that runs with the same vector
+ * skip the hashing and the lookup of the vector k-mers and concurrent jobs
+ * on a node share the pages of the index.
+ *
+ * Layout (little endian, sections 8-byte aligned, see README.md):
+ *   header : magic "GESIDX02", u32 version, u32 k, u32 index layout,
+ *            u32 slot bits, u64 k-mers, u64 records, u64 offsets of the
+ *            records, codes, slots, filter and positions
+ *   records: per record {u64 name length, u64 sequence length, name, sequence}
+ *   codes  : u64 code of each k-mer id
+ *   slots  : u32 hash table (2^slot bits)
+ *   filter : u64 filter words (2^(slot bits + 2) bits)
+ *   positions: u32 id of the k-mer and of its complementary k-mer at each
+ *            position of each record of at least k bases, in record order
+ */
+class VectorIndex
+{
+public:
+	/**
+	 * @brief Construct a new Vector Index object (map an index file)
+	 *
+	 * @param indexFile Index file
+	 */
+	VectorIndex(const std::string &indexFile);
+
+	/**
+	 * @brief Destroy the Vector Index object
+	 *
+	 */
+	virtual ~VectorIndex();
+
+	/**
+	 * @brief Whether a file is a vector index file.
+	 *
+	 * @param file File
+	 * @return true if the file starts with the magic number (of any version)
+	 */
+	static bool is_index(const std::string &file);
+
+	/**
+	 * @brief Write an index file.
+	 *
+	 * @param indexFile Index file
+	 * @param records Name and sequence of each vector
+	 * @param merIndex K-mer index of the vectors
+	 * @param kmer K-mer
+	 * @param posIds Ids of the k-mers at each position of the records of at least k bases
+	 */
+	static void write(const std::string &indexFile,
+					  const std::vector<std::pair<std::string, std::string>> &records,
+					  const MerIndex &merIndex, const unsigned int kmer,
+					  const std::vector<PositionIds> &posIds);
+
+	/**
+	 * @brief Use the mapped arrays in a k-mer index.
+	 *
+	 * @param merIndex K-mer index
+	 */
+	void attach(MerIndex &merIndex) const;
+
+	// Getter
+
+	unsigned int get_kmer() const
+	{
+		return this->kmer;
+	}
+
+	const std::vector<std::pair<std::string, std::string>> &get_records() const
+	{
+		return this->records;
+	}
+
+	const PositionIds::Pair *get_positions() const
+	{
+		return this->positions;
+	}
+
+private:
+	/**
+	 * @brief Index file
+	 *
+	 */
+	std::string indexFile;
+
+	/**
+	 * @brief Mapped file
+	 *
+	 */
+	const char *map;
+	size_t length;
+
+	/**
+	 * @brief K-mer, number of k-mers and slot bits
+	 *
+	 */
+	unsigned int kmer;
+	u_int64_t number;
+	unsigned int slotBits;
+
+	/**
+	 * @brief Arrays of the k-mer index (in the mapped file)
+	 *
+	 */
+	const u_int64_t *codes;
+	const u_int32_t *slots;
+	const u_int64_t *filter;
+
+	/**
+	 * @brief Ids of the k-mers at each vector position (in the mapped file)
+	 *
+	 */
+	const PositionIds::Pair *positions;
+
+	/**
+	 * @brief Name and sequence of each vector
+	 *
+	 */
+	std::vector<std::pair<std::string, std::string>> records;
+};
+#endif /* VECTOR_INDEX_H_ */
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include "vector_sequence.h"
 #include "complementary.h"
+#include "mer_code.h"
 
 /**
  * @brief Construct a new Vector Sequence:: Vector Sequence object
@@ -30,14 +31,104 @@ VectorSequence::~VectorSequence()
 /**
  * @brief Read the fasta file.
  *
- * @param merCounter Counter of each mer
- * @param posPair Position and k-mer complementary pair on vector
- * @return Vector sequence
+ * All records share the k-mer index of bitwiseOperation (created here if
+ * it is empty), so that the reads are scanned once for all vectors and
+ * the mers are counted in arrays indexed by the ids. Records shorter than
+ * k-mer are skipped. With a vector index file, the ids of the positions
+ * are used in place in the file.
+ *
+ * @param posIds Ids of the k-mer and its complementary k-mer at each position of each vector
+ *               (MerIndex::NOT_FOUND for a k-mer with a base other than ACGT)
+ * @param otherMers K-mers with a base other than ACGT (never counted)
+ * @return Vector sequences
  */
-std::string VectorSequence::read_vectorFile(
-	std::unordered_map<std::string, unsigned int> &merCounter,
-	std::unordered_map<unsigned int, std::pair<std::string, std::string>> &posPair) const
+std::vector<std::string> VectorSequence::read_vectorFile(
+	std::vector<PositionIds> &posIds,
+	std::set<std::string> &otherMers) const
 {
+	Metrics::Stopwatch load;
+	Trace::Span span(this->options->trace, "vector_load", this->options->vector_file);
+	const std::vector<std::pair<std::string, std::string>> records = this->read_sequences();
+
+	// Create the k-mer index (or use the one in the vector index file).
+	const VectorIndex *vectorIndex = this->bitwiseOperation->get_vectorIndex();
+	MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
+	const bool create = merIndex->size() == 0;
+	if (create)
+	{
+		if (vectorIndex)
+		{
+			vectorIndex->attach(*merIndex);
+		}
+		else
+		{
+			this->create_merIndex(records, this->options->kmer);
+		}
+		this->bitwiseOperation->replicate_merIndexes();
+	}
+
+	// Ids of the positions in the vector index file
+	const PositionIds::Pair *positions = vectorIndex ? vectorIndex->get_positions() : nullptr;
+	std::vector<std::string> sequences;
+	posIds.clear();
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		std::string sequence = records[i].second;
+		if (sequence.length() < this->options->kmer)
+		{
+			// Told once, when the index is created
+			if (create)
+			{
+				std::cerr << "[Warning] Vector " << records[i].first << " is shorter than k-mer ("
+						  << this->options->kmer << "); it is skipped." << std::endl;
+			}
+			continue;
+		}
+
+		// Circular vector: the last k-mers run into the start.
+		const size_t vector_length = sequence.length();
+		sequence += sequence.substr(0, this->options->kmer - 1);
+		// Convert to upper case
+		transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
+
+		// Set the ids of the k-mers.
+		posIds.emplace_back();
+		if (positions)
+		{
+			posIds.back().attach(positions, vector_length);
+			positions += vector_length;
+			this->set_otherMers(sequence, posIds.back(), otherMers);
+		}
+		else
+		{
+			this->set_posIds(sequence, posIds.back(), otherMers);
+		}
+		sequences.push_back(sequence);
+	}
+	if (sequences.empty())
+	{
+		std::cerr << "[Error] Vector is shorter than k-mer." << std::endl;
+		std::exit(1);
+	}
+
+	Metrics::Counters counters;
+	counters.bytes_in = Metrics::file_size(this->options->vector_file);
+	this->options->metrics.add("vector_load", this->options->vector_file, load.stop(counters));
+	return sequences;
+}
+
+/**
+ * @brief Read the records of the fasta file (or the vector index file).
+ *
+ * @return Name (first word of the header line) and sequence of each record
+ */
+std::vector<std::pair<std::string, std::string>> VectorSequence::read_sequences() const
+{
+	if (this->bitwiseOperation->get_vectorIndex())
+	{
+		return this->bitwiseOperation->get_vectorIndex()->get_records();
+	}
+
 	std::ifstream ifs(this->options->vector_file.c_str());
 	if (!ifs)
 	{
@@ -46,107 +137,197 @@ std::string VectorSequence::read_vectorFile(
 		std::exit(1);
 	}
 
-	std::string sequence;
+	std::vector<std::pair<std::string, std::string>> records;
 	std::string str;
 
 	while (getline(ifs, str))
 	{
-		if (str[0] == '>')
+		// Delete line breaks
+		if (str.length() > 0 && str[str.length() - 1] == '\r')
+		{
+			str.pop_back();
+		}
+		if (str.length() > 0 && str[0] == '>')
 		{
-			if (sequence.length() > 0)
+			std::string name = str.substr(1, str.find_first_of(" \t") - 1);
+			if (name.length() == 0)
 			{
-				break;
+				name = "vector" + std::to_string(records.size() + 1);
 			}
+			records.push_back(std::make_pair(name, ""));
 		}
 		else
 		{
-			// Delete line breaks
-			if (str[str.length() - 1] == '\n')
+			if (records.empty())
 			{
-				str.pop_back();
+				records.push_back(std::make_pair("vector1", ""));
 			}
-			if (str[str.length() - 1] == '\r')
+			records.back().second += str;
+		}
+	}
+
+	// Records without bases are ignored.
+	records.erase(std::remove_if(records.begin(), records.end(),
+								 [](const std::pair<std::string, std::string> &record)
+								 { return record.second.empty(); }),
+				  records.end());
+	if (records.empty())
+	{
+		std::cerr << "[Error] No sequence in vector file(" << this->options->vector_file << ")." << std::endl;
+		std::exit(1);
+	}
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		for (size_t j = 0; j < i; j++)
+		{
+			if (records[i].first == records[j].first)
 			{
-				str.pop_back();
+				std::cerr << "[Error] Duplicate vector name (" << records[i].first << ")." << std::endl;
+				std::exit(1);
 			}
-			sequence += str;
 		}
 	}
-	// Set k-mer in hash table.
-	this->set_merCounter(sequence, merCounter, posPair);
+	return records;
+}
+
+/**
+ * @brief Create the k-mer index of each k of the run (-k 16,20,...).
+ *
+ */
+void VectorSequence::create_merIndexes() const
+{
+	Metrics::Stopwatch load;
+	Trace::Span span(this->options->trace, "vector_load", this->options->vector_file);
+	Metrics::Counters counters;
+	counters.bytes_in = Metrics::file_size(this->options->vector_file);
+
+	const VectorIndex *vectorIndex = this->bitwiseOperation->get_vectorIndex();
+	if (vectorIndex)
+	{
+		vectorIndex->attach(*this->bitwiseOperation->get_merIndex(vectorIndex->get_kmer()));
+		this->bitwiseOperation->replicate_merIndexes();
+		this->options->metrics.add("vector_load", this->options->vector_file, load.stop(counters));
+		return;
+	}
 
-	// Create chunk array.
-	this->create_chunk(merCounter);
-	return sequence;
+	const std::vector<std::pair<std::string, std::string>> records = this->read_sequences();
+	for (auto itr = this->options->kmers.begin(); itr != this->options->kmers.end(); ++itr)
+	{
+		size_t skipped = 0;
+		for (auto itr_record = records.begin(); itr_record != records.end(); ++itr_record)
+		{
+			if (itr_record->second.length() < *itr)
+			{
+				std::cerr << "[Warning] Vector " << itr_record->first << " is shorter than k-mer ("
+						  << *itr << "); it is skipped." << std::endl;
+				skipped++;
+			}
+		}
+		if (skipped == records.size())
+		{
+			std::cerr << "[Error] Vector is shorter than k-mer." << std::endl;
+			std::exit(1);
+		}
+		this->create_merIndex(records, *itr);
+	}
+	this->bitwiseOperation->replicate_merIndexes();
+	this->options->metrics.add("vector_load", this->options->vector_file, load.stop(counters));
 }
 
 //============================================================================//
 // Private function
 //============================================================================//
 /**
- * @brief Set k-mer in hash table.
+ * @brief Set the ids of the k-mers of a vector.
  *
- * @param sequence Vector sequence
- * @param merCounter Counter of each mer
- * @param posPair Position and k-mer complementary pair on vector
+ * @param sequence Vector sequence (circular, upper case)
+ * @param posId Ids of the k-mer and its complementary k-mer at each position
+ * @param otherMers K-mers with a base other than ACGT
  */
-void VectorSequence::set_merCounter(
-	std::string &sequence,
-	std::unordered_map<std::string, unsigned int> &merCounter,
-	std::unordered_map<unsigned int, std::pair<std::string, std::string>> &posPair) const
+void VectorSequence::set_posIds(
+	const std::string &sequence, PositionIds &posId,
+	std::set<std::string> &otherMers) const
 {
 	Complementary complementary;
+	const MerIndex *merIndex = this->bitwiseOperation->get_merIndex();
 	const unsigned int kmer = this->options->kmer;
-	const unsigned int vector_length = sequence.length();
+	const unsigned int vector_length = sequence.length() - (kmer - 1);
 
-	if (vector_length >= kmer)
+	std::vector<PositionIds::Pair> ids(vector_length);
+	for (unsigned int i = 0; i < vector_length; i++)
 	{
-		sequence += sequence.substr(0, kmer - 1);
-		// Convert to upper case
-		transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
-		for (unsigned int i = 0; i < vector_length; i++)
+		const std::string mer = sequence.substr(i, kmer);
+		// Obtain the complementary sequence of k-mer.
+		const std::string revMer = complementary.mer(mer);
+		u_int64_t code, revCode;
+		if (MerCode::encode(mer, code) && MerCode::encode(revMer, revCode))
 		{
-			std::string mer = sequence.substr(i, kmer);
-			// Obtain the complementary sequence of k-mer.
-			std::string revMer = complementary.mer(mer);
-			merCounter[mer] = 0;
-			merCounter[revMer] = 0;
-			posPair[i] = std::make_pair(mer, revMer);
+			ids[i] = std::make_pair(merIndex->find(code), merIndex->find(revCode));
+		}
+		else
+		{
+			ids[i] = std::make_pair(MerIndex::NOT_FOUND, MerIndex::NOT_FOUND);
+			otherMers.insert(mer);
+			otherMers.insert(revMer);
 		}
 	}
-	else
-	{
-		std::cerr << "[Error] Vector is shorter than k-mer.\n";
-		std::exit(1);
-	}
+	posId.hold(ids);
 }
 
 /**
- * @brief Create chunk array.
+ * @brief Take the k-mers with a base other than ACGT of a vector whose ids are set.
  *
- * @param merCounter Counter of each mer
+ * @param sequence Vector sequence (circular, upper case)
+ * @param posId Ids of the k-mer and its complementary k-mer at each position
+ * @param otherMers K-mers with a base other than ACGT
  */
-void VectorSequence::create_chunk(
-	const std::unordered_map<std::string, unsigned int> &merCounter) const
+void VectorSequence::set_otherMers(
+	const std::string &sequence, const PositionIds &posId, std::set<std::string> &otherMers) const
 {
-	unsigned char *dna2bit = this->bitwiseOperation->get_dna2bit();
-	unsigned char *chunk = this->bitwiseOperation->get_chunk();
-
-	for (unsigned i = 0; i < this->options->max_chunk_array; i++)
+	Complementary complementary;
+	const unsigned int kmer = this->options->kmer;
+	for (size_t i = 0; i < posId.size(); i++)
 	{
-		chunk[i] = 0;
+		if (posId[i].first == MerIndex::NOT_FOUND)
+		{
+			const std::string mer = sequence.substr(i, kmer);
+			otherMers.insert(mer);
+			otherMers.insert(complementary.mer(mer));
+		}
 	}
+}
 
-	for (auto itr = merCounter.begin(); itr != merCounter.end(); ++itr)
+/**
+ * @brief Create the k-mer index of a k.
+ *
+ * The ids are given in the order of the positions (k-mer, then its
+ * complementary k-mer); records shorter than k-mer are skipped.
+ *
+ * @param records Records of the vector file
+ * @param kmer K-mer
+ */
+void VectorSequence::create_merIndex(const std::vector<std::pair<std::string, std::string>> &records,
+									 const unsigned int kmer) const
+{
+	Complementary complementary;
+	MerIndex *merIndex = this->bitwiseOperation->get_merIndex(kmer);
+	merIndex->clear(kmer);
+	for (auto itr = records.begin(); itr != records.end(); ++itr)
 	{
-		unsigned int dnabit = dna2bit[(unsigned char)itr->first[0]];
-		for (unsigned int i = 1; i < this->options->chunk_length; i++)
+		std::string sequence = itr->second;
+		const unsigned int vector_length = sequence.length();
+		if (vector_length < kmer)
 		{
-			dnabit = (dnabit << 2) + dna2bit[(unsigned char)itr->first[i]];
+			continue;
 		}
-		if (dnabit != this->options->max_chunk_array)
+		// Circular vector: the last k-mers run into the start.
+		sequence += sequence.substr(0, kmer - 1);
+		transform(sequence.begin(), sequence.end(), sequence.begin(), ::toupper);
+		for (unsigned int i = 0; i < vector_length; i++)
 		{
-			chunk[dnabit] = 1;
+			const std::string mer = sequence.substr(i, kmer);
+			merIndex->add(mer);
+			merIndex->add(complementary.mer(mer));
 		}
 	}
 }
@@ -5,8 +5,9 @@
 #ifndef VECTOR_SEQUENCE_H_
 #define VECTOR_SEQUENCE_H_
 
+#include <set>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "bitwise_operation.h"
 
 /**
@@ -32,13 +33,33 @@ public:
 	/**
 	 * @brief Read the fasta file.
 	 *
-	 * @param merCounter Counter of each mer
-	 * @param posPair Position and k-mer complementary pair on vector
-	 * @return Vector sequence
+	 * All records share the k-mer index of bitwiseOperation (created here if
+	 * it is empty), so that the reads are scanned once for all vectors and
+	 * the mers are counted in arrays indexed by the ids. Records shorter than
+	 * k-mer are skipped. With a vector index file, the ids of the positions
+	 * are used in place in the file.
+	 *
+	 * @param posIds Ids of the k-mer and its complementary k-mer at each position of each vector
+	 *               (MerIndex::NOT_FOUND for a k-mer with a base other than ACGT)
+	 * @param otherMers K-mers with a base other than ACGT (never counted)
+	 * @return Vector sequences
 	 */
-	std::string read_vectorFile(
-		std::unordered_map<std::string, unsigned int> &merCounter,
-		std::unordered_map<unsigned int, std::pair<std::string, std::string>> &posPair) const;
+	std::vector<std::string> read_vectorFile(
+		std::vector<PositionIds> &posIds,
+		std::set<std::string> &otherMers) const;
+
+	/**
+	 * @brief Read the records of the fasta file (or the vector index file).
+	 *
+	 * @return Name (first word of the header line) and sequence of each record
+	 */
+	std::vector<std::pair<std::string, std::string>> read_sequences() const;
+
+	/**
+	 * @brief Create the k-mer index of each k of the run (-k 16,20,...).
+	 *
+	 */
+	void create_merIndexes() const;
 
 private:
 	/**
@@ -54,21 +75,33 @@ private:
 	BitwiseOperation *bitwiseOperation;
 
 	/**
-	 * @brief Set k-mer in hash table.
+	 * @brief Set the ids of the k-mers of a vector.
+	 *
+	 * @param sequence Vector sequence (circular, upper case)
+	 * @param posId Ids of the k-mer and its complementary k-mer at each position
+	 * @param otherMers K-mers with a base other than ACGT
+	 */
+	void set_posIds(
+		const std::string &sequence, PositionIds &posId,
+		std::set<std::string> &otherMers) const;
+
+	/**
+	 * @brief Take the k-mers with a base other than ACGT of a vector whose ids are set.
 	 *
-	 * @param sequence Vector sequence
-	 * @param merCounter Counter of each mer
-	 * @param posPair Position and k-mer complementary pair on vector
+	 * @param sequence Vector sequence (circular, upper case)
+	 * @param posId Ids of the k-mer and its complementary k-mer at each position
+	 * @param otherMers K-mers with a base other than ACGT
 	 */
-	void set_merCounter(
-		std::string &sequence, std::unordered_map<std::string, unsigned int> &merCounter,
-		std::unordered_map<unsigned int, std::pair<std::string, std::string>> &posPair) const;
+	void set_otherMers(
+		const std::string &sequence, const PositionIds &posId, std::set<std::string> &otherMers) const;
 
 	/**
-	 * @brief Create chunk array.
+	 * @brief Create the k-mer index of a k.
 	 *
-	 * @param merCounter Counter of each mer
+	 * @param records Records of the vector file
+	 * @param kmer K-mer
 	 */
-	void create_chunk(const std::unordered_map<std::string, unsigned int> &merCounter) const;
+	void create_merIndex(const std::vector<std::pair<std::string, std::string>> &records,
+						 const unsigned int kmer) const;
 };
 #endif /* VECTOR_SEQUENCE_H_ */